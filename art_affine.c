@@ -52,6 +52,65 @@ art_affine_point (ArtPoint *dst, const ArtPoint *src,
   dst->y = x * affine[1] + y * affine[3] + affine[5];
 }
 
+/**
+ * art_affine_points: Do an affine transformation of an array of points.
+ * @dst: Where the result points are stored.
+ * @src: The original points.
+ * @n_points: Number of points.
+ * @affine: The affine transformation.
+ *
+ * Transforms @n_points points at once; @dst may be @src. The loop is
+ * simple enough for the compiler to vectorize.
+ **/
+void
+art_affine_points (ArtPoint *dst, const ArtPoint *src, int n_points,
+		   const double affine[6])
+{
+  double a = affine[0], b = affine[1], c = affine[2];
+  double d = affine[3], e = affine[4], f = affine[5];
+  double x, y;
+  int i;
+
+  for (i = 0; i < n_points; i++)
+    {
+      x = src[i].x;
+      y = src[i].y;
+      dst[i].x = x * a + y * c + e;
+      dst[i].y = x * b + y * d + f;
+    }
+}
+
+/**
+ * art_affine_points_float: Do an affine transformation of float points.
+ * @dst: Where the result coordinates are stored.
+ * @src: The original coordinates.
+ * @n_points: Number of points.
+ * @affine: The affine transformation.
+ *
+ * Like art_affine_points(), for points stored as pairs of floats, x
+ * first. The arithmetic is done in single precision too, which halves
+ * the memory traffic and doubles the vector width for large point
+ * sets. This is enough for device coordinates: around 100000, the
+ * rounding errors are still below 1/100 of a pixel.
+ **/
+void
+art_affine_points_float (float *dst, const float *src, int n_points,
+			 const double affine[6])
+{
+  float a = affine[0], b = affine[1], c = affine[2];
+  float d = affine[3], e = affine[4], f = affine[5];
+  float x, y;
+  int i;
+
+  for (i = 0; i < n_points; i++)
+    {
+      x = src[2 * i];
+      y = src[2 * i + 1];
+      dst[2 * i] = x * a + y * c + e;
+      dst[2 * i + 1] = x * b + y * d + f;
+    }
+}
+
 /**
  * art_affine_invert: Find the inverse of an affine transformation.
  * @dst: Where the resulting affine is stored.
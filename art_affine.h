@@ -34,6 +34,14 @@ void
 art_affine_point (ArtPoint *dst, const ArtPoint *src,
 		  const double affine[6]);
 
+void
+art_affine_points (ArtPoint *dst, const ArtPoint *src, int n_points,
+		   const double affine[6]);
+
+void
+art_affine_points_float (float *dst, const float *src, int n_points,
+			 const double affine[6]);
+
 void
 art_affine_invert (double dst_affine[6], const double src_affine[6]);
 
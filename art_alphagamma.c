@@ -83,3 +83,50 @@ art_alphagamma_free (ArtAlphaGamma *alphagamma)
 {
   art_free (alphagamma);
 }
+
+/**
+ * art_alphagamma_rgbtab: Build a gamma-correct blend table.
+ * @alphagamma: An #ArtAlphaGamma.
+ * @fg_color: Foreground color, as 0xRRGGBB.
+ * @bg_color: Background color, as 0xRRGGBB.
+ * @rgbtab: Where to store the 256 blended colors.
+ *
+ * Stores in @rgbtab[i] the color covering a pixel of @bg_color to the
+ * fraction i / 255 with @fg_color, with the blending done in linear
+ * intensity space according to @alphagamma. This is the table the
+ * antialiased renderers look up edge pixels in.
+ **/
+void
+art_alphagamma_rgbtab (const ArtAlphaGamma *alphagamma,
+		       art_u32 fg_color, art_u32 bg_color, art_u32 *rgbtab)
+{
+  const int *table = alphagamma->table;
+  const art_u8 *invtab = alphagamma->invtable;
+  int fg[3], bg[3];
+  int i, j;
+
+  for (j = 0; j < 3; j++)
+    {
+      fg[j] = table[(fg_color >> (16 - 8 * j)) & 0xff];
+      bg[j] = table[(bg_color >> (16 - 8 * j)) & 0xff];
+    }
+  /* the difference of two table entries times 255 overflows an int
+     for invtable sizes beyond 23 bits, so it is scaled in double,
+     where it is exact */
+  for (i = 0; i < 256; i++)
+    {
+      art_u32 rgb = 0;
+      int d;
+
+      for (j = 0; j < 3; j++)
+	{
+	  d = fg[j] - bg[j];
+	  if (d >= 0)
+	    d = (int)(((double)d * i + 127) / 255);
+	  else
+	    d = -(int)(((double)-d * i + 127) / 255);
+	  rgb = (rgb << 8) | invtab[bg[j] + d];
+	}
+      rgbtab[i] = rgb;
+    }
+}
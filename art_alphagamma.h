@@ -48,6 +48,10 @@ art_alphagamma_new (double gamma);
 void
 art_alphagamma_free (ArtAlphaGamma *alphagamma);
 
+void
+art_alphagamma_rgbtab (const ArtAlphaGamma *alphagamma,
+		       art_u32 fg_color, art_u32 bg_color, art_u32 *rgbtab);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -41,52 +41,71 @@
 ArtBpath *
 art_bpath_affine_transform (const ArtBpath *src, const double matrix[6])
 {
-  int i;
   int size;
   ArtBpath *new;
-  ArtPathcode code;
-  double x, y;
 
-  for (i = 0; src[i].code != ART_END; i++);
-  size = i;
+  for (size = 0; src[size].code != ART_END; size++);
 
   new = art_new (ArtBpath, size + 1);
+  art_bpath_affine_transform_buf (new, src, matrix);
+
+  return new;
+}
+
+/**
+ * art_bpath_affine_transform_buf: Affine transform an #ArtBpath into a buffer.
+ * @dst: Where to store the result.
+ * @src: The source #ArtBpath.
+ * @matrix: The affine transform.
+ *
+ * Like art_bpath_affine_transform(), but stores the result in @dst,
+ * which must have room for as many elements as @src, including the
+ * final %ART_END. @dst may be @src, to transform a bezpath in place.
+ **/
+void
+art_bpath_affine_transform_buf (ArtBpath *dst, const ArtBpath *src,
+				const double matrix[6])
+{
+  /* locals, so the compiler knows stores to @dst don't change them */
+  double a = matrix[0], b = matrix[1], c = matrix[2];
+  double d = matrix[3], e = matrix[4], f = matrix[5];
+  ArtPathcode code;
+  double x, y;
+  int i;
 
-  for (i = 0; i < size; i++)
+  for (i = 0; src[i].code != ART_END; i++)
     {
       code = src[i].code;
-      new[i].code = code;
+      dst[i].code = code;
       if (code == ART_CURVETO)
 	{
 	  x = src[i].x1;
 	  y = src[i].y1;
-	  new[i].x1 = matrix[0] * x + matrix[2] * y + matrix[4];
-	  new[i].y1 = matrix[1] * x + matrix[3] * y + matrix[5];
+	  dst[i].x1 = a * x + c * y + e;
+	  dst[i].y1 = b * x + d * y + f;
 	  x = src[i].x2;
 	  y = src[i].y2;
-	  new[i].x2 = matrix[0] * x + matrix[2] * y + matrix[4];
-	  new[i].y2 = matrix[1] * x + matrix[3] * y + matrix[5];
+	  dst[i].x2 = a * x + c * y + e;
+	  dst[i].y2 = b * x + d * y + f;
 	}
       else
 	{
-	  new[i].x1 = 0;
-	  new[i].y1 = 0;
-	  new[i].x2 = 0;
-	  new[i].y2 = 0;
+	  dst[i].x1 = 0;
+	  dst[i].y1 = 0;
+	  dst[i].x2 = 0;
+	  dst[i].y2 = 0;
 	}
       x = src[i].x3;
       y = src[i].y3;
-      new[i].x3 = matrix[0] * x + matrix[2] * y + matrix[4];
-      new[i].y3 = matrix[1] * x + matrix[3] * y + matrix[5];
+      dst[i].x3 = a * x + c * y + e;
+      dst[i].y3 = b * x + d * y + f;
     }
-  new[i].code = ART_END;
-  new[i].x1 = 0;
-  new[i].y1 = 0;
-  new[i].x2 = 0;
-  new[i].y2 = 0;
-  new[i].x3 = 0;
-  new[i].y3 = 0;
-
-  return new;
+  dst[i].code = ART_END;
+  dst[i].x1 = 0;
+  dst[i].y1 = 0;
+  dst[i].x2 = 0;
+  dst[i].y2 = 0;
+  dst[i].x3 = 0;
+  dst[i].y3 = 0;
 }
 
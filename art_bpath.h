@@ -52,6 +52,10 @@ struct _ArtBpath {
 ArtBpath *
 art_bpath_affine_transform (const ArtBpath *src, const double matrix[6]);
 
+void
+art_bpath_affine_transform_buf (ArtBpath *dst, const ArtBpath *src,
+				const double matrix[6]);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -0,0 +1,622 @@
+/*
+ * art_display_list.c: Retained scenes of filled and stroked paths.
+ *
+ * Libart_LGPL - library of basic graphic primitives
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#include "config.h"
+#include "art_display_list.h"
+
+#include <math.h>
+#include "art_affine.h"
+#include "art_rect.h"
+#include "art_rect_svp.h"
+#include "art_rect_uta.h"
+#include "art_render_list.h"
+#include "art_svp_affine.h"
+#include "art_svp_rle.h"
+#include "art_svp_vpath.h"
+#include "art_vpath_bpath.h"
+
+#ifndef MAX
+#define MAX(a, b)  (((a) > (b)) ? (a) : (b))
+#endif /* MAX */
+
+#ifndef MIN
+#define MIN(a, b)  (((a) < (b)) ? (a) : (b))
+#endif /* MIN */
+
+typedef struct _ArtDisplayListItem ArtDisplayListItem;
+
+struct _ArtDisplayListItem {
+  /* what was recorded */
+  ArtBpath *bpath;
+  ArtDRect path_bbox; /* of the control points */
+  art_boolean stroke;
+  ArtWindRule rule;
+  ArtPathStrokeJoinType join;
+  ArtPathStrokeCapType cap;
+  double line_width;
+  double miter_limit;
+  double affine[6];
+  ArtPixMaxDepth color[ART_MAX_CHAN + 1];
+  int opacity;
+
+  /* what was derived from it: the svp of the path under svp_affine,
+     and its coverage, made when the svp was translated by (rle_tx,
+     rle_ty) */
+  ArtSVP *svp;
+  double svp_affine[6];
+  ArtDRect svp_bbox;
+  ArtSVPRle *rle;
+  double rle_tx, rle_ty;
+
+  /* for the current frame */
+  art_boolean visible;
+  int dx, dy; /* offset of rle */
+};
+
+struct _ArtDisplayList {
+  /* parameters of destination images, as for art_render_new () */
+  int n_chan;
+  int depth;
+  ArtAlphaType alpha_type;
+  ArtAlphaGamma *alphagamma;
+
+  double flatness;
+  int n_items;
+  int n_items_max;
+  ArtDisplayListItem *items;
+  ArtDisplayListStats stats;
+};
+
+/**
+ * art_display_list_new: Create a new display list.
+ * @n_chan: Number of color channels of the destination.
+ * @depth: Depth of each channel (8 or 16).
+ * @alpha_type: Alpha type of the destination.
+ * @alphagamma: #ArtAlphaGamma for antialiasing, or NULL.
+ * @flatness: Flatness for converting the paths to polygons.
+ *
+ * Creates an empty display list, for drawing into destinations of the
+ * given format. Paths are recorded into it with
+ * art_display_list_add_fill() and art_display_list_add_stroke(), and
+ * the whole scene is drawn with art_display_list_render().
+ *
+ * Each item keeps the svp derived from its path and the coverage
+ * rasterized from that svp. When an item is drawn again with the same
+ * transform, neither is made again; when only the translation of its
+ * transform changes, the svp is moved rather than derived again, and
+ * the coverage is reused as it is if the move is by whole pixels. A
+ * static scene is then only composited. Items outside the viewport or
+ * the damaged area are not looked at beyond their bounding box.
+ *
+ * Return value: The new display list.
+ **/
+ArtDisplayList *
+art_display_list_new (int n_chan, int depth, ArtAlphaType alpha_type,
+		      ArtAlphaGamma *alphagamma, double flatness)
+{
+  ArtDisplayList *dl;
+
+  if (n_chan > ART_MAX_CHAN)
+    {
+      art_warn ("art_display_list_new: n_chan = %d, exceeds %d max\n",
+		n_chan, ART_MAX_CHAN);
+      return NULL;
+    }
+
+  dl = art_new (ArtDisplayList, 1);
+  dl->n_chan = n_chan;
+  dl->depth = depth;
+  dl->alpha_type = alpha_type;
+  dl->alphagamma = alphagamma;
+  dl->flatness = flatness;
+  dl->n_items = 0;
+  dl->n_items_max = 16;
+  dl->items = art_new (ArtDisplayListItem, dl->n_items_max);
+  dl->stats.n_drawn = 0;
+  dl->stats.n_culled = 0;
+  dl->stats.n_derived = 0;
+  dl->stats.n_translated = 0;
+  dl->stats.n_rasterized = 0;
+  return dl;
+}
+
+static void
+art_display_list_item_flush (ArtDisplayListItem *item)
+{
+  if (item->rle != NULL)
+    art_svp_rle_free (item->rle);
+  item->rle = NULL;
+  if (item->svp != NULL)
+    art_svp_free (item->svp);
+  item->svp = NULL;
+}
+
+/**
+ * art_display_list_free: Free a display list.
+ * @dl: The display list.
+ *
+ * Frees @dl along with its copies of the paths and everything derived
+ * from them.
+ **/
+void
+art_display_list_free (ArtDisplayList *dl)
+{
+  int i;
+
+  for (i = 0; i < dl->n_items; i++)
+    {
+      art_display_list_item_flush (&dl->items[i]);
+      art_free (dl->items[i].bpath);
+    }
+  art_free (dl->items);
+  art_free (dl);
+}
+
+static ArtDisplayListItem *
+art_display_list_add_item (ArtDisplayList *dl, const ArtBpath *bpath,
+			   const double affine[6],
+			   const ArtPixMaxDepth *color, int opacity)
+{
+  ArtDisplayListItem *item;
+  int n_bpath;
+  int i;
+
+  if (dl->n_items == dl->n_items_max)
+    art_expand (dl->items, ArtDisplayListItem, dl->n_items_max);
+  item = &dl->items[dl->n_items++];
+
+  for (n_bpath = 0; bpath[n_bpath].code != ART_END; n_bpath++);
+  item->bpath = art_new (ArtBpath, n_bpath + 1);
+  item->path_bbox.x0 = item->path_bbox.y0 = 0;
+  item->path_bbox.x1 = item->path_bbox.y1 = 0;
+  for (i = 0; i <= n_bpath; i++)
+    {
+      item->bpath[i] = bpath[i];
+      if (i == n_bpath)
+	break;
+      if (i == 0)
+	{
+	  item->path_bbox.x0 = item->path_bbox.x1 = bpath[i].x3;
+	  item->path_bbox.y0 = item->path_bbox.y1 = bpath[i].y3;
+	}
+      item->path_bbox.x0 = MIN (item->path_bbox.x0, bpath[i].x3);
+      item->path_bbox.y0 = MIN (item->path_bbox.y0, bpath[i].y3);
+      item->path_bbox.x1 = MAX (item->path_bbox.x1, bpath[i].x3);
+      item->path_bbox.y1 = MAX (item->path_bbox.y1, bpath[i].y3);
+      if (bpath[i].code == ART_CURVETO)
+	{
+	  item->path_bbox.x0 = MIN (item->path_bbox.x0,
+				    MIN (bpath[i].x1, bpath[i].x2));
+	  item->path_bbox.y0 = MIN (item->path_bbox.y0,
+				    MIN (bpath[i].y1, bpath[i].y2));
+	  item->path_bbox.x1 = MAX (item->path_bbox.x1,
+				    MAX (bpath[i].x1, bpath[i].x2));
+	  item->path_bbox.y1 = MAX (item->path_bbox.y1,
+				    MAX (bpath[i].y1, bpath[i].y2));
+	}
+    }
+
+  for (i = 0; i < 6; i++)
+    item->affine[i] = affine[i];
+  item->svp = NULL;
+  item->rle = NULL;
+  item->visible = ART_FALSE;
+  art_display_list_set_paint (dl, dl->n_items - 1, color, opacity);
+  return item;
+}
+
+/**
+ * art_display_list_add_fill: Record a filled path.
+ * @dl: The display list.
+ * @bpath: The path.
+ * @rule: Winding rule for the fill.
+ * @affine: Transform from path to device coordinates.
+ * @color: Fill color, as for art_render_image_solid().
+ * @opacity: Opacity in [0..0x10000], as for art_render_mask_solid().
+ *
+ * Adds the fill of @bpath to @dl, over the items recorded before it.
+ * @bpath is copied.
+ *
+ * Return value: Index of the new item.
+ **/
+int
+art_display_list_add_fill (ArtDisplayList *dl, const ArtBpath *bpath,
+			   ArtWindRule rule, const double affine[6],
+			   const ArtPixMaxDepth *color, int opacity)
+{
+  ArtDisplayListItem *item;
+
+  item = art_display_list_add_item (dl, bpath, affine, color, opacity);
+  item->stroke = ART_FALSE;
+  item->rule = rule;
+  return dl->n_items - 1;
+}
+
+/**
+ * art_display_list_add_stroke: Record a stroked path.
+ * @dl: The display list.
+ * @bpath: The path.
+ * @join: Join style.
+ * @cap: Cap style.
+ * @line_width: Width of stroke, in path coordinates.
+ * @miter_limit: Miter limit.
+ * @affine: Transform from path to device coordinates.
+ * @color: Stroke color, as for art_render_image_solid().
+ * @opacity: Opacity in [0..0x10000], as for art_render_mask_solid().
+ *
+ * Adds the stroke of @bpath to @dl, over the items recorded before it.
+ * The path is transformed before it is stroked, with @line_width
+ * scaled by art_affine_expansion() of @affine. @bpath is copied.
+ *
+ * Return value: Index of the new item.
+ **/
+int
+art_display_list_add_stroke (ArtDisplayList *dl, const ArtBpath *bpath,
+			     ArtPathStrokeJoinType join,
+			     ArtPathStrokeCapType cap,
+			     double line_width, double miter_limit,
+			     const double affine[6],
+			     const ArtPixMaxDepth *color, int opacity)
+{
+  ArtDisplayListItem *item;
+
+  item = art_display_list_add_item (dl, bpath, affine, color, opacity);
+  item->stroke = ART_TRUE;
+  item->join = join;
+  item->cap = cap;
+  item->line_width = line_width;
+  item->miter_limit = miter_limit;
+  return dl->n_items - 1;
+}
+
+/**
+ * art_display_list_set_affine: Change the transform of an item.
+ * @dl: The display list.
+ * @item: Index of the item.
+ * @affine: New transform from path to device coordinates.
+ *
+ * Sets the transform @item is drawn with from the next
+ * art_display_list_render() on.
+ **/
+void
+art_display_list_set_affine (ArtDisplayList *dl, int item,
+			     const double affine[6])
+{
+  int i;
+
+  for (i = 0; i < 6; i++)
+    dl->items[item].affine[i] = affine[i];
+}
+
+/**
+ * art_display_list_set_paint: Change the paint of an item.
+ * @dl: The display list.
+ * @item: Index of the item.
+ * @color: New color.
+ * @opacity: New opacity in [0..0x10000].
+ *
+ * Sets the paint @item is drawn with. The paint is applied when
+ * compositing, so changing it keeps the item's geometry.
+ **/
+void
+art_display_list_set_paint (ArtDisplayList *dl, int item,
+			    const ArtPixMaxDepth *color, int opacity)
+{
+  int n_ch = dl->n_chan + (dl->alpha_type != ART_ALPHA_NONE);
+  int i;
+
+  for (i = 0; i < n_ch; i++)
+    dl->items[item].color[i] = color[i];
+  dl->items[item].opacity = opacity;
+}
+
+/* Make the svp of @item under its current transform. */
+static void
+art_display_list_derive (ArtDisplayList *dl, ArtDisplayListItem *item)
+{
+  ArtBpath *bpath;
+  ArtVpath *vpath;
+  ArtSVP *svp;
+  ArtSvpWriter *swr;
+  int i;
+
+  art_display_list_item_flush (item);
+  bpath = art_bpath_affine_transform (item->bpath, item->affine);
+  if (item->stroke)
+    item->svp = art_svp_bpath_stroke (bpath, item->join, item->cap,
+				      item->line_width *
+				      art_affine_expansion (item->affine),
+				      item->miter_limit, dl->flatness);
+  else
+    {
+      vpath = art_bez_path_to_vec (bpath, dl->flatness);
+      svp = art_svp_from_vpath (vpath);
+      swr = art_svp_writer_rewind_new (item->rule);
+      art_svp_intersector (svp, swr);
+      item->svp = art_svp_writer_rewind_reap (swr);
+      art_svp_free (svp);
+      art_free (vpath);
+    }
+  art_free (bpath);
+
+  for (i = 0; i < 6; i++)
+    item->svp_affine[i] = item->affine[i];
+  art_drect_svp (&item->svp_bbox, item->svp);
+  dl->stats.n_derived++;
+}
+
+/* Return true if the transforms differ by no more than a translation. */
+static art_boolean
+art_display_list_same_linear (const double a[6], const double b[6])
+{
+  return a[0] == b[0] && a[1] == b[1] && a[2] == b[2] && a[3] == b[3];
+}
+
+/* The bounding box of @item under its current transform, exact if the
+   svp is up to date and conservative otherwise. */
+static void
+art_display_list_item_bbox (const ArtDisplayListItem *item, ArtDRect *bbox)
+{
+  double pad;
+
+  if (item->svp != NULL &&
+      art_display_list_same_linear (item->affine, item->svp_affine))
+    {
+      bbox->x0 = item->svp_bbox.x0 + item->affine[4] - item->svp_affine[4];
+      bbox->y0 = item->svp_bbox.y0 + item->affine[5] - item->svp_affine[5];
+      bbox->x1 = item->svp_bbox.x1 + item->affine[4] - item->svp_affine[4];
+      bbox->y1 = item->svp_bbox.y1 + item->affine[5] - item->svp_affine[5];
+      return;
+    }
+
+  /* the control points enclose the path; joins and square caps reach
+     out by at most miter_limit and sqrt(2) half widths */
+  art_drect_affine_transform (bbox, &item->path_bbox, item->affine);
+  if (item->stroke)
+    {
+      pad = 0.5 * item->line_width * art_affine_expansion (item->affine) *
+	MAX (item->miter_limit, 1.5);
+      bbox->x0 -= pad;
+      bbox->y0 -= pad;
+      bbox->x1 += pad;
+      bbox->y1 += pad;
+    }
+}
+
+/* Pixels that @bbox can cover, within @clip. */
+static void
+art_display_list_bbox_pixels (ArtIRect *dst, const ArtDRect *bbox,
+			      const ArtIRect *clip)
+{
+  ArtIRect pix;
+
+  pix.x0 = (int)floor (bbox->x0);
+  pix.y0 = (int)floor (bbox->y0);
+  pix.x1 = (int)ceil (bbox->x1) + 1;
+  pix.y1 = (int)ceil (bbox->y1) + 1;
+  art_irect_intersect (dst, &pix, clip);
+}
+
+static art_boolean
+art_display_list_hits (const ArtIRect *r, const ArtIRect *rects, int n_rects)
+{
+  ArtIRect tmp;
+  int i;
+
+  for (i = 0; i < n_rects; i++)
+    {
+      art_irect_intersect (&tmp, r, &rects[i]);
+      if (!art_irect_empty (&tmp))
+	return ART_TRUE;
+    }
+  return ART_FALSE;
+}
+
+/* Bring the geometry of @item up to date for drawing within
+   @viewport, and decide whether it needs to be drawn at all. */
+static void
+art_display_list_update (ArtDisplayList *dl, ArtDisplayListItem *item,
+			 const ArtIRect *viewport,
+			 const ArtIRect *rects, int n_rects)
+{
+  ArtDRect bbox;
+  ArtIRect pix;
+  double move[6];
+  double tx, ty;
+  int ix, iy;
+
+  item->visible = ART_FALSE;
+  if (item->opacity <= 0)
+    return;
+
+  art_display_list_item_bbox (item, &bbox);
+  art_display_list_bbox_pixels (&pix, &bbox, viewport);
+  if (art_irect_empty (&pix) || !art_display_list_hits (&pix, rects, n_rects))
+    {
+      dl->stats.n_culled++;
+      return;
+    }
+
+  if (item->svp == NULL ||
+      !art_display_list_same_linear (item->affine, item->svp_affine))
+    {
+      art_display_list_derive (dl, item);
+      art_display_list_item_bbox (item, &bbox);
+      art_display_list_bbox_pixels (&pix, &bbox, viewport);
+      if (art_irect_empty (&pix) ||
+	  !art_display_list_hits (&pix, rects, n_rects))
+	{
+	  dl->stats.n_culled++;
+	  return;
+	}
+    }
+
+  /* reuse the coverage if it has moved by whole pixels and still
+     covers the part of the item in the viewport */
+  tx = item->affine[4] - item->rle_tx;
+  ty = item->affine[5] - item->rle_ty;
+  ix = (int)floor (tx + 0.5);
+  iy = (int)floor (ty + 0.5);
+  if (item->rle == NULL ||
+      fabs (tx - ix) > 1e-6 || fabs (ty - iy) > 1e-6 ||
+      item->rle->x0 + ix > pix.x0 || item->rle->y0 + iy > pix.y0 ||
+      item->rle->x1 + ix < pix.x1 || item->rle->y1 + iy < pix.y1)
+    {
+      tx = item->affine[4] - item->svp_affine[4];
+      ty = item->affine[5] - item->svp_affine[5];
+      if (tx != 0 || ty != 0)
+	{
+	  art_affine_translate (move, tx, ty);
+	  art_svp_affine_transform_inplace (item->svp, move);
+	  item->svp_bbox.x0 += tx;
+	  item->svp_bbox.y0 += ty;
+	  item->svp_bbox.x1 += tx;
+	  item->svp_bbox.y1 += ty;
+	  item->svp_affine[4] = item->affine[4];
+	  item->svp_affine[5] = item->affine[5];
+	  dl->stats.n_translated++;
+	}
+      if (item->rle != NULL)
+	art_svp_rle_free (item->rle);
+      item->rle = art_svp_render_to_rle (item->svp,
+					 pix.x0, pix.y0, pix.x1, pix.y1);
+      item->rle_tx = item->affine[4];
+      item->rle_ty = item->affine[5];
+      ix = iy = 0;
+      dl->stats.n_rasterized++;
+    }
+
+  item->dx = ix;
+  item->dy = iy;
+  item->visible = ART_TRUE;
+  dl->stats.n_drawn++;
+}
+
+/**
+ * art_display_list_render: Draw a display list.
+ * @dl: The display list.
+ * @x0: Left coordinate of destination rectangle.
+ * @y0: Top coordinate of destination rectangle.
+ * @x1: Right coordinate of destination rectangle.
+ * @y1: Bottom coordinate of destination rectangle.
+ * @pixels: Destination pixel buffer.
+ * @rowstride: Rowstride of @pixels buffer.
+ * @damage: Area to draw, or NULL for the whole rectangle.
+ *
+ * Draws the items of @dl, in the order they were recorded, into the
+ * destination, which is described as for art_render_new(). Only the
+ * area of @damage is drawn, and items outside it are skipped. The
+ * items are drawn over what is already there, so the first item will
+ * usually be an opaque background.
+ **/
+void
+art_display_list_render (ArtDisplayList *dl,
+			 int x0, int y0, int x1, int y1,
+			 art_u8 *pixels, int rowstride,
+			 ArtUta *damage)
+{
+  ArtDisplayListItem *item;
+  ArtRenderList *list;
+  ArtIRect viewport;
+  ArtIRect *rects;
+  ArtIRect r;
+  int n_rects;
+  int bytespp;
+  int i, j, k;
+
+  dl->stats.n_drawn = 0;
+  dl->stats.n_culled = 0;
+  dl->stats.n_derived = 0;
+  dl->stats.n_translated = 0;
+  dl->stats.n_rasterized = 0;
+
+  viewport.x0 = x0;
+  viewport.y0 = y0;
+  viewport.x1 = x1;
+  viewport.y1 = y1;
+  if (damage != NULL)
+    {
+      rects = art_rect_list_from_uta (damage, 256, 64, &n_rects);
+      for (i = 0, j = 0; i < n_rects; i++)
+	{
+	  art_irect_intersect (&rects[j], &rects[i], &viewport);
+	  if (!art_irect_empty (&rects[j]))
+	    j++;
+	}
+      n_rects = j;
+    }
+  else
+    {
+      rects = art_new (ArtIRect, 1);
+      rects[0] = viewport;
+      n_rects = art_irect_empty (&viewport) ? 0 : 1;
+    }
+
+  for (i = 0; i < dl->n_items; i++)
+    art_display_list_update (dl, &dl->items[i], &viewport, rects, n_rects);
+
+  bytespp = ((dl->n_chan + (dl->alpha_type != ART_ALPHA_NONE)) *
+	     dl->depth) >> 3;
+  for (k = 0; k < n_rects; k++)
+    {
+      list = art_render_list_new (rects[k].x0, rects[k].y0,
+				  rects[k].x1, rects[k].y1,
+				  pixels + (rects[k].y0 - y0) * rowstride +
+				  (rects[k].x0 - x0) * bytespp,
+				  rowstride, dl->n_chan, dl->depth,
+				  dl->alpha_type, dl->alphagamma);
+      for (i = 0; i < dl->n_items; i++)
+	{
+	  item = &dl->items[i];
+	  if (!item->visible)
+	    continue;
+	  r.x0 = item->rle->x0 + item->dx;
+	  r.y0 = item->rle->y0 + item->dy;
+	  r.x1 = item->rle->x1 + item->dx;
+	  r.y1 = item->rle->y1 + item->dy;
+	  if (!art_display_list_hits (&r, &rects[k], 1))
+	    continue;
+	  art_render_list_add_rle (list, item->rle, item->dx, item->dy,
+				   item->color, item->opacity,
+				   ART_COMPOSITE_NORMAL);
+	}
+      art_render_list_invoke (list);
+      art_render_list_free (list);
+    }
+
+  art_free (rects);
+}
+
+/**
+ * art_display_list_get_stats: Find out what the last drawing did.
+ * @dl: The display list.
+ * @stats: Where to store the counts.
+ *
+ * Stores in @stats how many items the last art_display_list_render()
+ * drew and culled, and how often it had to derive, move or rasterize
+ * their geometry.
+ **/
+void
+art_display_list_get_stats (const ArtDisplayList *dl,
+			    ArtDisplayListStats *stats)
+{
+  *stats = dl->stats;
+}
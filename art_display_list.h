@@ -0,0 +1,100 @@
+/*
+ * art_display_list.h: Retained scenes of filled and stroked paths.
+ *
+ * Libart_LGPL - library of basic graphic primitives
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifndef __ART_DISPLAY_LIST_H__
+#define __ART_DISPLAY_LIST_H__
+
+/* A display list records paths with their transforms and paints, and
+   keeps what it derives from them between frames. */
+
+#ifdef LIBART_COMPILATION
+#include "art_bpath.h"
+#include "art_render.h"
+#include "art_svp_intersect.h"
+#include "art_svp_vpath_stroke.h"
+#include "art_uta.h"
+#else
+#include <libart_lgpl/art_bpath.h>
+#include <libart_lgpl/art_render.h>
+#include <libart_lgpl/art_svp_intersect.h>
+#include <libart_lgpl/art_svp_vpath_stroke.h>
+#include <libart_lgpl/art_uta.h>
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+typedef struct _ArtDisplayList ArtDisplayList;
+typedef struct _ArtDisplayListStats ArtDisplayListStats;
+
+/* What the last art_display_list_render () did with the items. */
+struct _ArtDisplayListStats {
+  int n_drawn;
+  int n_culled;
+  int n_derived; /* svp made from the path */
+  int n_translated; /* svp moved to a new position */
+  int n_rasterized; /* coverage made from the svp */
+};
+
+ArtDisplayList *
+art_display_list_new (int n_chan, int depth, ArtAlphaType alpha_type,
+		      ArtAlphaGamma *alphagamma, double flatness);
+
+void
+art_display_list_free (ArtDisplayList *dl);
+
+int
+art_display_list_add_fill (ArtDisplayList *dl, const ArtBpath *bpath,
+			   ArtWindRule rule, const double affine[6],
+			   const ArtPixMaxDepth *color, int opacity);
+
+int
+art_display_list_add_stroke (ArtDisplayList *dl, const ArtBpath *bpath,
+			     ArtPathStrokeJoinType join,
+			     ArtPathStrokeCapType cap,
+			     double line_width, double miter_limit,
+			     const double affine[6],
+			     const ArtPixMaxDepth *color, int opacity);
+
+void
+art_display_list_set_affine (ArtDisplayList *dl, int item,
+			     const double affine[6]);
+
+void
+art_display_list_set_paint (ArtDisplayList *dl, int item,
+			    const ArtPixMaxDepth *color, int opacity);
+
+void
+art_display_list_render (ArtDisplayList *dl,
+			 int x0, int y0, int x1, int y1,
+			 art_u8 *pixels, int rowstride,
+			 ArtUta *damage);
+
+void
+art_display_list_get_stats (const ArtDisplayList *dl,
+			    ArtDisplayListStats *stats);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __ART_DISPLAY_LIST_H__ */
@@ -27,6 +27,7 @@
 #endif
 #include <stdio.h>
 #include <stdarg.h>
+#include <string.h>
 
 /**
  * art_die: Print the error message to stderr and exit with a return code of 1.
@@ -77,17 +78,300 @@ art_dprint (const char *fmt, ...)
   va_end (ap);
 }
 
+static void *
+art_malloc_alloc (void *data, size_t size)
+{
+  return malloc (size);
+}
+
+static void *
+art_malloc_realloc (void *data, void *ptr, size_t size)
+{
+  return realloc (ptr, size);
+}
+
+static void
+art_malloc_free (void *data, void *ptr)
+{
+  free (ptr);
+}
+
+static const ArtAllocator art_allocator_malloc = {
+  art_malloc_alloc,
+  art_malloc_realloc,
+  art_malloc_free,
+  NULL
+};
+
+static const ArtAllocator *art_allocator = &art_allocator_malloc;
+
+#define ART_ALLOC_CLASS(size) \
+  ((size) > 16 * (ART_ALLOC_N_CLASSES - 1) ? ART_ALLOC_N_CLASSES - 1 : \
+   (size) == 0 ? 0 : (int)(((size) - 1) >> 4))
+
 void *art_alloc(size_t size)
 {
-  return malloc(size);
+  return art_allocator->alloc (art_allocator->data, size);
 }
 
 void art_free(void *ptr)
 {
-  free(ptr);
+  if (ptr == NULL)
+    return;
+  art_allocator->free (art_allocator->data, ptr);
 }
 
 void *art_realloc(void *ptr, size_t size)
 {
-  return realloc(ptr, size);
+  return art_allocator->realloc (art_allocator->data, ptr, size);
+}
+
+/* The counting allocator updates the counters and forwards to the
+   allocator that was installed when counting was turned on. */
+
+static ArtAllocStats art_alloc_stats;
+
+static const ArtAllocator *art_count_inner = &art_allocator_malloc;
+
+static void *
+art_count_alloc (void *data, size_t size)
+{
+  art_alloc_stats.n_alloc[ART_ALLOC_CLASS (size)]++;
+  return art_count_inner->alloc (art_count_inner->data, size);
+}
+
+static void *
+art_count_realloc (void *data, void *ptr, size_t size)
+{
+  art_alloc_stats.n_realloc[ART_ALLOC_CLASS (size)]++;
+  return art_count_inner->realloc (art_count_inner->data, ptr, size);
+}
+
+static void
+art_count_free (void *data, void *ptr)
+{
+  art_alloc_stats.n_free++;
+  art_count_inner->free (art_count_inner->data, ptr);
+}
+
+static const ArtAllocator art_allocator_count = {
+  art_count_alloc,
+  art_count_realloc,
+  art_count_free,
+  NULL
+};
+
+/**
+ * art_set_allocator: Install the allocator used by art_alloc().
+ * @allocator: The allocator, or NULL for malloc(), realloc() and free().
+ *
+ * Makes art_alloc(), art_realloc() and art_free() call the functions
+ * of @allocator, passing its data member as the first argument. The
+ * allocator structure is referenced, not copied.
+ *
+ * Blocks are always released through the allocator that is installed
+ * at the time, so this should be called before libart allocates
+ * anything that is still alive when it is switched. While allocations
+ * are counted, @allocator is the one the counting forwards to.
+ **/
+void
+art_set_allocator (const ArtAllocator *allocator)
+{
+  if (allocator == NULL)
+    allocator = &art_allocator_malloc;
+  if (art_allocator == &art_allocator_count)
+    art_count_inner = allocator;
+  else
+    art_allocator = allocator;
+}
+
+/* The caching allocator keeps freed blocks of the small size classes
+   on free lists, which spares malloc the churn of the many short lived
+   segments, points and vector paths that libart allocates while
+   rendering. Every block is preceded by a header holding its size
+   class. */
+
+#define ART_CACHE_MAX_FREE 256
+
+typedef union _ArtCacheHeader ArtCacheHeader;
+
+union _ArtCacheHeader {
+  ArtCacheHeader *next; /* while on a free list */
+  int size_class; /* while allocated */
+  double align_d;
+  long align_l;
+};
+
+static ArtCacheHeader *art_cache_free_list[ART_ALLOC_N_CLASSES - 1];
+static int art_cache_n_free[ART_ALLOC_N_CLASSES - 1];
+
+static void *
+art_cache_alloc (void *data, size_t size)
+{
+  int size_class = ART_ALLOC_CLASS (size);
+  ArtCacheHeader *block;
+
+  if (size_class < ART_ALLOC_N_CLASSES - 1 &&
+      art_cache_free_list[size_class] != NULL)
+    {
+      block = art_cache_free_list[size_class];
+      art_cache_free_list[size_class] = block->next;
+      art_cache_n_free[size_class]--;
+    }
+  else
+    {
+      if (size_class < ART_ALLOC_N_CLASSES - 1)
+	size = (size_class + 1) << 4;
+      block = malloc (sizeof(ArtCacheHeader) + size);
+      if (block == NULL)
+	return NULL;
+    }
+  block->size_class = size_class;
+  return block + 1;
+}
+
+static void
+art_cache_free (void *data, void *ptr)
+{
+  ArtCacheHeader *block = (ArtCacheHeader *)ptr - 1;
+  int size_class = block->size_class;
+
+  if (size_class < ART_ALLOC_N_CLASSES - 1 &&
+      art_cache_n_free[size_class] < ART_CACHE_MAX_FREE)
+    {
+      block->next = art_cache_free_list[size_class];
+      art_cache_free_list[size_class] = block;
+      art_cache_n_free[size_class]++;
+    }
+  else
+    free (block);
+}
+
+static void *
+art_cache_realloc (void *data, void *ptr, size_t size)
+{
+  ArtCacheHeader *block;
+  int size_class;
+  void *result;
+
+  if (ptr == NULL)
+    return art_cache_alloc (data, size);
+
+  block = (ArtCacheHeader *)ptr - 1;
+  size_class = ART_ALLOC_CLASS (size);
+  if (size_class == block->size_class && size_class < ART_ALLOC_N_CLASSES - 1)
+    return ptr;
+
+  if (size_class == ART_ALLOC_N_CLASSES - 1 &&
+      block->size_class == ART_ALLOC_N_CLASSES - 1)
+    {
+      block = realloc (block, sizeof(ArtCacheHeader) + size);
+      return block != NULL ? block + 1 : NULL;
+    }
+
+  result = art_cache_alloc (data, size);
+  if (result == NULL)
+    return NULL;
+  if (block->size_class < ART_ALLOC_N_CLASSES - 1 &&
+      (size_t)((block->size_class + 1) << 4) < size)
+    size = (block->size_class + 1) << 4;
+  memcpy (result, ptr, size);
+  art_cache_free (data, ptr);
+  return result;
+}
+
+static const ArtAllocator art_allocator_cache_funcs = {
+  art_cache_alloc,
+  art_cache_realloc,
+  art_cache_free,
+  NULL
+};
+
+/**
+ * art_allocator_cache: Get the caching allocator.
+ *
+ * Returns an allocator that keeps up to a few hundred freed blocks of
+ * each size class up to 256 bytes for reuse. Install it with
+ * art_set_allocator() to cut the malloc traffic of repeated
+ * rendering. Its free lists are shared and unlocked, so it may only be
+ * used while libart is called from a single thread at a time.
+ *
+ * Return value: The caching allocator.
+ **/
+const ArtAllocator *
+art_allocator_cache (void)
+{
+  return &art_allocator_cache_funcs;
+}
+
+/**
+ * art_allocator_cache_trim: Release the blocks held by the caching allocator.
+ *
+ * Returns all blocks on the free lists of the allocator from
+ * art_allocator_cache() to the system.
+ **/
+void
+art_allocator_cache_trim (void)
+{
+  ArtCacheHeader *block;
+  int i;
+
+  for (i = 0; i < ART_ALLOC_N_CLASSES - 1; i++)
+    {
+      while (art_cache_free_list[i] != NULL)
+	{
+	  block = art_cache_free_list[i];
+	  art_cache_free_list[i] = block->next;
+	  free (block);
+	}
+      art_cache_n_free[i] = 0;
+    }
+}
+
+/**
+ * art_alloc_count: Turn allocation counting on or off.
+ * @count: Nonzero to count allocations, zero to stop.
+ *
+ * Counting is off by default, and art_alloc() then calls the
+ * installed allocator directly. While it is on, every call is counted
+ * for art_alloc_get_stats() before it is passed on to the installed
+ * allocator. The counters are not locked, so counting should only be
+ * turned on while libart is called from a single thread at a time.
+ **/
+void
+art_alloc_count (int count)
+{
+  if (count && art_allocator != &art_allocator_count)
+    {
+      art_count_inner = art_allocator;
+      art_allocator = &art_allocator_count;
+    }
+  else if (!count && art_allocator == &art_allocator_count)
+    art_allocator = art_count_inner;
+}
+
+/**
+ * art_alloc_get_stats: Get allocation counters.
+ * @stats: Where to store the counters.
+ *
+ * Stores the number of calls to art_alloc() and art_realloc() counted
+ * since the last art_alloc_reset_stats(), by requested size class, and
+ * the number of blocks freed with art_free(). Only calls made while
+ * counting is turned on with art_alloc_count() are counted.
+ **/
+void
+art_alloc_get_stats (ArtAllocStats *stats)
+{
+  *stats = art_alloc_stats;
+}
+
+/**
+ * art_alloc_reset_stats: Reset allocation counters.
+ *
+ * Sets all the counters reported by art_alloc_get_stats() to zero.
+ **/
+void
+art_alloc_reset_stats (void)
+{
+  memset (&art_alloc_stats, 0, sizeof(art_alloc_stats));
 }
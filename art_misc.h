@@ -40,6 +40,39 @@ extern "C" {
 void *art_alloc(size_t size);
 void art_free(void *ptr);
 void *art_realloc(void *ptr, size_t size);
+
+/* All libart allocation goes through art_alloc and friends, which in
+   turn call the functions of the installed allocator. */
+typedef struct _ArtAllocator ArtAllocator;
+
+struct _ArtAllocator {
+  void *(*alloc) (void *data, size_t size);
+  void *(*realloc) (void *data, void *ptr, size_t size);
+  void (*free) (void *data, void *ptr);
+  void *data;
+};
+
+void art_set_allocator (const ArtAllocator *allocator);
+
+const ArtAllocator *art_allocator_cache (void);
+void art_allocator_cache_trim (void);
+
+/* While counting is turned on, allocations are counted by size class:
+   class i holds requests of up to 16 * (i + 1) bytes, the last class
+   everything larger. */
+#define ART_ALLOC_N_CLASSES 17
+
+typedef struct _ArtAllocStats ArtAllocStats;
+
+struct _ArtAllocStats {
+  unsigned long n_alloc[ART_ALLOC_N_CLASSES];
+  unsigned long n_realloc[ART_ALLOC_N_CLASSES];
+  unsigned long n_free;
+};
+
+void art_alloc_count (int count);
+void art_alloc_get_stats (ArtAllocStats *stats);
+void art_alloc_reset_stats (void);
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -209,6 +209,72 @@ art_pixbuf_new_rgba (art_u8 *pixels, int width, int height, int rowstride)
   return art_pixbuf_new_rgba_dnotify (pixels, width, height, rowstride, NULL, art_pixel_destroy);
 }
 
+/**
+ * art_pixbuf_new_rgba_premul_dnotify: Create a new premultiplied RGBA #ArtPixBuf with explicit destroy notification.
+ * @pixels: A buffer containing the actual pixel data.
+ * @width: The width of the pixbuf.
+ * @height: The height of the pixbuf.
+ * @rowstride: The rowstride of the pixbuf.
+ * @dfunc_data: The private data passed to @dfunc.
+ * @dfunc: The destroy notification function.
+ *
+ * Like art_pixbuf_new_rgba_dnotify(), but the color samples in
+ * @pixels are premultiplied by alpha, so no sample may exceed the
+ * alpha of its pixel. Such pixbufs can be composited with
+ * multiplications only; see art_rgba_premultiply(). The format of
+ * the pixbuf is %ART_PIX_RGB_PREMUL.
+ *
+ * Return value: The newly created #ArtPixBuf.
+ **/
+ArtPixBuf *
+art_pixbuf_new_rgba_premul_dnotify (art_u8 *pixels, int width, int height, int rowstride,
+				    void *dfunc_data, ArtDestroyNotify dfunc)
+{
+  ArtPixBuf *pixbuf;
+
+  pixbuf = art_pixbuf_new_rgba_dnotify (pixels, width, height, rowstride,
+					dfunc_data, dfunc);
+  pixbuf->format = ART_PIX_RGB_PREMUL;
+
+  return pixbuf;
+}
+
+/**
+ * art_pixbuf_new_rgba_premul: Create a new premultiplied RGBA #ArtPixBuf.
+ * @pixels: A buffer containing the actual pixel data.
+ * @width: The width of the pixbuf.
+ * @height: The height of the pixbuf.
+ * @rowstride: The rowstride of the pixbuf.
+ *
+ * Like art_pixbuf_new_rgba(), but the color samples in @pixels are
+ * premultiplied by alpha.
+ *
+ * Return value: The newly created #ArtPixBuf.
+ **/
+ArtPixBuf *
+art_pixbuf_new_rgba_premul (art_u8 *pixels, int width, int height, int rowstride)
+{
+  return art_pixbuf_new_rgba_premul_dnotify (pixels, width, height, rowstride, NULL, art_pixel_destroy);
+}
+
+/**
+ * art_pixbuf_new_const_rgba_premul: Create a new premultiplied RGBA #ArtPixBuf with constant pixel data.
+ * @pixels: A buffer containing the actual pixel data.
+ * @width: The width of the pixbuf.
+ * @height: The height of the pixbuf.
+ * @rowstride: The rowstride of the pixbuf.
+ *
+ * Like art_pixbuf_new_const_rgba(), but the color samples in @pixels
+ * are premultiplied by alpha.
+ *
+ * Return value: The newly created #ArtPixBuf.
+ **/
+ArtPixBuf *
+art_pixbuf_new_const_rgba_premul (const art_u8 *pixels, int width, int height, int rowstride)
+{
+  return art_pixbuf_new_rgba_premul_dnotify ((art_u8 *) pixels, width, height, rowstride, NULL, NULL);
+}
+
 /**
  * art_pixbuf_free: Destroy an #ArtPixBuf.
  * @pixbuf: The #ArtPixBuf to be destroyed.
@@ -40,7 +40,10 @@ typedef void (*ArtDestroyNotify) (void *func_data, void *data);
 typedef struct _ArtPixBuf ArtPixBuf;
 
 typedef enum {
-  ART_PIX_RGB
+  ART_PIX_RGB,
+  /* RGBA with the color samples premultiplied by alpha, as made by
+     art_pixbuf_new_rgba_premul () */
+  ART_PIX_RGB_PREMUL
   /* gray, cmyk, lab, ... ? */
 } ArtPixFormat;
 
@@ -86,6 +89,17 @@ ArtPixBuf *
 art_pixbuf_new_rgba_dnotify (art_u8 *pixels, int width, int height, int rowstride,
 			     void *dfunc_data, ArtDestroyNotify dfunc);
 
+/* the same for RGBA pixels with premultiplied alpha */
+ArtPixBuf *
+art_pixbuf_new_rgba_premul (art_u8 *pixels, int width, int height, int rowstride);
+
+ArtPixBuf *
+art_pixbuf_new_const_rgba_premul (const art_u8 *pixels, int width, int height, int rowstride);
+
+ArtPixBuf *
+art_pixbuf_new_rgba_premul_dnotify (art_u8 *pixels, int width, int height, int rowstride,
+				    void *dfunc_data, ArtDestroyNotify dfunc);
+
 /* free an ArtPixBuf with destroy notification */
 void
 art_pixbuf_free (ArtPixBuf *pixbuf);
@@ -31,6 +31,14 @@ struct _ArtPoint {
   double x, y;
 };
 
+/* Single precision points, for the float geometry variants. */
+typedef struct _ArtPointF ArtPointF;
+
+struct _ArtPointF {
+  /*< public >*/
+  float x, y;
+};
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -198,6 +198,45 @@ art_drect_affine_transform (ArtDRect *dst, const ArtDRect *src, const double mat
   dst->y1 = MAX (MAX (y00, y10), MAX (y01, y11));
 }
 
+/**
+ * art_drect_affine_transform_array: Affine transform many rectangles.
+ * @dst: Where to store the result rectangles.
+ * @src: The source rectangles.
+ * @n_rects: Number of rectangles.
+ * @matrix: The affine transform.
+ *
+ * Does art_drect_affine_transform() on @n_rects rectangles; @dst may
+ * be @src. When @matrix is rectilinear (a scale and translation), each
+ * edge maps to an edge and the corners need not be transformed.
+ **/
+void
+art_drect_affine_transform_array (ArtDRect *dst, const ArtDRect *src,
+				  int n_rects, const double matrix[6])
+{
+  double a = matrix[0], d = matrix[3], e = matrix[4], f = matrix[5];
+  double x0, y0, x1, y1;
+  int i;
+
+  if (matrix[1] != 0 || matrix[2] != 0)
+    {
+      for (i = 0; i < n_rects; i++)
+	art_drect_affine_transform (&dst[i], &src[i], matrix);
+      return;
+    }
+
+  for (i = 0; i < n_rects; i++)
+    {
+      x0 = src[i].x0 * a + e;
+      x1 = src[i].x1 * a + e;
+      y0 = src[i].y0 * d + f;
+      y1 = src[i].y1 * d + f;
+      dst[i].x0 = MIN (x0, x1);
+      dst[i].y0 = MIN (y0, y1);
+      dst[i].x1 = MAX (x0, x1);
+      dst[i].y1 = MAX (y0, y1);
+    }
+}
+
 /**
  * art_drect_to_irect: Convert rectangle to integer rectangle.
  * @dst: Where to store resulting integer rectangle.
@@ -69,6 +69,10 @@ void
 art_drect_affine_transform (ArtDRect *dst, const ArtDRect *src,
 			   const double matrix[6]);
 
+void
+art_drect_affine_transform_array (ArtDRect *dst, const ArtDRect *src,
+				  int n_rects, const double matrix[6]);
+
 void art_drect_to_irect (ArtIRect *dst, ArtDRect *src);
 
 #ifdef __cplusplus
@@ -20,6 +20,10 @@
 #include "config.h"
 #include "art_rect_uta.h"
 
+#ifndef MAX
+#define MAX(a, b)  (((a) > (b)) ? (a) : (b))
+#endif /* MAX */
+
 /* Functions to decompose a microtile array into a list of rectangles. */
 
 /**
@@ -132,3 +136,147 @@ art_rect_list_from_uta (ArtUta *uta, int max_width, int max_height,
   *p_nrects = n_rects;
   return rects;
 }
+
+/* Cost of drawing @rect under the cost model. */
+static double
+art_rect_cost (const ArtIRect *rect, double rect_cost, double pixel_cost)
+{
+  return rect_cost +
+    pixel_cost * (double)(rect->x1 - rect->x0) * (rect->y1 - rect->y0);
+}
+
+/* Find the rectangle whose merge with rectangle @i saves the most,
+   storing the saving in *@p_saving. */
+static int
+art_rect_best_merge (const ArtIRect *rects, const double *costs, int n_rects,
+		     int i, double rect_cost, double pixel_cost,
+		     double *p_saving)
+{
+  ArtIRect merged;
+  double saving;
+  int best = -1;
+  int j;
+
+  *p_saving = 0;
+  for (j = 0; j < n_rects; j++)
+    if (j != i)
+      {
+	art_irect_union (&merged, &rects[i], &rects[j]);
+	saving = costs[i] + costs[j] -
+	  art_rect_cost (&merged, rect_cost, pixel_cost);
+	if (best < 0 || saving > *p_saving)
+	  {
+	    *p_saving = saving;
+	    best = j;
+	  }
+      }
+  return best;
+}
+
+/**
+ * art_rect_list_from_uta_cost: Decompose uta into rectangles by cost.
+ * @uta: The source uta.
+ * @rect_cost: The fixed cost of drawing one rectangle.
+ * @pixel_cost: The cost of drawing one pixel.
+ * @p_nrects: Where to store the number of returned rectangles.
+ *
+ * Allocates a new list of rectangles covering @uta, sets *@p_nrects
+ * to the number in the list. This list should be freed with
+ * art_free().
+ *
+ * Unlike art_rect_list_from_uta(), the rectangles may cover pixels
+ * outside the uta, when that is cheaper: starting from the precise
+ * decomposition, the pair of rectangles whose bounding box saves the
+ * most of @rect_cost + @pixel_cost * area over drawing both is merged,
+ * until no merge saves anything. This suits backends where each
+ * expose or blit carries a large overhead compared with its pixels.
+ * With @rect_cost zero, the precise decomposition is returned.
+ *
+ * Return value: An array containing the resulting rectangles.
+ **/
+ArtIRect *
+art_rect_list_from_uta_cost (ArtUta *uta, double rect_cost, double pixel_cost,
+			     int *p_nrects)
+{
+  ArtIRect *rects;
+  int n_rects;
+  int max_size;
+  int i, j, k, last;
+  double *costs;
+  int *best; /* the best rectangle to merge each one with */
+  double *savings; /* and what that merge saves */
+  double saving;
+  ArtIRect merged;
+
+  max_size = (MAX (uta->width, uta->height) + 1) << ART_UTILE_SHIFT;
+  rects = art_rect_list_from_uta (uta, max_size, max_size, &n_rects);
+
+  costs = art_new (double, MAX (n_rects, 1));
+  best = art_new (int, MAX (n_rects, 1));
+  savings = art_new (double, MAX (n_rects, 1));
+  for (i = 0; i < n_rects; i++)
+    costs[i] = art_rect_cost (&rects[i], rect_cost, pixel_cost);
+  for (i = 0; i < n_rects; i++)
+    best[i] = art_rect_best_merge (rects, costs, n_rects, i,
+				   rect_cost, pixel_cost, &savings[i]);
+
+  /* greedily merge the best pair until no merge pays off */
+  for (;;)
+    {
+      i = -1;
+      for (k = 0; k < n_rects; k++)
+	if (savings[k] > 0 && (i < 0 || savings[k] > savings[i]))
+	  i = k;
+      if (i < 0)
+	break;
+      j = best[i];
+      if (j < i)
+	{
+	  k = i;
+	  i = j;
+	  j = k;
+	}
+
+      /* merge j into i, and move the last rectangle into j's place */
+      art_irect_union (&merged, &rects[i], &rects[j]);
+      rects[i] = merged;
+      costs[i] = art_rect_cost (&merged, rect_cost, pixel_cost);
+      last = --n_rects;
+      rects[j] = rects[last];
+      costs[j] = costs[last];
+      best[j] = best[last];
+      savings[j] = savings[last];
+
+      for (k = 0; k < n_rects; k++)
+	{
+	  if (k == i)
+	    continue;
+	  if (best[k] == last && j != last)
+	    best[k] = j;
+	  else if (best[k] == i || best[k] == j)
+	    {
+	      /* its partner is gone or changed */
+	      best[k] = art_rect_best_merge (rects, costs, n_rects, k,
+					     rect_cost, pixel_cost,
+					     &savings[k]);
+	      continue;
+	    }
+	  art_irect_union (&merged, &rects[k], &rects[i]);
+	  saving = costs[k] + costs[i] -
+	    art_rect_cost (&merged, rect_cost, pixel_cost);
+	  if (saving > savings[k])
+	    {
+	      savings[k] = saving;
+	      best[k] = i;
+	    }
+	}
+      best[i] = art_rect_best_merge (rects, costs, n_rects, i,
+				     rect_cost, pixel_cost, &savings[i]);
+    }
+
+  art_free (costs);
+  art_free (best);
+  art_free (savings);
+  *p_nrects = n_rects;
+  return rects;
+}
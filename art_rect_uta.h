@@ -36,6 +36,10 @@ ArtIRect *
 art_rect_list_from_uta (ArtUta *uta, int max_width, int max_height,
 			int *p_nrects);
 
+ArtIRect *
+art_rect_list_from_uta_cost (ArtUta *uta, double rect_cost, double pixel_cost,
+			     int *p_nrects);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
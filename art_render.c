@@ -23,7 +23,10 @@
 #include "config.h"
 #include "art_render.h"
 
+#include <string.h>
+
 #include "art_rgb.h"
+#include "art_rgba.h"
 
 typedef struct _ArtRenderPriv ArtRenderPriv;
 
@@ -187,6 +190,13 @@ art_render_clear_render_8 (ArtRenderCallback *self, ArtRender *render,
       color[j] = ART_PIX_8_FROM_MAX (color_max);
     }
 
+  /* art_rgba_fill_run () stores whole pixels as 32-bit words */
+  if (n_ch == 4 && color[3] == 0xff && (((unsigned long)dest) & 3) == 0)
+    {
+      art_rgba_fill_run (dest, color[0], color[1], color[2], width);
+      return;
+    }
+
   ix = 0;
   for (i = 0; i < width; i++)
     for (j = 0; j < n_ch; j++)
@@ -216,7 +226,7 @@ art_render_clear_render_16 (ArtRenderCallback *self, ArtRender *render,
   int n_ch = render->n_chan + (render->alpha_type != ART_ALPHA_NONE);
   int ix;
   art_u16 *dest_16 = (art_u16 *)dest;
-  art_u8 color[ART_MAX_CHAN + 1];
+  art_u16 color[ART_MAX_CHAN + 1];
 
   for (j = 0; j < n_ch; j++)
     {
@@ -428,7 +438,7 @@ art_render_composite (ArtRenderCallback *self, ArtRender *render,
 	      for (j = 0; j < n_chan; j++)
 		dst[j] = (dstptr[j] * dst_mul + 0x8000) >> 16;
 	    }
-	  else if (buf_depth == 16)
+	  else if (depth == 16)
 	    {
 	      for (j = 0; j < n_chan; j++)
 		dst[j] = (((art_u16 *)dstptr)[j] * dst_mul + 0x8000) >> 16;
@@ -643,6 +653,73 @@ const ArtRenderCallback art_render_composite_8_obj =
   art_render_nop_done
 };
 
+/* Assumes:
+ * alpha_buf is NULL
+ * buf_alpha = ART_ALPHA_NONE  (source)
+ * alpha_type = ART_ALPHA_NONE (dest)
+ *
+ * Gives the same result as art_render_composite_8, but as in
+ * art_render_composite_16_opaque, the samples of a run share their
+ * weights, so the loop runs over samples and fully covered runs are
+ * copied. The blend keeps the two roundings of the general path:
+ * the destination sample is scaled to 16 bits first, then weighted.
+ * Only runs of exactly full coverage are copied, as the general path
+ * computes runs just above it the same way as partial ones.
+ */
+static void
+art_render_composite_8_opaque (ArtRenderCallback *self, ArtRender *render,
+			       art_u8 *dest, int y)
+{
+  ArtRenderMaskRun *run = render->run;
+  int n_run = render->n_run;
+  int x0 = render->x0;
+  int n_chan = render->n_chan;
+  int run_x0, run_x1;
+  const art_u8 *bufptr;
+  art_u8 *dstptr;
+  int i, j, n;
+  art_u32 tmp;
+  art_u32 run_alpha, src_mul, dst_mul, dst_weight;
+
+  dst_mul = 0x10000 * 0x101;
+  for (i = 0; i < n_run - 1; i++)
+    {
+      run_x0 = run[i].x;
+      run_x1 = run[i + 1].x;
+      tmp = run[i].alpha;
+      if (tmp < 0x10000)
+	continue;
+
+      run_alpha = (tmp + (tmp >> 8) + (tmp >> 16) - 0x8000) >> 8; /* range [0 .. 0x10000] */
+      bufptr = render->image_buf + (run_x0 - x0) * n_chan;
+      dstptr = dest + (run_x0 - x0) * n_chan;
+      n = (run_x1 - run_x0) * n_chan;
+      if (run_alpha == 0x10000)
+	memcpy (dstptr, bufptr, n);
+      else
+	{
+	  src_mul = run_alpha * 0x101;
+	  dst_weight = 0x10000 - run_alpha;
+	  for (j = 0; j < n; j++)
+	    {
+	      art_u32 src, dst;
+
+	      src = (bufptr[j] * src_mul + 0x8000) >> 16;
+	      dst = (dstptr[j] * dst_mul + 0x8000) >> 16;
+	      tmp = ((dst * dst_weight + 0x8000) >> 16) + src;
+	      tmp -= tmp >> 16;
+	      dstptr[j] = (tmp * 0xff + 0x8000) >> 16;
+	    }
+	}
+    }
+}
+
+const ArtRenderCallback art_render_composite_8_opaque_obj =
+{
+  art_render_composite_8_opaque,
+  art_render_nop_done
+};
+
 
 /* Assumes:
  * alpha_buf is NULL
@@ -882,10 +959,308 @@ const ArtRenderCallback art_render_composite_8_opt2_obj =
 };
 
 
+#if ART_MAX_DEPTH >= 16
+
+/* Assumes:
+ * depth = buf_depth = 16
+ * alpha_buf is NULL
+ * buf_alpha = ART_ALPHA_NONE  (source)
+ * alpha_type = ART_ALPHA_NONE (dest)
+ *
+ * This is the common case of drawing into a 16-bit linear light
+ * destination (see art_srgb.h). The samples of a run are blended
+ * with the same weights, so the loop runs over samples, not pixels.
+ */
+static void
+art_render_composite_16_opaque (ArtRenderCallback *self, ArtRender *render,
+				art_u8 *dest, int y)
+{
+  ArtRenderMaskRun *run = render->run;
+  int n_run = render->n_run;
+  int x0 = render->x0;
+  int n_chan = render->n_chan;
+  int run_x0, run_x1;
+  const art_u16 *bufptr;
+  art_u16 *dstptr;
+  int i, j, n;
+  art_u32 tmp;
+  art_u32 run_alpha, inv_alpha;
+
+  for (i = 0; i < n_run - 1; i++)
+    {
+      run_x0 = run[i].x;
+      run_x1 = run[i + 1].x;
+      tmp = run[i].alpha;
+      if (tmp < 0x8100)
+	continue;
+
+      run_alpha = (tmp + (tmp >> 8) + (tmp >> 16) - 0x8000) >> 8; /* range [0 .. 0x10000] */
+      bufptr = (art_u16 *)render->image_buf + (run_x0 - x0) * n_chan;
+      dstptr = (art_u16 *)dest + (run_x0 - x0) * n_chan;
+      n = (run_x1 - run_x0) * n_chan;
+      if (run_alpha >= 0x10000)
+	{
+	  for (j = 0; j < n; j++)
+	    dstptr[j] = bufptr[j];
+	}
+      else
+	{
+	  /* the weights sum to 0x10000, so this stays within 32 bits */
+	  inv_alpha = 0x10000 - run_alpha;
+	  for (j = 0; j < n; j++)
+	    dstptr[j] = (dstptr[j] * inv_alpha + bufptr[j] * run_alpha +
+			 0x8000) >> 16;
+	}
+    }
+}
+
+const ArtRenderCallback art_render_composite_16_opaque_obj =
+{
+  art_render_composite_16_opaque,
+  art_render_nop_done
+};
+
+#endif /* ART_MAX_DEPTH >= 16 */
+
+/* Gamma-correct compositing works in the linear intensity space of
+   render->alphagamma: colors are looked up in its table, blended, and
+   looked up in its invtable to store them. Table entries have
+   invtable_size bits; to keep the weighted sums within 30 bits, the
+   blend weight is cut from 16 down to 12 bits, and beyond that the
+   table entries are cut. */
+#define ART_GAMMA_WSHIFT(ag) ((ag)->invtable_size <= 14 ? 0 : \
+			      (ag)->invtable_size >= 18 ? 4 : \
+			      (ag)->invtable_size - 14)
+#define ART_GAMMA_TSHIFT(ag) ((ag)->invtable_size > 18 ? \
+			      (ag)->invtable_size - 18 : 0)
+
+/* The general case for 8-bit depth. */
+static void
+art_render_composite_8_gamma (ArtRenderCallback *self, ArtRender *render,
+			      art_u8 *dest, int y)
+{
+  ArtRenderMaskRun *run = render->run;
+  int n_run = render->n_run;
+  int x0 = render->x0;
+  int x;
+  int run_x0, run_x1;
+  art_u8 *alpha_buf = render->alpha_buf;
+  art_u8 *image_buf = render->image_buf;
+  int i, j;
+  art_u32 tmp;
+  art_u32 run_alpha;
+  art_u32 alpha;
+  int n_chan = render->n_chan;
+  ArtAlphaType alpha_type = render->alpha_type;
+  int dst_pixstride = n_chan + (alpha_type != ART_ALPHA_NONE);
+  ArtAlphaType buf_alpha = render->buf_alpha;
+  int buf_pixstride = n_chan + (buf_alpha != ART_ALPHA_NONE);
+  const int *table = render->alphagamma->table;
+  const art_u8 *invtab = render->alphagamma->invtable;
+  int wshift = ART_GAMMA_WSHIFT (render->alphagamma);
+  int tshift = ART_GAMMA_TSHIFT (render->alphagamma);
+  int tround = (1 << tshift) >> 1;
+  art_u8 *bufptr;
+  art_u32 src_a8, dst_a8;
+  art_u32 src_alpha;
+  art_u8 *dstptr;
+  art_u32 dst_alpha;
+  art_u32 src_unmul, dst_unmul;
+  int full = 0x10000 >> wshift;
+  int half = 0x8000 >> wshift;
+  int weight;
+
+  for (i = 0; i < n_run - 1; i++)
+    {
+      run_x0 = run[i].x;
+      run_x1 = run[i + 1].x;
+      tmp = run[i].alpha;
+      if (tmp < 0x10000)
+	continue;
+
+      run_alpha = (tmp + (tmp >> 8) + (tmp >> 16) - 0x8000) >> 8; /* range [0 .. 0x10000] */
+      /* overlapping segments, as in strokes, can take the coverage
+	 above full, which the tables below must not see */
+      if (run_alpha > 0x10000)
+	run_alpha = 0x10000;
+      bufptr = image_buf + (run_x0 - x0) * buf_pixstride;
+      dstptr = dest + (run_x0 - x0) * dst_pixstride;
+      for (x = run_x0; x < run_x1; x++)
+	{
+	  if (alpha_buf)
+	    {
+	      tmp = run_alpha * alpha_buf[x - x0] + 0x80;
+	      /* range 0x80 .. 0xff0080 */
+	      alpha = (tmp + (tmp >> 8) + (tmp >> 16)) >> 8;
+	    }
+	  else
+	    alpha = run_alpha;
+
+	  src_a8 = buf_alpha == ART_ALPHA_NONE ? 0xff : bufptr[n_chan];
+	  tmp = alpha * src_a8 + 0x80;
+	  src_alpha = (tmp + (tmp >> 8) + (tmp >> 16)) >> 8;
+	  if (src_alpha > 0x10000)
+	    src_alpha = 0x10000;
+	  /* src_alpha is the (alpha of the source pixel * alpha),
+	     range 0..0x10000 */
+	  if (src_alpha == 0)
+	    {
+	      bufptr += buf_pixstride;
+	      dstptr += dst_pixstride;
+	      continue;
+	    }
+
+	  dst_a8 = alpha_type == ART_ALPHA_NONE ? 0xff : dstptr[n_chan];
+	  dst_alpha = (dst_a8 << 8) + dst_a8 + (dst_a8 >> 7);
+	  if (src_alpha >= 0x10000)
+	    dst_alpha = 0x10000;
+	  else
+	    dst_alpha += ((((0x10000 - dst_alpha) * src_alpha) >> 8) + 0x80) >> 8;
+	  /* the share of the source in the result, range 0..0x10000 */
+	  weight = ((src_alpha << 15) / dst_alpha) << 1;
+	  weight >>= wshift;
+
+	  /* colors are blended without premultiplication */
+	  src_unmul = 0;
+	  if (buf_alpha == ART_ALPHA_PREMUL && src_a8 < 0xff)
+	    src_unmul = 0xff0000 / src_a8;
+	  dst_unmul = 0;
+	  if (alpha_type == ART_ALPHA_PREMUL && dst_a8 < 0xff && dst_a8 > 0)
+	    dst_unmul = 0xff0000 / dst_a8;
+
+	  for (j = 0; j < n_chan; j++)
+	    {
+	      int src, dst;
+
+	      src = bufptr[j];
+	      if (src_unmul)
+		{
+		  src = (src * src_unmul + 0x8000) >> 16;
+		  if (src > 0xff)
+		    src = 0xff;
+		}
+	      dst = dstptr[j];
+	      if (dst_unmul)
+		{
+		  dst = (dst * dst_unmul + 0x8000) >> 16;
+		  if (dst > 0xff)
+		    dst = 0xff;
+		}
+	      dst = ((table[dst] >> tshift) * (full - weight) +
+		     (table[src] >> tshift) * weight + half) >> (16 - wshift);
+	      dst = (dst << tshift) + tround;
+	      dstptr[j] = invtab[dst];
+	    }
+
+	  if (alpha_type != ART_ALPHA_NONE)
+	    {
+	      dst_a8 = (dst_alpha * 0xff + 0x8000) >> 16;
+	      dstptr[n_chan] = dst_a8;
+	      if (alpha_type == ART_ALPHA_PREMUL)
+		for (j = 0; j < n_chan; j++)
+		  {
+		    tmp = dstptr[j] * dst_a8 + 0x80;
+		    dstptr[j] = (tmp + (tmp >> 8)) >> 8;
+		  }
+	    }
+
+	  bufptr += buf_pixstride;
+	  dstptr += dst_pixstride;
+	}
+    }
+}
+
+const ArtRenderCallback art_render_composite_8_gamma_obj =
+{
+  art_render_composite_8_gamma,
+  art_render_nop_done
+};
+
+/* Assumes:
+ * alpha_buf is NULL
+ * buf_alpha = ART_ALPHA_NONE  (source)
+ * alpha_type = ART_ALPHA_NONE (dest)
+ * n_chan = 3;
+ */
+static void
+art_render_composite_8_gamma_opaque (ArtRenderCallback *self,
+				     ArtRender *render,
+				     art_u8 *dest, int y)
+{
+  ArtRenderMaskRun *run = render->run;
+  int n_run = render->n_run;
+  int x0 = render->x0;
+  int run_x0, run_x1;
+  art_u8 *image_buf = render->image_buf;
+  const int *table = render->alphagamma->table;
+  const art_u8 *invtab = render->alphagamma->invtable;
+  int wshift = ART_GAMMA_WSHIFT (render->alphagamma);
+  int tshift = ART_GAMMA_TSHIFT (render->alphagamma);
+  int tround = (1 << tshift) >> 1;
+  int i, j, n;
+  art_u32 tmp;
+  art_u32 run_alpha;
+  art_u8 *bufptr;
+  art_u8 *dstptr;
+  int full = 0x10000 >> wshift;
+  int half = 0x8000 >> wshift;
+  int weight;
+  int dst;
+
+  for (i = 0; i < n_run - 1; i++)
+    {
+      run_x0 = run[i].x;
+      run_x1 = run[i + 1].x;
+      tmp = run[i].alpha;
+      if (tmp < 0x10000)
+	continue;
+
+      run_alpha = (tmp + (tmp >> 8) + (tmp >> 16) - 0x8000) >> 8; /* range [0 .. 0x10000] */
+      bufptr = image_buf + (run_x0 - x0) * 3;
+      dstptr = dest + (run_x0 - x0) * 3;
+      n = (run_x1 - run_x0) * 3;
+      /* coverage above full, from overlapping segments, is drawn as
+	 full */
+      if (run_alpha >= 0x10000)
+	{
+	  for (j = 0; j < n; j++)
+	    dstptr[j] = bufptr[j];
+	}
+      else
+	{
+	  weight = run_alpha >> wshift;
+	  for (j = 0; j < n; j++)
+	    {
+	      dst = ((table[dstptr[j]] >> tshift) * (full - weight) +
+		     (table[bufptr[j]] >> tshift) * weight + half) >>
+		(16 - wshift);
+	      dst = (dst << tshift) + tround;
+	      dstptr[j] = invtab[dst];
+	    }
+	}
+    }
+}
+
+const ArtRenderCallback art_render_composite_8_gamma_opaque_obj =
+{
+  art_render_composite_8_gamma_opaque,
+  art_render_nop_done
+};
+
 /* todo: inline */
 static ArtRenderCallback *
 art_render_choose_compositing_callback (ArtRender *render)
 {
+  if (render->depth == 8 && render->buf_depth == 8 &&
+      render->alphagamma != NULL)
+    {
+      if (render->n_chan == 3 &&
+	  render->alpha_buf == NULL &&
+	  render->alpha_type == ART_ALPHA_NONE &&
+	  render->buf_alpha == ART_ALPHA_NONE)
+	return (ArtRenderCallback *)&art_render_composite_8_gamma_opaque_obj;
+      return (ArtRenderCallback *)&art_render_composite_8_gamma_obj;
+    }
   if (render->depth == 8 && render->buf_depth == 8)
     {
       if (render->n_chan == 3 &&
@@ -897,9 +1272,20 @@ art_render_choose_compositing_callback (ArtRender *render)
 	  else if (render->buf_alpha == ART_ALPHA_PREMUL)
 	    return (ArtRenderCallback *)&art_render_composite_8_opt2_obj;
 	}
+      if (render->alpha_buf == NULL &&
+	  render->alpha_type == ART_ALPHA_NONE &&
+	  render->buf_alpha == ART_ALPHA_NONE)
+	return (ArtRenderCallback *)&art_render_composite_8_opaque_obj;
 	  
       return (ArtRenderCallback *)&art_render_composite_8_obj;
     }
+#if ART_MAX_DEPTH >= 16
+  if (render->depth == 16 && render->buf_depth == 16 &&
+      render->alpha_buf == NULL &&
+      render->alpha_type == ART_ALPHA_NONE &&
+      render->buf_alpha == ART_ALPHA_NONE)
+    return (ArtRenderCallback *)&art_render_composite_16_opaque_obj;
+#endif
   return (ArtRenderCallback *)&art_render_composite_obj;
 }
 
@@ -1220,6 +1606,15 @@ art_render_image_solid_rgb8_opaq_init (ArtImageSourceSolid *self, ArtRender *ren
   tmp = ((b_fg - b_bg) << 16) + 0x80;
   db = (tmp + (tmp >> 8)) >> 8;
 
+  if (render->alphagamma != NULL)
+    {
+      art_alphagamma_rgbtab (render->alphagamma,
+			     (r_fg << 16) | (g_fg << 8) | b_fg,
+			     (r_bg << 16) | (g_bg << 8) | b_bg,
+			     rgbtab);
+      return;
+    }
+
   for (i = 0; i < 256; i++)
     {
       rgbtab[i] = (r & 0xff0000) | ((g & 0xff0000) >> 8) | (b >> 16);
@@ -1318,6 +1713,32 @@ art_render_image_solid_rgb8 (ArtRenderCallback *self, ArtRender *render,
   art_rgb_fill_run (render->image_buf, r, g, b, width);
 }
 
+#if ART_MAX_DEPTH >= 16
+
+static void
+art_render_image_solid_16 (ArtRenderCallback *self, ArtRender *render,
+			   art_u8 *dest, int y)
+{
+  ArtImageSourceSolid *z = (ArtImageSourceSolid *)self;
+  int width = render->x1 - render->x0;
+  int n_chan = render->n_chan;
+  art_u16 *bufp = (art_u16 *)render->image_buf;
+  int i, j;
+
+  if (z->init)
+    return;
+  z->init = ART_TRUE;
+
+  for (i = 0; i < width; i++)
+    {
+      for (j = 0; j < n_chan; j++)
+	bufp[j] = z->color[j];
+      bufp += n_chan;
+    }
+}
+
+#endif /* ART_MAX_DEPTH >= 16 */
+
 static void
 art_render_image_solid_negotiate (ArtImageSource *self, ArtRender *render,
 				  ArtImageSourceFlags *p_flags,
@@ -1348,6 +1769,14 @@ art_render_image_solid_negotiate (ArtImageSource *self, ArtRender *render,
 	  *p_buf_depth = 8;
 	  *p_alpha = ART_ALPHA_NONE; /* todo */
 	}
+#if ART_MAX_DEPTH >= 16
+      else if (render->depth == 16)
+	{
+	  render_cbk = art_render_image_solid_16;
+	  *p_buf_depth = 16;
+	  *p_alpha = ART_ALPHA_NONE;
+	}
+#endif
     }
   /* todo: general case */
   self->super.render = render_cbk;
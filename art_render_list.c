@@ -0,0 +1,364 @@
+/*
+ * art_render_list.c: Batched drawing of many shapes with one pass
+ * over the destination.
+ *
+ * Libart_LGPL - library of basic graphic primitives
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#include "config.h"
+#include "art_render_list.h"
+
+#include <math.h>
+#include "art_rect_svp.h"
+#include "art_render_svp.h"
+
+#ifndef MAX
+#define MAX(a, b)  (((a) > (b)) ? (a) : (b))
+#endif /* MAX */
+
+#ifndef MIN
+#define MIN(a, b)  (((a) < (b)) ? (a) : (b))
+#endif /* MIN */
+
+typedef struct _ArtRenderListItem ArtRenderListItem;
+
+struct _ArtRenderListItem {
+  const ArtSVP *svp; /* not yet rasterized, or NULL */
+  const ArtSVPRle *rle;
+  art_boolean own_rle;
+  int dx, dy; /* offset of rle */
+  ArtPixMaxDepth color[ART_MAX_CHAN + 1];
+  int opacity;
+  ArtCompositingMode compositing_mode;
+};
+
+struct _ArtRenderList {
+  /* parameters of destination image, as for art_render_new () */
+  int x0, y0;
+  int x1, y1;
+  art_u8 *pixels;
+  int rowstride;
+  int n_chan;
+  int depth;
+  ArtAlphaType alpha_type;
+  ArtAlphaGamma *alphagamma;
+
+  int band_height;
+
+  int n_items;
+  int n_items_max;
+  ArtRenderListItem *items;
+};
+
+/**
+ * art_render_list_new: Create a new render list.
+ * @x0: Left coordinate of destination rectangle.
+ * @y0: Top coordinate of destination rectangle.
+ * @x1: Right coordinate of destination rectangle.
+ * @y1: Bottom coordinate of destination rectangle.
+ * @pixels: Destination pixel buffer.
+ * @rowstride: Rowstride of @pixels buffer.
+ * @n_chan: Number of color channels.
+ * @depth: Depth of each channel (8 or 16).
+ * @alpha_type: Alpha type of the destination.
+ * @alphagamma: #ArtAlphaGamma for antialiasing, or NULL.
+ *
+ * Creates a list of shapes to be drawn into the destination, which
+ * takes the same parameters as art_render_new(). Shapes are added
+ * with art_render_list_add_svp() and drawn, in the order they were
+ * added, by art_render_list_invoke().
+ *
+ * Drawing each shape with its own render object makes one pass over
+ * the destination per shape, and when the shapes overlap, the rows
+ * have long left the cache by the time the next shape reaches them.
+ * The list instead divides the destination into bands of a few rows
+ * and draws every shape touching a band before moving on to the next
+ * one, so the rows are only fetched once.
+ *
+ * Return value: The new render list.
+ **/
+ArtRenderList *
+art_render_list_new (int x0, int y0, int x1, int y1,
+		     art_u8 *pixels, int rowstride,
+		     int n_chan, int depth, ArtAlphaType alpha_type,
+		     ArtAlphaGamma *alphagamma)
+{
+  ArtRenderList *list;
+
+  if (n_chan > ART_MAX_CHAN)
+    {
+      art_warn ("art_render_list_new: n_chan = %d, exceeds %d max\n",
+		n_chan, ART_MAX_CHAN);
+      return NULL;
+    }
+  if (depth > ART_MAX_DEPTH)
+    {
+      art_warn ("art_render_list_new: depth = %d, exceeds %d max\n",
+		depth, ART_MAX_DEPTH);
+      return NULL;
+    }
+
+  list = art_new (ArtRenderList, 1);
+  list->x0 = x0;
+  list->y0 = y0;
+  list->x1 = x1;
+  list->y1 = y1;
+  list->pixels = pixels;
+  list->rowstride = rowstride;
+  list->n_chan = n_chan;
+  list->depth = depth;
+  list->alpha_type = alpha_type;
+  list->alphagamma = alphagamma;
+
+  list->band_height = ART_RENDER_LIST_BAND_HEIGHT;
+
+  list->n_items = 0;
+  list->n_items_max = 16;
+  list->items = art_new (ArtRenderListItem, list->n_items_max);
+
+  return list;
+}
+
+/**
+ * art_render_list_free: Free a render list.
+ * @list: The render list.
+ *
+ * Frees @list, along with the masks it made from the svps added to it.
+ **/
+void
+art_render_list_free (ArtRenderList *list)
+{
+  int i;
+
+  for (i = 0; i < list->n_items; i++)
+    if (list->items[i].own_rle)
+      art_svp_rle_free ((ArtSVPRle *)list->items[i].rle);
+  art_free (list->items);
+  art_free (list);
+}
+
+/**
+ * art_render_list_set_band_height: Set the number of rows per band.
+ * @list: The render list.
+ * @band_height: Rows per band.
+ *
+ * Sets the height of the bands art_render_list_invoke() draws the
+ * shapes in. The band should be small enough for its rows to stay in
+ * the cache while all the shapes are drawn, but each shape has some
+ * setup cost per band, so very thin bands are slow as well. The
+ * default is %ART_RENDER_LIST_BAND_HEIGHT.
+ **/
+void
+art_render_list_set_band_height (ArtRenderList *list, int band_height)
+{
+  list->band_height = MAX (band_height, 1);
+}
+
+static ArtRenderListItem *
+art_render_list_add_item (ArtRenderList *list,
+			  const ArtPixMaxDepth *color, int opacity,
+			  ArtCompositingMode compositing_mode)
+{
+  ArtRenderListItem *item;
+  int i;
+
+  if (list->n_items == list->n_items_max)
+    art_expand (list->items, ArtRenderListItem, list->n_items_max);
+  item = &list->items[list->n_items++];
+
+  /* like art_render_image_solid (), only the color channels */
+  for (i = 0; i < list->n_chan; i++)
+    item->color[i] = color[i];
+  item->opacity = opacity;
+  item->compositing_mode = compositing_mode;
+  item->svp = NULL;
+  item->rle = NULL;
+  item->own_rle = ART_FALSE;
+  item->dx = 0;
+  item->dy = 0;
+  return item;
+}
+
+/**
+ * art_render_list_add_svp: Add a shape to a render list.
+ * @list: The render list.
+ * @svp: The shape.
+ * @color: Color of the shape, as for art_render_image_solid().
+ * @opacity: Opacity in [0..0x10000], as for art_render_mask_solid().
+ * @compositing_mode: Compositing mode, see #ArtRender.
+ *
+ * Adds @svp to @list, to be drawn over the shapes added before it.
+ * Note: @svp must remain allocated until art_render_list_prepare() or
+ * art_render_list_invoke() is called on @list.
+ **/
+void
+art_render_list_add_svp (ArtRenderList *list, const ArtSVP *svp,
+			 const ArtPixMaxDepth *color, int opacity,
+			 ArtCompositingMode compositing_mode)
+{
+  ArtRenderListItem *item;
+
+  item = art_render_list_add_item (list, color, opacity, compositing_mode);
+  item->svp = svp;
+}
+
+/**
+ * art_render_list_add_rle: Add a run-length coverage mask to a render list.
+ * @list: The render list.
+ * @rle: The mask, as created by art_svp_render_to_rle().
+ * @dx: Horizontal offset of the mask, in pixels.
+ * @dy: Vertical offset of the mask, in pixels.
+ * @color: Color of the shape, as for art_render_image_solid().
+ * @opacity: Opacity in [0..0x10000], as for art_render_mask_solid().
+ * @compositing_mode: Compositing mode, see #ArtRender.
+ *
+ * Like art_render_list_add_svp(), but for a shape that has already
+ * been rasterized, drawn moved by (@dx, @dy). Note: @rle must remain
+ * allocated until @list is freed.
+ **/
+void
+art_render_list_add_rle (ArtRenderList *list, const ArtSVPRle *rle,
+			 int dx, int dy,
+			 const ArtPixMaxDepth *color, int opacity,
+			 ArtCompositingMode compositing_mode)
+{
+  ArtRenderListItem *item;
+
+  item = art_render_list_add_item (list, color, opacity, compositing_mode);
+  item->rle = rle;
+  item->dx = dx;
+  item->dy = dy;
+}
+
+/**
+ * art_render_list_prepare: Rasterize the shapes of a render list.
+ * @list: The render list.
+ *
+ * Rasterizes the svps added to @list into run-length coverage masks,
+ * clipped to the destination rectangle. art_render_list_invoke() does
+ * this itself; it is only needed before art_render_list_render_band().
+ **/
+void
+art_render_list_prepare (ArtRenderList *list)
+{
+  ArtRenderListItem *item;
+  ArtDRect bbox;
+  int x0, y0, x1, y1;
+  int i;
+
+  for (i = 0; i < list->n_items; i++)
+    {
+      item = &list->items[i];
+      if (item->svp == NULL)
+	continue;
+
+      art_drect_svp (&bbox, item->svp);
+      x0 = MAX (list->x0, (int)floor (bbox.x0));
+      y0 = MAX (list->y0, (int)floor (bbox.y0));
+      x1 = MIN (list->x1, (int)ceil (bbox.x1) + 1);
+      y1 = MIN (list->y1, (int)ceil (bbox.y1) + 1);
+      if (x1 <= x0 || y1 <= y0)
+	x0 = y0 = x1 = y1 = 0;
+      item->rle = art_svp_render_to_rle (item->svp, x0, y0, x1, y1);
+      item->own_rle = ART_TRUE;
+      item->svp = NULL;
+    }
+}
+
+/**
+ * art_render_list_render_band: Draw one band of a render list.
+ * @list: The render list.
+ * @y0: Top coordinate of the band.
+ * @y1: Bottom coordinate of the band.
+ *
+ * Draws all the shapes of @list, in order, within rows @y0 (inclusive)
+ * to @y1 (exclusive). art_render_list_prepare() must have been called
+ * after the last shape was added.
+ *
+ * Drawing a band writes only the rows of that band and leaves @list
+ * unchanged, so the bands of a prepared list can be drawn in any order.
+ * Rendering uses state shared by the whole library, so bands may not be
+ * drawn from several threads at once.
+ **/
+void
+art_render_list_render_band (ArtRenderList *list, int y0, int y1)
+{
+  const ArtRenderListItem *item;
+  const ArtSVPRle *rle;
+  ArtRender *render;
+  int bytespp;
+  int ix0, iy0, ix1, iy1;
+  int i;
+
+  bytespp = ((list->n_chan + (list->alpha_type != ART_ALPHA_NONE)) *
+	     list->depth) >> 3;
+  y0 = MAX (y0, list->y0);
+  y1 = MIN (y1, list->y1);
+
+  for (i = 0; i < list->n_items; i++)
+    {
+      item = &list->items[i];
+      rle = item->rle;
+      if (rle == NULL)
+	{
+	  art_warn ("art_render_list_render_band: list is not prepared\n");
+	  return;
+	}
+      if (item->opacity <= 0)
+	continue;
+
+      ix0 = MAX (list->x0, rle->x0 + item->dx);
+      iy0 = MAX (y0, rle->y0 + item->dy);
+      ix1 = MIN (list->x1, rle->x1 + item->dx);
+      iy1 = MIN (y1, rle->y1 + item->dy);
+      if (ix1 <= ix0 || iy1 <= iy0)
+	continue;
+
+      render = art_render_new (ix0, iy0, ix1, iy1,
+			       list->pixels +
+			       (iy0 - list->y0) * list->rowstride +
+			       (ix0 - list->x0) * bytespp,
+			       list->rowstride,
+			       list->n_chan, list->depth, list->alpha_type,
+			       list->alphagamma);
+      render->compositing_mode = item->compositing_mode;
+      art_render_svp_rle_offset (render, rle, item->dx, item->dy);
+      if (item->opacity < 0x10000)
+	art_render_mask_solid (render, item->opacity);
+      art_render_image_solid (render, (ArtPixMaxDepth *)item->color);
+      art_render_invoke (render);
+    }
+}
+
+/**
+ * art_render_list_invoke: Draw a render list.
+ * @list: The render list.
+ *
+ * Draws all the shapes of @list into the destination, in the order
+ * they were added, band by band.
+ **/
+void
+art_render_list_invoke (ArtRenderList *list)
+{
+  int y;
+
+  art_render_list_prepare (list);
+  for (y = list->y0; y < list->y1; y += list->band_height)
+    art_render_list_render_band (list, y,
+				 MIN (y + list->band_height, list->y1));
+}
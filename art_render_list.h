@@ -0,0 +1,81 @@
+/*
+ * art_render_list.h: Batched drawing of many shapes with one pass
+ * over the destination.
+ *
+ * Libart_LGPL - library of basic graphic primitives
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifndef __ART_RENDER_LIST_H__
+#define __ART_RENDER_LIST_H__
+
+#ifdef LIBART_COMPILATION
+#include "art_render.h"
+#include "art_svp.h"
+#include "art_svp_rle.h"
+#else
+#include <libart_lgpl/art_render.h>
+#include <libart_lgpl/art_svp.h>
+#include <libart_lgpl/art_svp_rle.h>
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+typedef struct _ArtRenderList ArtRenderList;
+
+/* Rows per band when none is set with art_render_list_set_band_height. */
+#define ART_RENDER_LIST_BAND_HEIGHT 16
+
+ArtRenderList *
+art_render_list_new (int x0, int y0, int x1, int y1,
+		     art_u8 *pixels, int rowstride,
+		     int n_chan, int depth, ArtAlphaType alpha_type,
+		     ArtAlphaGamma *alphagamma);
+
+void
+art_render_list_free (ArtRenderList *list);
+
+void
+art_render_list_set_band_height (ArtRenderList *list, int band_height);
+
+void
+art_render_list_add_svp (ArtRenderList *list, const ArtSVP *svp,
+			 const ArtPixMaxDepth *color, int opacity,
+			 ArtCompositingMode compositing_mode);
+
+void
+art_render_list_add_rle (ArtRenderList *list, const ArtSVPRle *rle,
+			 int dx, int dy,
+			 const ArtPixMaxDepth *color, int opacity,
+			 ArtCompositingMode compositing_mode);
+
+void
+art_render_list_prepare (ArtRenderList *list);
+
+void
+art_render_list_render_band (ArtRenderList *list, int y0, int y1);
+
+void
+art_render_list_invoke (ArtRenderList *list);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __ART_RENDER_LIST_H__ */
@@ -0,0 +1,264 @@
+/*
+ * art_render_pattern.c: Image pattern source for modular rendering.
+ *
+ * Libart_LGPL - library of basic graphic primitives
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#include "config.h"
+#include "art_render_pattern.h"
+
+#include <math.h>
+#include "art_affine.h"
+
+typedef struct _ArtImageSourcePattern ArtImageSourcePattern;
+
+struct _ArtImageSourcePattern {
+  ArtImageSource super;
+  const ArtPixBuf *pixbuf;
+  double inv[6]; /* maps destination to source image coordinates */
+  ArtPatternSpread spread;
+  ArtFilterLevel level;
+  art_boolean has_alpha; /* image_buf carries premultiplied alpha */
+};
+
+static void
+art_render_image_pattern_done (ArtRenderCallback *self, ArtRender *render)
+{
+  art_free (self);
+}
+
+/* Map the integer coordinate @i into [0..@size), according to the
+   spread mode. Returns -1 if the coordinate lies outside the image
+   and @spread is ART_PATTERN_NONE. */
+static int
+art_pattern_wrap (int i, int size, ArtPatternSpread spread)
+{
+  switch (spread)
+    {
+    case ART_PATTERN_PAD:
+      if (i < 0)
+	return 0;
+      if (i >= size)
+	return size - 1;
+      return i;
+    case ART_PATTERN_REPEAT:
+      i %= size;
+      if (i < 0)
+	i += size;
+      return i;
+    case ART_PATTERN_REFLECT:
+      i %= size << 1;
+      if (i < 0)
+	i += size << 1;
+      if (i >= size)
+	i = (size << 1) - 1 - i;
+      return i;
+    default: /* ART_PATTERN_NONE */
+      if (i < 0 || i >= size)
+	return -1;
+      return i;
+    }
+}
+
+/* Fetch the source pixel at (@sx, @sy) in premultiplied form, each
+   sample in the range 0..255. */
+static void
+art_pattern_fetch (const ArtImageSourcePattern *z, int sx, int sy, int *pix)
+{
+  const ArtPixBuf *pixbuf = z->pixbuf;
+  const art_u8 *p;
+  int tmp;
+  int a;
+
+  sx = art_pattern_wrap (sx, pixbuf->width, z->spread);
+  sy = art_pattern_wrap (sy, pixbuf->height, z->spread);
+  if (sx < 0 || sy < 0)
+    {
+      pix[0] = pix[1] = pix[2] = pix[3] = 0;
+      return;
+    }
+
+  p = pixbuf->pixels + sy * pixbuf->rowstride + sx * pixbuf->n_channels;
+  if (pixbuf->format == ART_PIX_RGB_PREMUL)
+    {
+      pix[0] = p[0];
+      pix[1] = p[1];
+      pix[2] = p[2];
+      pix[3] = p[3];
+    }
+  else if (pixbuf->has_alpha)
+    {
+      a = p[3];
+      tmp = p[0] * a + 0x80;
+      pix[0] = (tmp + (tmp >> 8)) >> 8;
+      tmp = p[1] * a + 0x80;
+      pix[1] = (tmp + (tmp >> 8)) >> 8;
+      tmp = p[2] * a + 0x80;
+      pix[2] = (tmp + (tmp >> 8)) >> 8;
+      pix[3] = a;
+    }
+  else
+    {
+      pix[0] = p[0];
+      pix[1] = p[1];
+      pix[2] = p[2];
+      pix[3] = 0xff;
+    }
+}
+
+static void
+art_render_image_pattern_render_8 (ArtRenderCallback *self, ArtRender *render,
+				   art_u8 *dest, int y)
+{
+  ArtImageSourcePattern *z = (ArtImageSourcePattern *)self;
+  const double *inv = z->inv;
+  int x0 = render->x0;
+  int width = render->x1 - x0;
+  int pixstride = z->has_alpha ? 4 : 3;
+  art_boolean bilinear = (z->level == ART_FILTER_BILINEAR ||
+			  z->level == ART_FILTER_HYPER);
+  art_u8 *bufp = render->image_buf;
+  double sx0, sy0;
+  int x, j;
+  int pix[4];
+
+  sx0 = inv[0] * (x0 + 0.5) + inv[2] * (y + 0.5) + inv[4];
+  sy0 = inv[1] * (x0 + 0.5) + inv[3] * (y + 0.5) + inv[5];
+  if (bilinear)
+    {
+      /* sample centers are at half-integer coordinates */
+      sx0 -= 0.5;
+      sy0 -= 0.5;
+    }
+
+  for (x = 0; x < width; x++)
+    {
+      double sx = sx0 + x * inv[0];
+      double sy = sy0 + x * inv[1];
+      double fx = floor (sx);
+      double fy = floor (sy);
+
+      if (!bilinear)
+	art_pattern_fetch (z, (int)fx, (int)fy, pix);
+      else
+	{
+	  int ix = (int)fx, iy = (int)fy;
+	  int wx = (int)((sx - fx) * 256 + 0.5);
+	  int wy = (int)((sy - fy) * 256 + 0.5);
+	  int w00, w10, w01, w11;
+	  int p00[4], p10[4], p01[4], p11[4];
+
+	  art_pattern_fetch (z, ix, iy, p00);
+	  art_pattern_fetch (z, ix + 1, iy, p10);
+	  art_pattern_fetch (z, ix, iy + 1, p01);
+	  art_pattern_fetch (z, ix + 1, iy + 1, p11);
+	  /* weights sum to 0x10000 */
+	  w00 = (256 - wx) * (256 - wy);
+	  w10 = wx * (256 - wy);
+	  w01 = (256 - wx) * wy;
+	  w11 = wx * wy;
+	  for (j = 0; j < 4; j++)
+	    pix[j] = (p00[j] * w00 + p10[j] * w10 +
+		      p01[j] * w01 + p11[j] * w11 + 0x8000) >> 16;
+	}
+
+      bufp[0] = pix[0];
+      bufp[1] = pix[1];
+      bufp[2] = pix[2];
+      if (z->has_alpha)
+	bufp[3] = pix[3];
+      bufp += pixstride;
+    }
+}
+
+static void
+art_render_image_pattern_negotiate (ArtImageSource *self, ArtRender *render,
+				    ArtImageSourceFlags *p_flags,
+				    int *p_buf_depth, ArtAlphaType *p_alpha)
+{
+  ArtImageSourcePattern *z = (ArtImageSourcePattern *)self;
+
+  self->super.render = art_render_image_pattern_render_8;
+  *p_flags = 0;
+  *p_buf_depth = 8;
+  *p_alpha = z->has_alpha ? ART_ALPHA_PREMUL : ART_ALPHA_NONE;
+}
+
+/**
+ * art_render_image_pattern: Add an image pattern image source.
+ * @render: The render object.
+ * @pixbuf: Source image, 8 bit RGB or RGBA.
+ * @affine: Affine transform from image to destination coordinates.
+ * @spread: How the image is extended beyond its bounds.
+ * @level: Filter level.
+ *
+ * Adds @pixbuf, transformed by @affine, as the image source for
+ * rendering in the render object @render. Combined with a mask source
+ * such as art_render_svp(), this fills a shape with an image or a
+ * tiled texture in a single pass.
+ *
+ * The @level parameter specifies the speed/quality tradeoff of the
+ * image interpolation. ART_FILTER_NEAREST and ART_FILTER_TILES sample
+ * the nearest pixel, ART_FILTER_BILINEAR and ART_FILTER_HYPER
+ * interpolate bilinearly.
+ *
+ * Note: @pixbuf must remain allocated until art_render_invoke() is
+ * called on @render.
+ **/
+void
+art_render_image_pattern (ArtRender *render,
+			  const ArtPixBuf *pixbuf,
+			  const double affine[6],
+			  ArtPatternSpread spread,
+			  ArtFilterLevel level)
+{
+  ArtImageSourcePattern *image_source;
+
+  if ((pixbuf->format != ART_PIX_RGB && pixbuf->format != ART_PIX_RGB_PREMUL) ||
+      pixbuf->bits_per_sample != 8 ||
+      pixbuf->n_channels != 3 + (pixbuf->has_alpha != 0))
+    {
+      art_warn ("art_render_image_pattern: need 8-bit RGB or RGBA image\n");
+      return;
+    }
+  if (render->n_chan != 3)
+    {
+      art_warn ("art_render_image_pattern: called on render with %d channels, only works with 3\n",
+		render->n_chan);
+      return;
+    }
+  if (pixbuf->width <= 0 || pixbuf->height <= 0 ||
+      affine[0] * affine[3] - affine[1] * affine[2] == 0)
+    {
+      art_warn ("art_render_image_pattern: empty image or singular affine\n");
+      return;
+    }
+
+  image_source = art_new (ArtImageSourcePattern, 1);
+  image_source->super.super.render = NULL;
+  image_source->super.super.done = art_render_image_pattern_done;
+  image_source->super.negotiate = art_render_image_pattern_negotiate;
+
+  image_source->pixbuf = pixbuf;
+  art_affine_invert (image_source->inv, affine);
+  image_source->spread = spread;
+  image_source->level = level;
+  image_source->has_alpha = pixbuf->has_alpha || spread == ART_PATTERN_NONE;
+
+  art_render_add_image_source (render, &image_source->super);
+}
@@ -0,0 +1,62 @@
+/*
+ * art_render_pattern.h: Image pattern source for modular rendering.
+ *
+ * Libart_LGPL - library of basic graphic primitives
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifndef __ART_RENDER_PATTERN_H__
+#define __ART_RENDER_PATTERN_H__
+
+#ifdef LIBART_COMPILATION
+#include "art_filterlevel.h"
+#include "art_pixbuf.h"
+#include "art_render.h"
+#else
+#include <libart_lgpl/art_filterlevel.h>
+#include <libart_lgpl/art_pixbuf.h>
+#include <libart_lgpl/art_render.h>
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+typedef enum {
+  ART_PATTERN_NONE,
+  ART_PATTERN_PAD,
+  ART_PATTERN_REFLECT,
+  ART_PATTERN_REPEAT
+} ArtPatternSpread;
+
+/* NONE leaves everything outside the source image transparent, which
+   is what the art_rgb_*_affine functions do. PAD extends the edge
+   pixels, REFLECT mirrors the image at every edge and REPEAT tiles
+   it. */
+
+void
+art_render_image_pattern (ArtRender *render,
+			  const ArtPixBuf *pixbuf,
+			  const double affine[6],
+			  ArtPatternSpread spread,
+			  ArtFilterLevel level);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __ART_RENDER_PATTERN_H__ */
@@ -24,19 +24,33 @@
 
 #include "art_render_svp.h"
 #include "art_svp_render_aa.h"
+#include "art_svp_rle.h"
+
+#include <math.h>
+#include <string.h>
 
 typedef struct _ArtMaskSourceSVP ArtMaskSourceSVP;
+typedef struct _ArtSVPCacheEntry ArtSVPCacheEntry;
 
 struct _ArtMaskSourceSVP {
   ArtMaskSource super;
   ArtRender *render;
   const ArtSVP *svp;
+  const ArtSVPRle *rle;
+  int dx, dy; /* offset of rle */
+  ArtSVPCacheEntry *entry; /* cache entry holding rle, or NULL */
   art_u8 *dest_ptr;
 };
 
+static void art_svp_cache_entry_unref (ArtSVPCacheEntry *entry);
+
 static void
 art_render_svp_done (ArtRenderCallback *self, ArtRender *render)
 {
+  ArtMaskSourceSVP *z = (ArtMaskSourceSVP *)self;
+
+  if (z->entry != NULL)
+    art_svp_cache_entry_unref (z->entry);
   art_free (self);
 }
 
@@ -355,38 +369,58 @@ art_render_svp_callback_opacity_span (void *callback_data, int y,
   z->dest_ptr += render->rowstride;
 }
 
-static void
-art_render_svp_invoke_driver (ArtMaskSource *self, ArtRender *render)
-{
-  ArtMaskSourceSVP *z = (ArtMaskSourceSVP *)self;
-  void (*callback) (void *callback_data,
-		    int y,
-		    int start,
-		    ArtSVPRenderAAStep *steps, int n_steps);
+typedef void (*ArtRenderSVPCallback) (void *callback_data,
+				      int y,
+				      int start,
+				      ArtSVPRenderAAStep *steps, int n_steps);
 
-  z->dest_ptr = render->pixels;
+static ArtRenderSVPCallback
+art_render_svp_choose_callback (ArtRender *render)
+{
   if (render->opacity == 0x10000)
     {
       if (render->need_span)
-	callback = art_render_svp_callback_span;
+	return art_render_svp_callback_span;
       else
-	callback = art_render_svp_callback;
+	return art_render_svp_callback;
     }
   else
     {
       if (render->need_span)
-	callback = art_render_svp_callback_opacity_span;
+	return art_render_svp_callback_opacity_span;
       else
-	callback = art_render_svp_callback_opacity;
+	return art_render_svp_callback_opacity;
     }
+}
 
+static void
+art_render_svp_invoke_driver (ArtMaskSource *self, ArtRender *render)
+{
+  ArtMaskSourceSVP *z = (ArtMaskSourceSVP *)self;
+
+  z->dest_ptr = render->pixels;
   art_svp_render_aa (z->svp,
 		     render->x0, render->y0,
-		     render->x1, render->y1, callback,
+		     render->x1, render->y1,
+		     art_render_svp_choose_callback (render),
 		     self);
   art_render_svp_done (&self->super, render);
 }
 
+static void
+art_render_svp_rle_invoke_driver (ArtMaskSource *self, ArtRender *render)
+{
+  ArtMaskSourceSVP *z = (ArtMaskSourceSVP *)self;
+
+  z->dest_ptr = render->pixels;
+  art_svp_rle_render_aa_offset (z->rle, z->dx, z->dy,
+				render->x0, render->y0,
+				render->x1, render->y1,
+				art_render_svp_choose_callback (render),
+				self);
+  art_render_svp_done (&self->super, render);
+}
+
 static void
 art_render_svp_prepare (ArtMaskSource *self, ArtRender *render,
 			art_boolean first)
@@ -416,6 +450,489 @@ art_render_svp (ArtRender *render, const ArtSVP *svp)
   mask_source->super.prepare = art_render_svp_prepare;
   mask_source->render = render;
   mask_source->svp = svp;
+  mask_source->rle = NULL;
+  mask_source->entry = NULL;
+
+  art_render_add_mask_source (render, &mask_source->super);
+}
+
+/**
+ * art_render_svp_rle: Use a run-length coverage mask as a render mask source.
+ * @render: Render object.
+ * @rle: Mask, as created by art_svp_render_to_rle().
+ *
+ * Adds @rle to the render object as a mask. The result is the same as
+ * adding the svp the mask was made from with art_render_svp(), within
+ * the rectangle of the mask, but the svp is not rasterized again.
+ * Note: @rle must remain allocated until art_render_invoke() is called
+ * on @render.
+ **/
+void
+art_render_svp_rle (ArtRender *render, const ArtSVPRle *rle)
+{
+  art_render_svp_rle_offset (render, rle, 0, 0);
+}
+
+/**
+ * art_render_svp_rle_offset: Use a translated coverage mask as a render mask source.
+ * @render: Render object.
+ * @rle: Mask, as created by art_svp_render_to_rle().
+ * @dx: Horizontal offset of the mask, in pixels.
+ * @dy: Vertical offset of the mask, in pixels.
+ *
+ * Like art_render_svp_rle(), but with @rle moved by (@dx, @dy).
+ **/
+void
+art_render_svp_rle_offset (ArtRender *render, const ArtSVPRle *rle,
+			   int dx, int dy)
+{
+  ArtMaskSourceSVP *mask_source;
+  mask_source = art_new (ArtMaskSourceSVP, 1);
+
+  mask_source->super.super.render = NULL;
+  mask_source->super.super.done = art_render_svp_done;
+  mask_source->super.can_drive = art_render_svp_can_drive;
+  mask_source->super.invoke_driver = art_render_svp_rle_invoke_driver;
+  mask_source->super.prepare = art_render_svp_prepare;
+  mask_source->render = render;
+  mask_source->svp = NULL;
+  mask_source->rle = rle;
+  mask_source->dx = dx;
+  mask_source->dy = dy;
+  mask_source->entry = NULL;
+
+  art_render_add_mask_source (render, &mask_source->super);
+}
+
+/* The coverage cache is a hash table of masks made by
+   art_svp_render_to_rle(), keyed by the contents of the svp and the
+   fractional part of its offset, with the entries also on a list in
+   order of use. Each entry keeps a copy of the directions, lengths and
+   points of the segments, which a lookup compares in full. A mask source holds a reference to its entry, so an
+   entry evicted while a render is pending is freed when that render
+   is done with it. */
+
+struct _ArtSVPCacheEntry {
+  ArtSVPCacheEntry *next; /* in hash bucket */
+  ArtSVPCacheEntry *lru_prev; /* more recently used */
+  ArtSVPCacheEntry *lru_next; /* less recently used */
+  ArtSVPCache *cache; /* NULL once evicted */
+  art_u32 hash;
+  int n_segs, n_points;
+  int *seg_info; /* dir and n_points of each segment */
+  ArtPoint *points; /* points of all segments in order */
+  int fx, fy;
+  int n_bytes;
+  int refcount;
+  ArtSVPRle *rle;
+};
+
+struct _ArtSVPCache {
+  int max_bytes;
+  int n_buckets; /* a power of 2 */
+  ArtSVPCacheEntry **buckets;
+  ArtSVPCacheEntry *lru_first, *lru_last;
+  ArtSVPCacheStats stats;
+};
+
+/**
+ * art_svp_cache_new: Create a new coverage cache.
+ * @max_bytes: Memory budget of the cache, in bytes.
+ *
+ * Creates a cache for art_render_svp_cached(). When the masks held
+ * by the cache take more than @max_bytes, the least recently used ones
+ * are dropped.
+ *
+ * Return value: The new cache, to be freed with art_svp_cache_free().
+ **/
+ArtSVPCache *
+art_svp_cache_new (int max_bytes)
+{
+  ArtSVPCache *cache;
+  int i;
+
+  cache = art_new (ArtSVPCache, 1);
+  cache->max_bytes = max_bytes;
+  cache->n_buckets = 64;
+  cache->buckets = art_new (ArtSVPCacheEntry *, cache->n_buckets);
+  for (i = 0; i < cache->n_buckets; i++)
+    cache->buckets[i] = NULL;
+  cache->lru_first = NULL;
+  cache->lru_last = NULL;
+  cache->stats.n_entries = 0;
+  cache->stats.n_bytes = 0;
+  art_svp_cache_reset_stats (cache);
+  return cache;
+}
+
+static void
+art_svp_cache_entry_free (ArtSVPCacheEntry *entry)
+{
+  art_svp_rle_free (entry->rle);
+  art_free (entry->seg_info);
+  art_free (entry->points);
+  art_free (entry);
+}
+
+static void
+art_svp_cache_entry_unref (ArtSVPCacheEntry *entry)
+{
+  if (--entry->refcount == 0 && entry->cache == NULL)
+    art_svp_cache_entry_free (entry);
+}
+
+/* Take @entry out of its cache. It is freed here unless it is still
+   in use, in which case the last art_svp_cache_entry_unref() frees
+   it. */
+static void
+art_svp_cache_remove (ArtSVPCache *cache, ArtSVPCacheEntry *entry)
+{
+  ArtSVPCacheEntry **p_entry;
+
+  for (p_entry = &cache->buckets[entry->hash & (cache->n_buckets - 1)];
+       *p_entry != entry; p_entry = &(*p_entry)->next);
+  *p_entry = entry->next;
+
+  if (entry->lru_prev != NULL)
+    entry->lru_prev->lru_next = entry->lru_next;
+  else
+    cache->lru_first = entry->lru_next;
+  if (entry->lru_next != NULL)
+    entry->lru_next->lru_prev = entry->lru_prev;
+  else
+    cache->lru_last = entry->lru_prev;
+
+  cache->stats.n_entries--;
+  cache->stats.n_bytes -= entry->n_bytes;
+  entry->cache = NULL;
+  if (entry->refcount == 0)
+    art_svp_cache_entry_free (entry);
+}
+
+/**
+ * art_svp_cache_free: Free a coverage cache.
+ * @cache: The cache.
+ *
+ * Frees @cache and the masks it holds. Renders which use masks from
+ * the cache and have not been invoked yet remain valid.
+ **/
+void
+art_svp_cache_free (ArtSVPCache *cache)
+{
+  while (cache->lru_first != NULL)
+    art_svp_cache_remove (cache, cache->lru_first);
+  art_free (cache->buckets);
+  art_free (cache);
+}
+
+/**
+ * art_svp_cache_get_stats: Get the counters of a coverage cache.
+ * @cache: The cache.
+ * @stats: Where to store the counters.
+ *
+ * Stores the number of lookups in @cache which found a mask and which
+ * had to rasterize the svp, and the number of masks dropped to stay
+ * within the memory budget, since the last art_svp_cache_reset_stats(),
+ * along with the number of masks currently held and their size.
+ **/
+void
+art_svp_cache_get_stats (const ArtSVPCache *cache, ArtSVPCacheStats *stats)
+{
+  *stats = cache->stats;
+}
+
+/**
+ * art_svp_cache_reset_stats: Reset the counters of a coverage cache.
+ * @cache: The cache.
+ *
+ * Sets the hit, miss and eviction counters of @cache to zero.
+ **/
+void
+art_svp_cache_reset_stats (ArtSVPCache *cache)
+{
+  cache->stats.n_hits = 0;
+  cache->stats.n_misses = 0;
+  cache->stats.n_evictions = 0;
+}
+
+/* FNV-1a hash of the segments of @svp. */
+static art_u32
+art_svp_cache_hash (const ArtSVP *svp, int *pn_points)
+{
+  art_u32 hash = 2166136261U;
+  const art_u8 *p;
+  int n_points = 0;
+  int i, j, n_bytes;
+
+#define ART_HASH_BYTE(b) (hash = (hash ^ (b)) * 16777619U)
+  for (i = 0; i < svp->n_segs; i++)
+    {
+      const ArtSVPSeg *seg = &svp->segs[i];
+
+      ART_HASH_BYTE (seg->dir);
+      ART_HASH_BYTE (seg->n_points & 0xff);
+      ART_HASH_BYTE (seg->n_points >> 8);
+      p = (const art_u8 *)seg->points;
+      n_bytes = seg->n_points * sizeof (ArtPoint);
+      for (j = 0; j < n_bytes; j++)
+	ART_HASH_BYTE (p[j]);
+      n_points += seg->n_points;
+    }
+#undef ART_HASH_BYTE
+
+  *pn_points = n_points;
+  return hash;
+}
+
+/* Whether @entry holds the segments of @svp. */
+static art_boolean
+art_svp_cache_match (const ArtSVPCacheEntry *entry, const ArtSVP *svp)
+{
+  const ArtPoint *points = entry->points;
+  int i;
+
+  for (i = 0; i < svp->n_segs; i++)
+    {
+      const ArtSVPSeg *seg = &svp->segs[i];
+
+      if (entry->seg_info[2 * i] != seg->dir ||
+	  entry->seg_info[2 * i + 1] != seg->n_points ||
+	  memcmp (points, seg->points, seg->n_points * sizeof (ArtPoint)))
+	return ART_FALSE;
+      points += seg->n_points;
+    }
+  return ART_TRUE;
+}
+
+/* Copy the segments of @svp into @entry for art_svp_cache_match(). */
+static void
+art_svp_cache_copy_segs (ArtSVPCacheEntry *entry, const ArtSVP *svp)
+{
+  ArtPoint *points;
+  int i;
+
+  entry->seg_info = art_new (int, 2 * svp->n_segs + 1);
+  entry->points = art_new (ArtPoint, entry->n_points + 1);
+  points = entry->points;
+  for (i = 0; i < svp->n_segs; i++)
+    {
+      const ArtSVPSeg *seg = &svp->segs[i];
+
+      entry->seg_info[2 * i] = seg->dir;
+      entry->seg_info[2 * i + 1] = seg->n_points;
+      memcpy (points, seg->points, seg->n_points * sizeof (ArtPoint));
+      points += seg->n_points;
+    }
+}
+
+/* Double the number of hash buckets. */
+static void
+art_svp_cache_grow (ArtSVPCache *cache)
+{
+  ArtSVPCacheEntry **buckets;
+  ArtSVPCacheEntry *entry, *next;
+  int n_buckets = cache->n_buckets << 1;
+  int i, ix;
+
+  buckets = art_new (ArtSVPCacheEntry *, n_buckets);
+  for (i = 0; i < n_buckets; i++)
+    buckets[i] = NULL;
+  for (i = 0; i < cache->n_buckets; i++)
+    for (entry = cache->buckets[i]; entry != NULL; entry = next)
+      {
+	next = entry->next;
+	ix = entry->hash & (n_buckets - 1);
+	entry->next = buckets[ix];
+	buckets[ix] = entry;
+      }
+  art_free (cache->buckets);
+  cache->buckets = buckets;
+  cache->n_buckets = n_buckets;
+}
+
+/* Rasterize @svp moved by (@tx, @ty) into a mask covering its bounding
+   box. */
+static ArtSVPRle *
+art_svp_cache_render (const ArtSVP *svp, double tx, double ty)
+{
+  ArtSVP *moved;
+  ArtPoint *points, *p;
+  ArtSVPRle *rle;
+  double x0, y0, x1, y1;
+  int n_points = 0;
+  int i, j;
+
+  if (svp->n_segs == 0)
+    return art_svp_render_to_rle (svp, 0, 0, 0, 0);
+
+  for (i = 0; i < svp->n_segs; i++)
+    n_points += svp->segs[i].n_points;
+
+  moved = (ArtSVP *)art_alloc (sizeof (ArtSVP) +
+			       (svp->n_segs - 1) * sizeof (ArtSVPSeg));
+  points = art_new (ArtPoint, n_points);
+  moved->n_segs = svp->n_segs;
+  x0 = y0 = 1e12;
+  x1 = y1 = -1e12;
+  p = points;
+  for (i = 0; i < svp->n_segs; i++)
+    {
+      const ArtSVPSeg *seg = &svp->segs[i];
+      ArtSVPSeg *dst = &moved->segs[i];
+
+      dst->n_points = seg->n_points;
+      dst->dir = seg->dir;
+      dst->points = p;
+      for (j = 0; j < seg->n_points; j++)
+	{
+	  p[j].x = seg->points[j].x + tx;
+	  p[j].y = seg->points[j].y + ty;
+	}
+      p += seg->n_points;
+      dst->bbox.x0 = seg->bbox.x0 + tx;
+      dst->bbox.y0 = seg->bbox.y0 + ty;
+      dst->bbox.x1 = seg->bbox.x1 + tx;
+      dst->bbox.y1 = seg->bbox.y1 + ty;
+      if (dst->bbox.x0 < x0)
+	x0 = dst->bbox.x0;
+      if (dst->bbox.y0 < y0)
+	y0 = dst->bbox.y0;
+      if (dst->bbox.x1 > x1)
+	x1 = dst->bbox.x1;
+      if (dst->bbox.y1 > y1)
+	y1 = dst->bbox.y1;
+    }
+
+  rle = art_svp_render_to_rle (moved, (int)floor (x0), (int)floor (y0),
+			       (int)ceil (x1) + 1, (int)ceil (y1) + 1);
+
+  art_free (points);
+  art_free (moved);
+  return rle;
+}
+
+/**
+ * art_render_svp_cached: Use a cached svp as a render mask source.
+ * @render: Render object.
+ * @cache: Coverage cache.
+ * @svp: SVP.
+ * @dx: Horizontal offset of @svp.
+ * @dy: Vertical offset of @svp.
+ *
+ * Adds @svp, moved by (@dx, @dy), to the render object as a mask, like
+ * art_render_svp() on the translated svp. The coverage is taken from
+ * @cache when a shape with the same segments was drawn before at an
+ * offset with the same fractional part, and rasterized and stored in
+ * @cache otherwise. Offsets are rounded to 1/ART_SVP_CACHE_SUBPIXEL
+ * of a pixel.
+ *
+ * Shapes are matched by their contents, which the cache keeps a copy
+ * of, so @svp may be freed or reused right after the call.
+ **/
+void
+art_render_svp_cached (ArtRender *render, ArtSVPCache *cache,
+		       const ArtSVP *svp, double dx, double dy)
+{
+  ArtMaskSourceSVP *mask_source;
+  ArtSVPCacheEntry *entry;
+  art_u32 hash;
+  int n_points;
+  int qx, qy, ix, iy, fx, fy;
+  int height;
+
+  qx = (int)floor (dx * ART_SVP_CACHE_SUBPIXEL + 0.5);
+  qy = (int)floor (dy * ART_SVP_CACHE_SUBPIXEL + 0.5);
+  ix = (int)floor ((double)qx / ART_SVP_CACHE_SUBPIXEL);
+  iy = (int)floor ((double)qy / ART_SVP_CACHE_SUBPIXEL);
+  fx = qx - ix * ART_SVP_CACHE_SUBPIXEL;
+  fy = qy - iy * ART_SVP_CACHE_SUBPIXEL;
+
+  hash = art_svp_cache_hash (svp, &n_points);
+  hash ^= (fx * ART_SVP_CACHE_SUBPIXEL + fy) * 0x9e3779b9U;
+  for (entry = cache->buckets[hash & (cache->n_buckets - 1)];
+       entry != NULL; entry = entry->next)
+    if (entry->hash == hash && entry->n_segs == svp->n_segs &&
+	entry->n_points == n_points && entry->fx == fx && entry->fy == fy &&
+	art_svp_cache_match (entry, svp))
+      break;
+
+  if (entry != NULL)
+    {
+      cache->stats.n_hits++;
+      /* move to the front of the list */
+      if (entry->lru_prev != NULL)
+	{
+	  entry->lru_prev->lru_next = entry->lru_next;
+	  if (entry->lru_next != NULL)
+	    entry->lru_next->lru_prev = entry->lru_prev;
+	  else
+	    cache->lru_last = entry->lru_prev;
+	  entry->lru_prev = NULL;
+	  entry->lru_next = cache->lru_first;
+	  cache->lru_first->lru_prev = entry;
+	  cache->lru_first = entry;
+	}
+      entry->refcount++;
+    }
+  else
+    {
+      cache->stats.n_misses++;
+      entry = art_new (ArtSVPCacheEntry, 1);
+      entry->cache = cache;
+      entry->hash = hash;
+      entry->n_segs = svp->n_segs;
+      entry->n_points = n_points;
+      art_svp_cache_copy_segs (entry, svp);
+      entry->fx = fx;
+      entry->fy = fy;
+      entry->refcount = 1;
+      entry->rle = art_svp_cache_render (svp,
+					 (double)fx / ART_SVP_CACHE_SUBPIXEL,
+					 (double)fy / ART_SVP_CACHE_SUBPIXEL);
+      height = entry->rle->y1 - entry->rle->y0;
+      if (height < 0)
+	height = 0;
+      entry->n_bytes = sizeof (ArtSVPCacheEntry) + sizeof (ArtSVPRle) +
+	2 * (height + 1) * sizeof (int) +
+	entry->rle->row_start[height] * sizeof (ArtSVPRenderAAStep) +
+	2 * svp->n_segs * sizeof (int) + n_points * sizeof (ArtPoint);
+
+      if (cache->stats.n_entries >= cache->n_buckets)
+	art_svp_cache_grow (cache);
+      entry->next = cache->buckets[hash & (cache->n_buckets - 1)];
+      cache->buckets[hash & (cache->n_buckets - 1)] = entry;
+      entry->lru_prev = NULL;
+      entry->lru_next = cache->lru_first;
+      if (cache->lru_first != NULL)
+	cache->lru_first->lru_prev = entry;
+      else
+	cache->lru_last = entry;
+      cache->lru_first = entry;
+      cache->stats.n_entries++;
+      cache->stats.n_bytes += entry->n_bytes;
+
+      /* A mask bigger than the whole budget is evicted right away,
+	 and freed once this render is done with it. */
+      while (cache->stats.n_bytes > cache->max_bytes)
+	{
+	  art_svp_cache_remove (cache, cache->lru_last);
+	  cache->stats.n_evictions++;
+	}
+    }
+
+  mask_source = art_new (ArtMaskSourceSVP, 1);
+
+  mask_source->super.super.render = NULL;
+  mask_source->super.super.done = art_render_svp_done;
+  mask_source->super.can_drive = art_render_svp_can_drive;
+  mask_source->super.invoke_driver = art_render_svp_rle_invoke_driver;
+  mask_source->super.prepare = art_render_svp_prepare;
+  mask_source->render = render;
+  mask_source->svp = NULL;
+  mask_source->rle = entry->rle;
+  mask_source->dx = ix;
+  mask_source->dy = iy;
+  mask_source->entry = entry;
 
   art_render_add_mask_source (render, &mask_source->super);
 }
@@ -28,9 +28,11 @@
 #ifdef LIBART_COMPILATION
 #include "art_render.h"
 #include "art_svp.h"
+#include "art_svp_rle.h"
 #else
 #include <libart_lgpl/art_render.h>
 #include <libart_lgpl/art_svp.h>
+#include <libart_lgpl/art_svp_rle.h>
 #endif
 
 #ifdef __cplusplus
@@ -40,6 +42,45 @@ extern "C" {
 void
 art_render_svp (ArtRender *render, const ArtSVP *svp);
 
+void
+art_render_svp_rle (ArtRender *render, const ArtSVPRle *rle);
+
+void
+art_render_svp_rle_offset (ArtRender *render, const ArtSVPRle *rle,
+			   int dx, int dy);
+
+/* A cache of coverage masks, for shapes that are drawn many times at
+   different positions, such as glyphs. */
+typedef struct _ArtSVPCache ArtSVPCache;
+typedef struct _ArtSVPCacheStats ArtSVPCacheStats;
+
+struct _ArtSVPCacheStats {
+  unsigned long n_hits;
+  unsigned long n_misses;
+  unsigned long n_evictions;
+  int n_entries;
+  int n_bytes;
+};
+
+/* Positions are rounded to this fraction of a pixel in the cache. */
+#define ART_SVP_CACHE_SUBPIXEL 4
+
+ArtSVPCache *
+art_svp_cache_new (int max_bytes);
+
+void
+art_svp_cache_free (ArtSVPCache *cache);
+
+void
+art_svp_cache_get_stats (const ArtSVPCache *cache, ArtSVPCacheStats *stats);
+
+void
+art_svp_cache_reset_stats (ArtSVPCache *cache);
+
+void
+art_render_svp_cached (ArtRender *render, ArtSVPCache *cache,
+		       const ArtSVP *svp, double dx, double dy);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -89,16 +89,21 @@ art_rgb_fill_run (art_u8 *buf, art_u8 r, art_u8 g, art_u8 b, gint n)
 void
 art_rgb_fill_run (art_u8 *buf, art_u8 r, art_u8 g, art_u8 b, int n)
 {
-  int i;
-  unsigned int v1, v2, v3;
+  int i, k;
+  unsigned long pat[3];
+  unsigned long *wbuf;
+  art_u8 *p;
 
   if (r == g && g == b)
     {
+      /* memset is as wide as it gets, and C libraries switch to
+	 non-temporal stores for large sizes, so clears to white or
+	 black don't flush the cache */
       memset (buf, g, n + n + n);
     }
   else
     {
-      if (n < 8)
+      if (n < 2 * (int)sizeof (unsigned long))
 	{
 	  for (i = 0; i < n; i++)
 	    {
@@ -106,32 +111,38 @@ art_rgb_fill_run (art_u8 *buf, art_u8 r, art_u8 g, art_u8 b, int n)
 	      *buf++ = g;
 	      *buf++ = b;
 	    }
-	} else {
-	  /* handle prefix up to byte alignment */
-	  /* I'm worried about this cast on sizeof(long) != sizeof(uchar *)
-	     architectures, but it _should_ work. */
-	  for (i = 0; ((unsigned long)buf) & 3; i++)
+	}
+      else
+	{
+	  /* handle prefix up to word alignment */
+	  for (i = 0; ((unsigned long)buf) & (sizeof (unsigned long) - 1); i++)
 	    {
 	      *buf++ = r;
 	      *buf++ = g;
 	      *buf++ = b;
 	    }
-#ifndef WORDS_BIGENDIAN
-	  v1 = r | (g << 8) | (b << 16) | (r << 24);
-	  v3 = (v1 << 8) | b;
-	  v2 = (v3 << 8) | g;
-#else
-	  v1 = (r << 24) | (g << 16) | (b << 8) | r;
-	  v2 = (v1 << 8) | g;
-	  v3 = (v2 << 8) | b;
-#endif
-	  for (; i < n - 3; i += 4)
+	  /* three words hold sizeof (unsigned long) pixels, whatever the
+	     word size and byte order */
+	  p = (art_u8 *)pat;
+	  for (k = 0; k < (int)sizeof (unsigned long); k++)
+	    {
+	      *p++ = r;
+	      *p++ = g;
+	      *p++ = b;
+	    }
+	  wbuf = (unsigned long *)buf;
+	  for (; i + 2 * (int)sizeof (unsigned long) <= n;
+	       i += 2 * sizeof (unsigned long))
 	    {
-	      ((art_u32 *)buf)[0] = v1;
-	      ((art_u32 *)buf)[1] = v2;
-	      ((art_u32 *)buf)[2] = v3;
-	      buf += 12;
+	      wbuf[0] = pat[0];
+	      wbuf[1] = pat[1];
+	      wbuf[2] = pat[2];
+	      wbuf[3] = pat[0];
+	      wbuf[4] = pat[1];
+	      wbuf[5] = pat[2];
+	      wbuf += 6;
 	    }
+	  buf = (art_u8 *)wbuf;
 	  /* handle postfix */
 	  for (; i < n; i++)
 	    {
@@ -160,16 +171,73 @@ void
 art_rgb_run_alpha (art_u8 *buf, art_u8 r, art_u8 g, art_u8 b, int alpha, int n)
 {
   int i;
-  int v;
+  unsigned int ia;
+  unsigned int cr, cg, cb;
+  art_u32 v1, v2, v3;
+  art_u32 ce1, co1, ce2, co2, ce3, co3;
+  art_u32 w;
+
+  /* v + (((c - v) * alpha + 0x80) >> 8) is equal to
+     (v * (256 - alpha) + c * alpha + 0x80) >> 8, which never goes
+     negative or above 0xffff. So everything but v can be hoisted out
+     of the loop, and the even and the odd bytes of a word can each
+     be blended as two 16 bit lanes at once. */
+  ia = 256 - alpha;
+  cr = r * alpha + 0x80;
+  cg = g * alpha + 0x80;
+  cb = b * alpha + 0x80;
+
+  i = 0;
+  if (n >= 8)
+    {
+      /* handle prefix up to word alignment, as in art_rgb_fill_run */
+      for (; ((unsigned long)buf) & 3; i++)
+	{
+	  buf[0] = (buf[0] * ia + cr) >> 8;
+	  buf[1] = (buf[1] * ia + cg) >> 8;
+	  buf[2] = (buf[2] * ia + cb) >> 8;
+	  buf += 3;
+	}
 
-  for (i = 0; i < n; i++)
+#ifndef WORDS_BIGENDIAN
+      v1 = r | (g << 8) | (b << 16) | (r << 24);
+      v3 = (v1 << 8) | b;
+      v2 = (v3 << 8) | g;
+#else
+      v1 = (r << 24) | (g << 16) | (b << 8) | r;
+      v2 = (v1 << 8) | g;
+      v3 = (v2 << 8) | b;
+#endif
+      ce1 = (v1 & 0x00ff00ff) * alpha + 0x00800080;
+      co1 = ((v1 >> 8) & 0x00ff00ff) * alpha + 0x00800080;
+      ce2 = (v2 & 0x00ff00ff) * alpha + 0x00800080;
+      co2 = ((v2 >> 8) & 0x00ff00ff) * alpha + 0x00800080;
+      ce3 = (v3 & 0x00ff00ff) * alpha + 0x00800080;
+      co3 = ((v3 >> 8) & 0x00ff00ff) * alpha + 0x00800080;
+      for (; i < n - 3; i += 4)
+	{
+	  w = ((art_u32 *)buf)[0];
+	  ((art_u32 *)buf)[0] =
+	    ((((w & 0x00ff00ff) * ia + ce1) >> 8) & 0x00ff00ff) |
+	    ((((w >> 8) & 0x00ff00ff) * ia + co1) & 0xff00ff00);
+	  w = ((art_u32 *)buf)[1];
+	  ((art_u32 *)buf)[1] =
+	    ((((w & 0x00ff00ff) * ia + ce2) >> 8) & 0x00ff00ff) |
+	    ((((w >> 8) & 0x00ff00ff) * ia + co2) & 0xff00ff00);
+	  w = ((art_u32 *)buf)[2];
+	  ((art_u32 *)buf)[2] =
+	    ((((w & 0x00ff00ff) * ia + ce3) >> 8) & 0x00ff00ff) |
+	    ((((w >> 8) & 0x00ff00ff) * ia + co3) & 0xff00ff00);
+	  buf += 12;
+	}
+    }
+
+  /* handle postfix */
+  for (; i < n; i++)
     {
-      v = *buf;
-      *buf++ = v + (((r - v) * alpha + 0x80) >> 8);
-      v = *buf;
-      *buf++ = v + (((g - v) * alpha + 0x80) >> 8);
-      v = *buf;
-      *buf++ = v + (((b - v) * alpha + 0x80) >> 8);
+      buf[0] = (buf[0] * ia + cr) >> 8;
+      buf[1] = (buf[1] * ia + cg) >> 8;
+      buf[2] = (buf[2] * ia + cb) >> 8;
+      buf += 3;
     }
 }
-
@@ -55,9 +55,8 @@
  * As usual in libart, the left and top edges of this rectangle are
  * included, and the right and bottom edges are excluded.
  *
- * The @alphagamma parameter specifies that the alpha compositing be
- * done in a gamma-corrected color space. In the current
- * implementation, it is ignored.
+ * The @alphagamma parameter, when not NULL, specifies that the alpha
+ * compositing be done in a gamma-corrected color space.
  *
  * The @level parameter specifies the speed/quality tradeoff of the
  * image interpolation. Currently, only ART_FILTER_NEAREST is
@@ -123,6 +122,9 @@ art_rgb_a_affine (art_u8 *dst,
 		  dst_p[1] = g;
 		  dst_p[2] = b;
 		}
+	      else if (alphagamma != NULL)
+		art_rgb_affine_gamma_blend (dst_p, r, g, b, alpha,
+					    alphagamma);
 	      else
 		{
 		  bg_r = dst_p[0];
@@ -125,3 +125,31 @@ art_rgb_affine_run (int *p_x0, int *p_x1, int y,
   *p_x0 = x0;
   *p_x1 = x1;
 }
+
+/* Composite the color (@r, @g, @b) with opacity @alpha, in the range
+   0..255, over the pixel at @dst, blending in the linear intensity
+   space of @alphagamma. */
+void
+art_rgb_affine_gamma_blend (art_u8 *dst, int r, int g, int b, int alpha,
+			    const ArtAlphaGamma *alphagamma)
+{
+  const int *table = alphagamma->table;
+  const art_u8 *invtab = alphagamma->invtable;
+  int tshift, tround;
+  int weight;
+
+  /* weight is in the range 0..256; to keep the weighted sums within
+     31 bits, table entries beyond 22 bits are cut */
+  weight = alpha + (alpha >> 7);
+  tshift = alphagamma->invtable_size > 22 ? alphagamma->invtable_size - 22 : 0;
+  tround = (1 << tshift) >> 1;
+  dst[0] = invtab[((((table[dst[0]] >> tshift) * (256 - weight) +
+		     (table[r] >> tshift) * weight + 0x80) >> 8) << tshift) +
+		  tround];
+  dst[1] = invtab[((((table[dst[1]] >> tshift) * (256 - weight) +
+		     (table[g] >> tshift) * weight + 0x80) >> 8) << tshift) +
+		  tround];
+  dst[2] = invtab[((((table[dst[2]] >> tshift) * (256 - weight) +
+		     (table[b] >> tshift) * weight + 0x80) >> 8) << tshift) +
+		  tround];
+}
@@ -23,6 +23,8 @@
 /* This module handles compositing of affine-transformed rgb images
    over rgb pixel buffers. */
 
+#include "art_alphagamma.h"
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -32,6 +34,10 @@ art_rgb_affine_run (int *p_x0, int *p_x1, int y,
 		    int src_width, int src_height,
 		    const double affine[6]);
 
+void
+art_rgb_affine_gamma_blend (art_u8 *dst, int r, int g, int b, int alpha,
+			    const ArtAlphaGamma *alphagamma);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,301 @@
+/*
+ * art_rgb_hairline.c: Antialiased hairlines drawn directly into a buffer.
+ *
+ * Libart_LGPL - library of basic graphic primitives
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+/* The lines are drawn in the manner of Wu's algorithm: each column
+   (or row, for steep segments) crossed by the line gets its coverage
+   split between the pixels nearest to the line. No SVP is built, so this is
+   much cheaper than stroking for thin lines such as chart plots. */
+
+#include "config.h"
+#include "art_rgb_hairline.h"
+
+#include <math.h>
+#include "art_rgb.h"
+#include "art_rgba.h"
+
+typedef struct _ArtHairlineData ArtHairlineData;
+
+struct _ArtHairlineData {
+  int x0, y0, x1, y1;
+  art_u8 *buf;
+  int rowstride;
+  int n_chan; /* 3 for RGB, 4 for RGBA */
+  art_u8 r, g, b;
+  int alphatab[256]; /* coverage to run_alpha alpha */
+};
+
+static void
+art_hairline_plot (ArtHairlineData *data, int x, int y, int cov)
+{
+  art_u8 *p;
+  int alpha;
+
+  if (cov == 0 || y < data->y0 || y >= data->y1 ||
+      x < data->x0 || x >= data->x1)
+    return;
+  alpha = data->alphatab[cov];
+  p = data->buf + (y - data->y0) * data->rowstride +
+    (x - data->x0) * data->n_chan;
+  if (data->n_chan == 3)
+    {
+      int v;
+
+      v = p[0];
+      p[0] = v + (((data->r - v) * alpha + 0x80) >> 8);
+      v = p[1];
+      p[1] = v + (((data->g - v) * alpha + 0x80) >> 8);
+      v = p[2];
+      p[2] = v + (((data->b - v) * alpha + 0x80) >> 8);
+    }
+  else
+    art_rgba_run_alpha (p, data->r, data->g, data->b, alpha, 1);
+}
+
+/* Draw the segment from (@xa, @ya) to (@xb, @yb). Each column (or
+   row, for steep segments) gets the pixels of the line's vertical
+   (horizontal) cross section, which is @line_width over the cosine of
+   the slope, weighted by how much of each pixel it covers.
+
+   Where the segment joins the next one, only the columns whose centers
+   lie in the half-open range covered by the segment are touched, so
+   consecutive segments of a polyline don't hit the same column twice.
+   At the ends of an open subpath (@start_cap, @end_cap), the end
+   columns are instead weighted by the part of them the segment
+   covers, as with butt caps. */
+static void
+art_hairline_segment (ArtHairlineData *data,
+		      double xa, double ya, double xb, double yb,
+		      double line_width,
+		      art_boolean start_cap, art_boolean end_cap)
+{
+  double dx = xb - xa;
+  double dy = yb - ya;
+  double slope, lo, hi, u, f;
+  double half, top, bot, cov;
+  double minor0, minor1;
+  int i, i0, i1, j;
+  art_boolean steep;
+  art_boolean tmp_cap;
+  double tmp;
+
+  steep = fabs (dy) > fabs (dx);
+  if (steep)
+    {
+      /* work on the transposed segment */
+      tmp = xa; xa = ya; ya = tmp;
+      tmp = xb; xb = yb; yb = tmp;
+      tmp = dx; dx = dy; dy = tmp;
+    }
+  if (dx == 0)
+    return;
+  if (dx < 0)
+    {
+      tmp = xa; xa = xb; xb = tmp;
+      tmp = ya; ya = yb; yb = tmp;
+      tmp_cap = start_cap; start_cap = end_cap; end_cap = tmp_cap;
+      dx = -dx;
+      dy = -dy;
+    }
+  slope = dy / dx;
+  half = 0.5 * line_width * sqrt (1 + slope * slope);
+
+  /* clip the major axis to the destination rectangle */
+  lo = start_cap ? floor (xa) : ceil (xa - 0.5);
+  hi = end_cap ? ceil (xb) : ceil (xb - 0.5);
+  if (steep)
+    {
+      if (lo < data->y0)
+	lo = data->y0;
+      if (hi > data->y1)
+	hi = data->y1;
+      minor0 = data->x0;
+      minor1 = data->x1;
+    }
+  else
+    {
+      if (lo < data->x0)
+	lo = data->x0;
+      if (hi > data->x1)
+	hi = data->x1;
+      minor0 = data->y0;
+      minor1 = data->y1;
+    }
+  if (lo >= hi)
+    return;
+  i0 = (int)lo;
+  i1 = (int)hi;
+
+  for (i = i0; i < i1; i++)
+    {
+      /* fraction of the column along the segment */
+      f = 1;
+      if (start_cap && i < xa)
+	f -= xa - i;
+      if (end_cap && i + 1 > xb)
+	f -= i + 1 - xb;
+      if (f <= 0)
+	continue;
+
+      u = ya + (i + 0.5 - xa) * slope;
+      top = u - half;
+      bot = u + half;
+      if (bot <= minor0 || top >= minor1)
+	continue;
+      for (j = (int)floor (top); j < bot; j++)
+	{
+	  cov = (bot < j + 1 ? bot : j + 1) - (top > j ? top : j);
+	  cov = cov * f * 255 + 0.5;
+	  if (cov > 255)
+	    cov = 255;
+	  if (steep)
+	    art_hairline_plot (data, j, i, (int)cov);
+	  else
+	    art_hairline_plot (data, i, j, (int)cov);
+	}
+    }
+}
+
+static void
+art_hairline_vpath (ArtHairlineData *data, const ArtVpath *vpath,
+		    double line_width)
+{
+  double x = 0, y = 0;
+  art_boolean open = ART_FALSE;
+  int i;
+
+  if (line_width <= 0)
+    return;
+  if (line_width > ART_HAIRLINE_MAX_WIDTH)
+    line_width = ART_HAIRLINE_MAX_WIDTH;
+
+  for (i = 0; vpath[i].code != ART_END; i++)
+    {
+      if (vpath[i].code == ART_LINETO)
+	art_hairline_segment (data, x, y, vpath[i].x, vpath[i].y, line_width,
+			      open && vpath[i - 1].code != ART_LINETO,
+			      open && vpath[i + 1].code != ART_LINETO);
+      else
+	open = vpath[i].code == ART_MOVETO_OPEN;
+      x = vpath[i].x;
+      y = vpath[i].y;
+    }
+}
+
+static void
+art_hairline_data_init (ArtHairlineData *data,
+			int x0, int y0, int x1, int y1, art_u32 rgba,
+			art_u8 *buf, int rowstride, int n_chan)
+{
+  int alpha = rgba & 0xff;
+  int i;
+
+  data->x0 = x0;
+  data->y0 = y0;
+  data->x1 = x1;
+  data->y1 = y1;
+  data->buf = buf;
+  data->rowstride = rowstride;
+  data->n_chan = n_chan;
+  data->r = rgba >> 24;
+  data->g = (rgba >> 16) & 0xff;
+  data->b = (rgba >> 8) & 0xff;
+
+  if (n_chan == 3)
+    {
+      /* same table as art_rgb_svp_alpha, alpha in 0..256 */
+      int a = 0x8000;
+      int da = (alpha * 66051 + 0x80) >> 8;
+
+      for (i = 0; i < 256; i++)
+	{
+	  data->alphatab[i] = a >> 16;
+	  a += da;
+	}
+    }
+  else
+    {
+      /* art_rgba_run_alpha takes alpha in 0..255 */
+      for (i = 0; i < 256; i++)
+	data->alphatab[i] = (i * alpha + 0x7f) / 255;
+    }
+}
+
+/**
+ * art_rgb_vpath_hairline: Draw a thin antialiased stroke into an RGB buffer.
+ * @vpath: The path to stroke.
+ * @line_width: Width of the line, at most %ART_HAIRLINE_MAX_WIDTH.
+ * @x0: Left coordinate of destination rectangle.
+ * @y0: Top coordinate of destination rectangle.
+ * @x1: Right coordinate of destination rectangle.
+ * @y1: Bottom coordinate of destination rectangle.
+ * @rgba: Color in 0xRRGGBBAA format.
+ * @buf: Destination RGB buffer.
+ * @rowstride: Rowstride of @buf buffer.
+ *
+ * Draws @vpath as a line of width @line_width over the @buf RGB
+ * buffer, without going through art_svp_vpath_stroke() and the SVP
+ * renderer. The meaning of @x0, @y0, @x1, @y1, @buf and @rowstride
+ * is the same as for art_rgb_svp_alpha().
+ *
+ * Lines wider than %ART_HAIRLINE_MAX_WIDTH are drawn as if @line_width
+ * were %ART_HAIRLINE_MAX_WIDTH. Open subpaths end with butt caps;
+ * joins are not drawn. The coverage is computed per column rather
+ * than as the exact area, so the result is close to, but not the same
+ * as, what art_svp_vpath_stroke() gives.
+ **/
+void
+art_rgb_vpath_hairline (const ArtVpath *vpath, double line_width,
+			int x0, int y0, int x1, int y1,
+			art_u32 rgba,
+			art_u8 *buf, int rowstride)
+{
+  ArtHairlineData data;
+
+  art_hairline_data_init (&data, x0, y0, x1, y1, rgba, buf, rowstride, 3);
+  art_hairline_vpath (&data, vpath, line_width);
+}
+
+/**
+ * art_rgba_vpath_hairline: Draw a thin antialiased stroke into an RGBA buffer.
+ * @vpath: The path to stroke.
+ * @line_width: Width of the line, at most %ART_HAIRLINE_MAX_WIDTH.
+ * @x0: Left coordinate of destination rectangle.
+ * @y0: Top coordinate of destination rectangle.
+ * @x1: Right coordinate of destination rectangle.
+ * @y1: Bottom coordinate of destination rectangle.
+ * @rgba: Color in 0xRRGGBBAA format.
+ * @buf: Destination RGBA buffer, as used by art_rgba_run_alpha().
+ * @rowstride: Rowstride of @buf buffer.
+ *
+ * Same as art_rgb_vpath_hairline(), but for a buffer with
+ * 4 bytes per pixel and non-premultiplied alpha.
+ **/
+void
+art_rgba_vpath_hairline (const ArtVpath *vpath, double line_width,
+			 int x0, int y0, int x1, int y1,
+			 art_u32 rgba,
+			 art_u8 *buf, int rowstride)
+{
+  ArtHairlineData data;
+
+  art_hairline_data_init (&data, x0, y0, x1, y1, rgba, buf, rowstride, 4);
+  art_hairline_vpath (&data, vpath, line_width);
+}
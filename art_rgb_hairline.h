@@ -0,0 +1,57 @@
+/*
+ * art_rgb_hairline.h: Antialiased hairlines drawn directly into a buffer.
+ *
+ * Libart_LGPL - library of basic graphic primitives
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifndef __ART_RGB_HAIRLINE_H__
+#define __ART_RGB_HAIRLINE_H__
+
+#ifdef LIBART_COMPILATION
+#include "art_misc.h"
+#include "art_vpath.h"
+#else
+#include <libart_lgpl/art_misc.h>
+#include <libart_lgpl/art_vpath.h>
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/* Strokes no wider than this can be drawn as hairlines, which
+   approximate the coverage art_svp_vpath_stroke gives them. */
+#define ART_HAIRLINE_MAX_WIDTH 1.0
+
+void
+art_rgb_vpath_hairline (const ArtVpath *vpath, double line_width,
+			int x0, int y0, int x1, int y1,
+			art_u32 rgba,
+			art_u8 *buf, int rowstride);
+
+void
+art_rgba_vpath_hairline (const ArtVpath *vpath, double line_width,
+			 int x0, int y0, int x1, int y1,
+			 art_u32 rgba,
+			 art_u8 *buf, int rowstride);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __ART_RGB_HAIRLINE_H__ */
@@ -69,7 +69,7 @@ art_rgb_pixbuf_affine (art_u8 *dst,
 		       ArtFilterLevel level,
 		       ArtAlphaGamma *alphagamma)
 {
-  if (pixbuf->format != ART_PIX_RGB)
+  if (pixbuf->format != ART_PIX_RGB && pixbuf->format != ART_PIX_RGB_PREMUL)
     {
       art_warn ("art_rgb_pixbuf_affine: need RGB format image\n");
       return;
@@ -87,7 +87,14 @@ art_rgb_pixbuf_affine (art_u8 *dst,
       return;
     }
 
-  if (pixbuf->has_alpha)
+  if (pixbuf->format == ART_PIX_RGB_PREMUL)
+    art_rgb_rgba_affine_premul (dst, x0, y0, x1, y1, dst_rowstride,
+				pixbuf->pixels,
+				pixbuf->width, pixbuf->height, pixbuf->rowstride,
+				affine,
+				level,
+				alphagamma);
+  else if (pixbuf->has_alpha)
     art_rgb_rgba_affine (dst, x0, y0, x1, y1, dst_rowstride,
 			 pixbuf->pixels,
 			 pixbuf->width, pixbuf->height, pixbuf->rowstride,
@@ -54,9 +54,8 @@
  * of this rectangle are included, and the right and bottom edges are
  * excluded.
  *
- * The @alphagamma parameter specifies that the alpha compositing be
- * done in a gamma-corrected color space. In the current
- * implementation, it is ignored.
+ * The @alphagamma parameter, when not NULL, specifies that the alpha
+ * compositing be done in a gamma-corrected color space.
  *
  * The @level parameter specifies the speed/quality tradeoff of the
  * image interpolation. Currently, only ART_FILTER_NEAREST is
@@ -116,6 +115,9 @@ art_rgb_rgba_affine (art_u8 *dst,
 		  dst_p[1] = src_p[1];
 		  dst_p[2] = src_p[2];
 		}
+	      else if (alphagamma != NULL)
+		art_rgb_affine_gamma_blend (dst_p, src_p[0], src_p[1], src_p[2], alpha,
+					    alphagamma);
 	      else
 		{
 		  bg_r = dst_p[0];
@@ -140,3 +142,88 @@ art_rgb_rgba_affine (art_u8 *dst,
       dst_linestart += dst_rowstride;
     }
 }
+
+/**
+ * art_rgb_rgba_affine_premul: Affine transform source premultiplied RGBA image and composite.
+ * @dst: Destination image RGB buffer.
+ * @x0: Left coordinate of destination rectangle.
+ * @y0: Top coordinate of destination rectangle.
+ * @x1: Right coordinate of destination rectangle.
+ * @y1: Bottom coordinate of destination rectangle.
+ * @dst_rowstride: Rowstride of @dst buffer.
+ * @src: Source image RGBA buffer, with premultiplied alpha.
+ * @src_width: Width of source image.
+ * @src_height: Height of source image.
+ * @src_rowstride: Rowstride of @src buffer.
+ * @affine: Affine transform.
+ * @level: Filter level.
+ * @alphagamma: #ArtAlphaGamma for gamma-correcting the compositing.
+ *
+ * Like art_rgb_rgba_affine(), but the color samples of @src are
+ * premultiplied by alpha. Each destination sample becomes
+ * src + dst * (255 - alpha) / 255.
+ *
+ * The @alphagamma parameter is ignored, and only ART_FILTER_NEAREST is
+ * implemented, as in art_rgb_rgba_affine().
+ **/
+void
+art_rgb_rgba_affine_premul (art_u8 *dst,
+			    int x0, int y0, int x1, int y1, int dst_rowstride,
+			    const art_u8 *src,
+			    int src_width, int src_height, int src_rowstride,
+			    const double affine[6],
+			    ArtFilterLevel level,
+			    ArtAlphaGamma *alphagamma)
+{
+  int x, y;
+  double inv[6];
+  art_u8 *dst_p, *dst_linestart;
+  const art_u8 *src_p;
+  ArtPoint pt, src_pt;
+  int src_x, src_y;
+  int ia;
+  int tmp;
+  int run_x0, run_x1;
+
+  dst_linestart = dst;
+  art_affine_invert (inv, affine);
+  for (y = y0; y < y1; y++)
+    {
+      pt.y = y + 0.5;
+      run_x0 = x0;
+      run_x1 = x1;
+      art_rgb_affine_run (&run_x0, &run_x1, y, src_width, src_height,
+			  inv);
+      dst_p = dst_linestart + (run_x0 - x0) * 3;
+      for (x = run_x0; x < run_x1; x++)
+	{
+	  pt.x = x + 0.5;
+	  art_affine_point (&src_pt, &pt, inv);
+	  src_x = floor (src_pt.x);
+	  src_y = floor (src_pt.y);
+	  if (src_x >= 0 && src_x < src_width &&
+	      src_y >= 0 && src_y < src_height)
+	    {
+	      src_p = src + (src_y * src_rowstride) + src_x * 4;
+	      ia = 255 - src_p[3];
+	      if (ia == 0)
+		{
+		  dst_p[0] = src_p[0];
+		  dst_p[1] = src_p[1];
+		  dst_p[2] = src_p[2];
+		}
+	      else if (ia != 255)
+		{
+		  tmp = dst_p[0] * ia + 0x80;
+		  dst_p[0] = src_p[0] + ((tmp + (tmp >> 8)) >> 8);
+		  tmp = dst_p[1] * ia + 0x80;
+		  dst_p[1] = src_p[1] + ((tmp + (tmp >> 8)) >> 8);
+		  tmp = dst_p[2] * ia + 0x80;
+		  dst_p[2] = src_p[2] + ((tmp + (tmp >> 8)) >> 8);
+		}
+	    }
+	  dst_p += 3;
+	}
+      dst_linestart += dst_rowstride;
+    }
+}
@@ -44,6 +44,15 @@ art_rgb_rgba_affine (art_u8 *dst,
 		     ArtFilterLevel level,
 		     ArtAlphaGamma *alphagamma);
 
+void
+art_rgb_rgba_affine_premul (art_u8 *dst,
+			    int x0, int y0, int x1, int y1, int dst_rowstride,
+			    const art_u8 *src,
+			    int src_width, int src_height, int src_rowstride,
+			    const double affine[6],
+			    ArtFilterLevel level,
+			    ArtAlphaGamma *alphagamma);
+
 #ifdef __cplusplus
 }
 #endif
@@ -42,6 +42,7 @@ struct _ArtRgbSVPAlphaData {
   art_u8 *buf;
   int rowstride;
   int x0, x1;
+  ArtAlphaGamma *alphagamma;
 };
 
 static void
@@ -176,38 +177,7 @@ art_rgb_svp_aa (const ArtSVP *svp,
 	}
     }
   else
-    {
-      int *table;
-      art_u8 *invtab;
-
-      table = alphagamma->table;
-
-      r_fg = table[fg_color >> 16];
-      g_fg = table[(fg_color >> 8) & 0xff];
-      b_fg = table[fg_color & 0xff];
-
-      r_bg = table[bg_color >> 16];
-      g_bg = table[(bg_color >> 8) & 0xff];
-      b_bg = table[bg_color & 0xff];
-
-      r = (r_bg << 16) + 0x8000;
-      g = (g_bg << 16) + 0x8000;
-      b = (b_bg << 16) + 0x8000;
-      dr = ((r_fg - r_bg) << 16) / 255;
-      dg = ((g_fg - g_bg) << 16) / 255;
-      db = ((b_fg - b_bg) << 16) / 255;
-
-      invtab = alphagamma->invtable;
-      for (i = 0; i < 256; i++)
-	{
-	  data.rgbtab[i] = (invtab[r >> 16] << 16) |
-	    (invtab[g >> 16] << 8) |
-	    invtab[b >> 16];
-	  r += dr;
-	  g += dg;
-	  b += db;
-	}
-    }
+    art_alphagamma_rgbtab (alphagamma, fg_color, bg_color, data.rgbtab);
   data.buf = buf;
   data.rowstride = rowstride;
   data.x0 = x0;
@@ -215,6 +185,46 @@ art_rgb_svp_aa (const ArtSVP *svp,
   art_svp_render_aa (svp, x0, y0, x1, y1, art_rgb_svp_callback, &data);
 }
 
+/* Like art_rgb_run_alpha(), but blends in the linear intensity space
+   of data->alphagamma when it is set. */
+static void
+art_rgb_svp_run_alpha (ArtRgbSVPAlphaData *data, art_u8 *buf,
+		       art_u8 r, art_u8 g, art_u8 b, int alpha, int n)
+{
+  const ArtAlphaGamma *alphagamma = data->alphagamma;
+  const int *table;
+  const art_u8 *invtab;
+  int tshift, tround;
+  int lr, lg, lb;
+  int i;
+
+  if (alphagamma == NULL)
+    {
+      art_rgb_run_alpha (buf, r, g, b, alpha, n);
+      return;
+    }
+
+  /* alpha is in the range 0..256; to keep the weighted sums within
+     31 bits, table entries beyond 22 bits are cut */
+  table = alphagamma->table;
+  invtab = alphagamma->invtable;
+  tshift = alphagamma->invtable_size > 22 ? alphagamma->invtable_size - 22 : 0;
+  tround = (1 << tshift) >> 1;
+  lr = (table[r] >> tshift) * alpha + 0x80;
+  lg = (table[g] >> tshift) * alpha + 0x80;
+  lb = (table[b] >> tshift) * alpha + 0x80;
+  for (i = 0; i < n; i++)
+    {
+      buf[0] = invtab[((((table[buf[0]] >> tshift) * (256 - alpha) + lr) >> 8)
+		       << tshift) + tround];
+      buf[1] = invtab[((((table[buf[1]] >> tshift) * (256 - alpha) + lg) >> 8)
+		       << tshift) + tround];
+      buf[2] = invtab[((((table[buf[2]] >> tshift) * (256 - alpha) + lb) >> 8)
+		       << tshift) + tround];
+      buf += 3;
+    }
+}
+
 static void
 art_rgb_svp_alpha_callback (void *callback_data, int y,
 			    int start, ArtSVPRenderAAStep *steps, int n_steps)
@@ -245,9 +255,9 @@ art_rgb_svp_alpha_callback (void *callback_data, int y,
 	{
 	  alpha = (running_sum >> 16) & 0xff;
 	  if (alpha)
-	    art_rgb_run_alpha (linebuf,
-			       r, g, b, alphatab[alpha],
-			       run_x1 - x0);
+	    art_rgb_svp_run_alpha (data, linebuf,
+				   r, g, b, alphatab[alpha],
+				   run_x1 - x0);
 	}
 
       for (k = 0; k < n_steps - 1; k++)
@@ -259,9 +269,9 @@ art_rgb_svp_alpha_callback (void *callback_data, int y,
 	    {
 	      alpha = (running_sum >> 16) & 0xff;
 	      if (alpha)
-		art_rgb_run_alpha (linebuf + (run_x0 - x0) * 3,
-				   r, g, b, alphatab[alpha],
-				   run_x1 - run_x0);
+		art_rgb_svp_run_alpha (data, linebuf + (run_x0 - x0) * 3,
+				       r, g, b, alphatab[alpha],
+				       run_x1 - run_x0);
 	    }
 	}
       running_sum += steps[k].delta;
@@ -269,18 +279,18 @@ art_rgb_svp_alpha_callback (void *callback_data, int y,
 	{
 	  alpha = (running_sum >> 16) & 0xff;
 	  if (alpha)
-	    art_rgb_run_alpha (linebuf + (run_x1 - x0) * 3,
-			       r, g, b, alphatab[alpha],
-			       x1 - run_x1);
+	    art_rgb_svp_run_alpha (data, linebuf + (run_x1 - x0) * 3,
+				   r, g, b, alphatab[alpha],
+				   x1 - run_x1);
 	}
     }
   else
     {
       alpha = (running_sum >> 16) & 0xff;
       if (alpha)
-	art_rgb_run_alpha (linebuf,
-			   r, g, b, alphatab[alpha],
-			   x1 - x0);
+	art_rgb_svp_run_alpha (data, linebuf,
+			       r, g, b, alphatab[alpha],
+			       x1 - x0);
     }
 
   data->buf += data->rowstride;
@@ -323,9 +333,9 @@ art_rgb_svp_alpha_opaque_callback (void *callback_data, int y,
 				  r, g, b,
 				  run_x1 - x0);
 	      else
-		art_rgb_run_alpha (linebuf,
-				   r, g, b, alphatab[alpha],
-				   run_x1 - x0);
+		art_rgb_svp_run_alpha (data, linebuf,
+				       r, g, b, alphatab[alpha],
+				       run_x1 - x0);
 	    }
 	}
 
@@ -344,9 +354,9 @@ art_rgb_svp_alpha_opaque_callback (void *callback_data, int y,
 				      r, g, b,
 				      run_x1 - run_x0);
 		  else
-		    art_rgb_run_alpha (linebuf + (run_x0 - x0) * 3,
-				       r, g, b, alphatab[alpha],
-				       run_x1 - run_x0);
+		    art_rgb_svp_run_alpha (data, linebuf + (run_x0 - x0) * 3,
+					   r, g, b, alphatab[alpha],
+					   run_x1 - run_x0);
 		}
 	    }
 	}
@@ -361,9 +371,9 @@ art_rgb_svp_alpha_opaque_callback (void *callback_data, int y,
 				  r, g, b,
 				  x1 - run_x1);
 	      else
-		art_rgb_run_alpha (linebuf + (run_x1 - x0) * 3,
-				   r, g, b, alphatab[alpha],
-				   x1 - run_x1);
+		art_rgb_svp_run_alpha (data, linebuf + (run_x1 - x0) * 3,
+				       r, g, b, alphatab[alpha],
+				       x1 - run_x1);
 	    }
 	}
     }
@@ -377,9 +387,9 @@ art_rgb_svp_alpha_opaque_callback (void *callback_data, int y,
 			      r, g, b,
 			      x1 - x0);
 	  else
-	    art_rgb_run_alpha (linebuf,
-			       r, g, b, alphatab[alpha],
-			       x1 - x0);
+	    art_rgb_svp_run_alpha (data, linebuf,
+				   r, g, b, alphatab[alpha],
+				   x1 - x0);
 	}
     }
 
@@ -448,6 +458,7 @@ art_rgb_svp_alpha (const ArtSVP *svp,
   data.rowstride = rowstride;
   data.x0 = x0;
   data.x1 = x1;
+  data.alphagamma = alphagamma;
   if (alpha == 255)
     art_svp_render_aa (svp, x0, y0, x1, y1, art_rgb_svp_alpha_opaque_callback,
 		       &data);
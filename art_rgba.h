@@ -36,6 +36,12 @@ extern "C" {
 void
 art_rgba_rgba_composite (art_u8 *dst, const art_u8 *src, int n);
 
+void
+art_rgba_rgba_composite_premul (art_u8 *dst, const art_u8 *src, int n);
+
+void
+art_rgba_premultiply (art_u8 *buf, int n);
+
 void
 art_rgba_fill_run (art_u8 *buf, art_u8 r, art_u8 g, art_u8 b, int n);
 
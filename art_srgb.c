@@ -0,0 +1,138 @@
+/*
+ * art_srgb.c: Conversion between 8-bit sRGB and 16-bit linear light.
+ *
+ * Libart_LGPL - library of basic graphic primitives
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#include "config.h"
+#include "art_srgb.h"
+
+#include <math.h>
+
+/* Linear light is stored as 0..0xffff. The sRGB encoding of a linear
+   value v is looked up at (v + 8) >> 4, which is fine enough that
+   converting 8-bit sRGB to linear light and back is exact. */
+#define ART_SRGB_N_ENCODE 4097
+
+static art_u16 art_srgb_decode_table[256];
+static art_u8 art_srgb_encode_table[ART_SRGB_N_ENCODE];
+static art_boolean art_srgb_tables_done = ART_FALSE;
+
+static void
+art_srgb_init_tables (void)
+{
+  double v, l;
+  int i;
+
+  for (i = 0; i < 256; i++)
+    {
+      v = i * (1.0 / 255);
+      if (v <= 0.04045)
+	l = v * (1.0 / 12.92);
+      else
+	l = pow ((v + 0.055) * (1.0 / 1.055), 2.4);
+      art_srgb_decode_table[i] = (int)floor (l * 0xffff + 0.5);
+    }
+  for (i = 0; i < ART_SRGB_N_ENCODE; i++)
+    {
+      l = i * (16.0 / 0xffff);
+      if (l > 1)
+	l = 1;
+      if (l <= 0.0031308)
+	v = l * 12.92;
+      else
+	v = 1.055 * pow (l, 1 / 2.4) - 0.055;
+      art_srgb_encode_table[i] = (int)floor (v * 255 + 0.5);
+    }
+  art_srgb_tables_done = ART_TRUE;
+}
+
+/**
+ * art_srgb_to_linear16: Convert 8-bit sRGB pixels to 16-bit linear light.
+ * @dst: Where to store the 16-bit pixels.
+ * @src: The 8-bit pixels.
+ * @n: Number of pixels.
+ * @n_chan: Number of color channels.
+ * @has_alpha: Whether the pixels have an alpha channel after the colors.
+ *
+ * Decodes the color samples of @src from sRGB into linear light, for
+ * use with a 16-bit ArtRender. Alpha is scaled to 16 bits.
+ **/
+void
+art_srgb_to_linear16 (art_u16 *dst, const art_u8 *src,
+		      int n, int n_chan, art_boolean has_alpha)
+{
+  const art_u16 *table;
+  int i, j;
+
+  if (!art_srgb_tables_done)
+    art_srgb_init_tables ();
+  table = art_srgb_decode_table;
+
+  for (i = 0; i < n; i++)
+    {
+      for (j = 0; j < n_chan; j++)
+	dst[j] = table[src[j]];
+      if (has_alpha)
+	{
+	  dst[n_chan] = src[n_chan] * 0x101;
+	  src++;
+	  dst++;
+	}
+      src += n_chan;
+      dst += n_chan;
+    }
+}
+
+/**
+ * art_srgb_from_linear16: Convert 16-bit linear light pixels to 8-bit sRGB.
+ * @dst: Where to store the 8-bit pixels.
+ * @src: The 16-bit pixels.
+ * @n: Number of pixels.
+ * @n_chan: Number of color channels.
+ * @has_alpha: Whether the pixels have an alpha channel after the colors.
+ *
+ * Encodes the color samples of @src, as rendered by a 16-bit
+ * ArtRender working in linear light, into sRGB. Alpha is rounded to 8
+ * bits.
+ **/
+void
+art_srgb_from_linear16 (art_u8 *dst, const art_u16 *src,
+			int n, int n_chan, art_boolean has_alpha)
+{
+  const art_u8 *table;
+  int i, j;
+
+  if (!art_srgb_tables_done)
+    art_srgb_init_tables ();
+  table = art_srgb_encode_table;
+
+  for (i = 0; i < n; i++)
+    {
+      for (j = 0; j < n_chan; j++)
+	dst[j] = table[(src[j] + 8) >> 4];
+      if (has_alpha)
+	{
+	  dst[n_chan] = (src[n_chan] * 0xff + 0x8000) >> 16;
+	  src++;
+	  dst++;
+	}
+      src += n_chan;
+      dst += n_chan;
+    }
+}
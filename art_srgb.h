@@ -0,0 +1,53 @@
+/*
+ * art_srgb.h: Conversion between 8-bit sRGB and 16-bit linear light.
+ *
+ * Libart_LGPL - library of basic graphic primitives
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifndef __ART_SRGB_H__
+#define __ART_SRGB_H__
+
+/* A render with depth 16 can keep its destination in linear light,
+   where compositing is physically correct and 16 bits leave no
+   visible banding, and convert to 8-bit sRGB once, for display. These
+   functions do the conversions; alpha samples are not gamma encoded
+   and are only scaled. */
+
+#ifdef LIBART_COMPILATION
+#include "art_misc.h"
+#else
+#include <libart_lgpl/art_misc.h>
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+void
+art_srgb_to_linear16 (art_u16 *dst, const art_u8 *src,
+		      int n, int n_chan, art_boolean has_alpha);
+
+void
+art_srgb_from_linear16 (art_u8 *dst, const art_u16 *src,
+			int n, int n_chan, art_boolean has_alpha);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __ART_SRGB_H__ */
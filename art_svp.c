@@ -150,3 +150,106 @@ art_svp_seg_compare (const void *s1, const void *s2)
   else return -1;
 }
 
+
+/**
+ * art_svp_free_float: Free an #ArtSVPF structure.
+ * @svp: #ArtSVPF to free.
+ *
+ * Frees an #ArtSVPF structure and all the segments in it.
+ **/
+void
+art_svp_free_float (ArtSVPF *svp)
+{
+  int n_segs = svp->n_segs;
+  int i;
+
+  for (i = 0; i < n_segs; i++)
+    art_free (svp->segs[i].points);
+  art_free (svp);
+}
+
+/**
+ * art_svp_to_float: Convert an svp to single precision.
+ * @svp: Source #ArtSVP.
+ *
+ * Rounds the points of @svp to floats, halving the memory they take.
+ * Rounding keeps the points of each segment sorted in y, but segments
+ * closer than the float resolution may end up touching; see
+ * art_svp_from_vpath_float() for the error involved.
+ *
+ * Return value: Newly allocated #ArtSVPF.
+ **/
+ArtSVPF *
+art_svp_to_float (const ArtSVP *svp)
+{
+  ArtSVPF *new;
+  const ArtSVPSeg *seg;
+  ArtSVPSegF *segf;
+  int i, j;
+
+  new = (ArtSVPF *)art_alloc (sizeof(ArtSVPF) +
+			      (svp->n_segs - 1) * sizeof(ArtSVPSegF));
+  new->n_segs = svp->n_segs;
+  for (i = 0; i < svp->n_segs; i++)
+    {
+      seg = &svp->segs[i];
+      segf = &new->segs[i];
+      segf->n_points = seg->n_points;
+      segf->dir = seg->dir;
+      segf->points = art_new (ArtPointF, seg->n_points);
+      for (j = 0; j < seg->n_points; j++)
+	{
+	  segf->points[j].x = seg->points[j].x;
+	  segf->points[j].y = seg->points[j].y;
+	}
+      /* recompute the bbox, so that it holds the rounded points */
+      segf->bbox.x0 = segf->bbox.x1 = segf->points[0].x;
+      for (j = 1; j < seg->n_points; j++)
+	{
+	  if (segf->bbox.x0 > segf->points[j].x)
+	    segf->bbox.x0 = segf->points[j].x;
+	  if (segf->bbox.x1 < segf->points[j].x)
+	    segf->bbox.x1 = segf->points[j].x;
+	}
+      segf->bbox.y0 = segf->points[0].y;
+      segf->bbox.y1 = segf->points[seg->n_points - 1].y;
+    }
+  return new;
+}
+
+/**
+ * art_svp_from_float: Convert a single precision svp to an svp.
+ * @svp: Source #ArtSVPF.
+ *
+ * Converts @svp back to double precision, exactly, so that it can be
+ * used with all the svp operations.
+ *
+ * Return value: Newly allocated #ArtSVP.
+ **/
+ArtSVP *
+art_svp_from_float (const ArtSVPF *svp)
+{
+  ArtSVP *new;
+  const ArtSVPSegF *segf;
+  ArtSVPSeg *seg;
+  int i, j;
+
+  new = (ArtSVP *)art_alloc (sizeof(ArtSVP) +
+			     (svp->n_segs - 1) * sizeof(ArtSVPSeg));
+  new->n_segs = svp->n_segs;
+  for (i = 0; i < svp->n_segs; i++)
+    {
+      segf = &svp->segs[i];
+      seg = &new->segs[i];
+      seg->n_points = segf->n_points;
+      seg->dir = segf->dir;
+      seg->bbox = segf->bbox;
+      seg->points = art_new (ArtPoint, segf->n_points);
+      for (j = 0; j < segf->n_points; j++)
+	{
+	  seg->points[j].x = segf->points[j].x;
+	  seg->points[j].y = segf->points[j].y;
+	}
+    }
+  return new;
+}
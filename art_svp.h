@@ -49,6 +49,23 @@ struct _ArtSVP {
   ArtSVPSeg segs[1];
 };
 
+/* The same with single precision points. The bounding boxes stay in
+   double precision, and hold the float points exactly. */
+typedef struct _ArtSVPF ArtSVPF;
+typedef struct _ArtSVPSegF ArtSVPSegF;
+
+struct _ArtSVPSegF {
+  int n_points;
+  int dir; /* == 0 for "up", 1 for "down" */
+  ArtDRect bbox;
+  ArtPointF *points;
+};
+
+struct _ArtSVPF {
+  int n_segs;
+  ArtSVPSegF segs[1];
+};
+
 int
 art_svp_add_segment (ArtSVP **p_vp, int *pn_segs_max,
 		     int **pn_points_max,
@@ -61,6 +78,15 @@ art_svp_free (ArtSVP *svp);
 int
 art_svp_seg_compare (const void *s1, const void *s2);
 
+void
+art_svp_free_float (ArtSVPF *svp);
+
+ArtSVPF *
+art_svp_to_float (const ArtSVP *svp);
+
+ArtSVP *
+art_svp_from_float (const ArtSVPF *svp);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
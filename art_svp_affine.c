@@ -0,0 +1,225 @@
+/*
+ * art_svp_affine.c: Affine transformation of sorted vector paths.
+ *
+ * Libart_LGPL - library of basic graphic primitives
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#include "config.h"
+#include "art_svp_affine.h"
+
+#include "art_svp_intersect.h"
+#include "art_svp_vpath.h"
+#include "art_vpath.h"
+
+/**
+ * art_svp_affine_keeps_order: Check whether a transform keeps svps sorted.
+ * @affine: The affine transformation.
+ *
+ * An svp stays valid under a transform that maps each row of the plane
+ * onto a row, keeps rows in order from top to bottom, and keeps points
+ * within a row in order from left to right: that is, when y' depends
+ * on y only (@affine[1] is zero) and both @affine[0] and @affine[3]
+ * are positive. Translations, positive scales and horizontal shears
+ * are all of this kind. Such transforms can be applied to the points
+ * of an svp directly.
+ *
+ * Return value: TRUE if svps can be transformed point by point.
+ **/
+art_boolean
+art_svp_affine_keeps_order (const double affine[6])
+{
+  return affine[1] == 0 && affine[0] > 0 && affine[3] > 0;
+}
+
+/* Transform the points of @seg and its bbox, for an @affine that keeps
+   svps in order. The loops are kept simple enough for the compiler to
+   vectorize. */
+static void
+art_svp_seg_affine (ArtSVPSeg *seg, const double affine[6])
+{
+  ArtPoint *points = seg->points;
+  int n_points = seg->n_points;
+  double a = affine[0], c = affine[2], d = affine[3];
+  double e = affine[4], f = affine[5];
+  double x, x_min, x_max;
+  int i;
+
+  if (a == 1 && c == 0 && d == 1)
+    {
+      /* translation */
+      for (i = 0; i < n_points; i++)
+	{
+	  points[i].x += e;
+	  points[i].y += f;
+	}
+      seg->bbox.x0 += e;
+      seg->bbox.x1 += e;
+    }
+  else if (c == 0)
+    {
+      /* scale */
+      for (i = 0; i < n_points; i++)
+	{
+	  points[i].x = points[i].x * a + e;
+	  points[i].y = points[i].y * d + f;
+	}
+      seg->bbox.x0 = seg->bbox.x0 * a + e;
+      seg->bbox.x1 = seg->bbox.x1 * a + e;
+    }
+  else
+    {
+      /* shear; the x extent has to be found again */
+      for (i = 0; i < n_points; i++)
+	{
+	  points[i].x = points[i].x * a + points[i].y * c + e;
+	  points[i].y = points[i].y * d + f;
+	}
+      x_min = x_max = points[0].x;
+      for (i = 1; i < n_points; i++)
+	{
+	  x = points[i].x;
+	  if (x < x_min)
+	    x_min = x;
+	  if (x > x_max)
+	    x_max = x;
+	}
+      seg->bbox.x0 = x_min;
+      seg->bbox.x1 = x_max;
+    }
+  seg->bbox.y0 = seg->bbox.y0 * d + f;
+  seg->bbox.y1 = seg->bbox.y1 * d + f;
+}
+
+/**
+ * art_svp_affine_transform_inplace: Transform an svp in place.
+ * @svp: The svp.
+ * @affine: The affine transformation.
+ *
+ * Applies @affine to the points and bounding boxes of @svp, if
+ * art_svp_affine_keeps_order() holds for it. Moving or scaling a
+ * shape this way costs a pass over its points, instead of building
+ * and sorting the segments again.
+ *
+ * Return value: TRUE if @svp was transformed, FALSE if @affine could
+ * reorder its segments, in which case @svp is left unchanged.
+ **/
+art_boolean
+art_svp_affine_transform_inplace (ArtSVP *svp, const double affine[6])
+{
+  int i;
+
+  if (!art_svp_affine_keeps_order (affine))
+    return ART_FALSE;
+
+  for (i = 0; i < svp->n_segs; i++)
+    art_svp_seg_affine (&svp->segs[i], affine);
+  return ART_TRUE;
+}
+
+/* Rebuild @svp under @affine from scratch: each segment becomes an
+   open subpath in its original direction, and the intersector sorts
+   the pieces out again. */
+static ArtSVP *
+art_svp_affine_transform_sweep (const ArtSVP *svp, const double affine[6])
+{
+  const ArtSVPSeg *seg;
+  ArtVpath *vpath;
+  ArtSVP *raw, *result;
+  ArtSvpWriter *swr;
+  double x, y;
+  int n_points = 0;
+  int i, j, k, ix;
+
+  for (i = 0; i < svp->n_segs; i++)
+    n_points += svp->segs[i].n_points;
+  vpath = art_new (ArtVpath, n_points + 1);
+
+  ix = 0;
+  for (i = 0; i < svp->n_segs; i++)
+    {
+      seg = &svp->segs[i];
+      for (j = 0; j < seg->n_points; j++)
+	{
+	  /* points run top to bottom; "up" segments were drawn the
+	     other way */
+	  k = seg->dir ? j : seg->n_points - 1 - j;
+	  x = seg->points[k].x;
+	  y = seg->points[k].y;
+	  vpath[ix].code = j == 0 ? ART_MOVETO_OPEN : ART_LINETO;
+	  vpath[ix].x = affine[0] * x + affine[2] * y + affine[4];
+	  vpath[ix].y = affine[1] * x + affine[3] * y + affine[5];
+	  ix++;
+	}
+    }
+  vpath[ix].code = ART_END;
+  vpath[ix].x = 0;
+  vpath[ix].y = 0;
+
+  raw = art_svp_from_vpath (vpath);
+  art_free (vpath);
+
+  /* a mirroring transform negates the winding numbers */
+  swr = art_svp_writer_rewind_new (ART_WIND_RULE_NONZERO);
+  art_svp_intersector (raw, swr);
+  result = art_svp_writer_rewind_reap (swr);
+  art_svp_free (raw);
+  return result;
+}
+
+/**
+ * art_svp_affine_transform: Transform an svp.
+ * @svp: The svp.
+ * @affine: The affine transformation.
+ *
+ * Computes the svp of the shape of @svp under @affine. Transforms for
+ * which art_svp_affine_keeps_order() holds are applied to a copy of
+ * the points. Any other transform, such as a rotation or a flip, can
+ * change the order of the segments, and the result is built again
+ * with the intersector, like an svp from art_svp_from_vpath(). It
+ * then covers the area where the winding number of @svp is nonzero.
+ *
+ * Return value: The transformed svp, to be freed with art_svp_free().
+ **/
+ArtSVP *
+art_svp_affine_transform (const ArtSVP *svp, const double affine[6])
+{
+  ArtSVP *result;
+  const ArtSVPSeg *seg;
+  ArtSVPSeg *dst;
+  int i, j;
+
+  if (!art_svp_affine_keeps_order (affine))
+    return art_svp_affine_transform_sweep (svp, affine);
+
+  result = (ArtSVP *)art_alloc (sizeof (ArtSVP) +
+				(svp->n_segs - 1) * sizeof (ArtSVPSeg));
+  result->n_segs = svp->n_segs;
+  for (i = 0; i < svp->n_segs; i++)
+    {
+      seg = &svp->segs[i];
+      dst = &result->segs[i];
+      dst->n_points = seg->n_points;
+      dst->dir = seg->dir;
+      dst->bbox = seg->bbox;
+      dst->points = art_new (ArtPoint, seg->n_points);
+      for (j = 0; j < seg->n_points; j++)
+	dst->points[j] = seg->points[j];
+      art_svp_seg_affine (dst, affine);
+    }
+  return result;
+}
@@ -25,8 +25,98 @@
 
 #include "art_svp.h"
 
+#ifndef MAX
+#define MAX(a, b)  (((a) > (b)) ? (a) : (b))
+#endif /* MAX */
+
+#ifndef MIN
+#define MIN(a, b)  (((a) < (b)) ? (a) : (b))
+#endif /* MIN */
+
 /* Determine whether a point is inside, or near, an svp. */
 
+/* Find the index of the edge of @seg spanning @y, which is known to
+   lie in [bbox.y0, bbox.y1). */
+static int
+art_svp_seg_find_edge (const ArtSVPSeg *seg, double y)
+{
+  int lo = 0, hi = seg->n_points - 2;
+
+  /* the first edge whose lower endpoint lies below y */
+  while (lo < hi)
+    {
+      int mid = (lo + hi) >> 1;
+
+      if (seg->points[mid + 1].y > y)
+	hi = mid;
+      else
+	lo = mid + 1;
+    }
+  return lo;
+}
+
+/* Contribution of @seg to the winding number at (@x, @y). */
+static int
+art_svp_seg_wind (const ArtSVPSeg *seg, double x, double y)
+{
+  if (seg->bbox.y0 > y || seg->bbox.y1 <= y)
+    return 0;
+
+  if (seg->bbox.x1 < x)
+    return seg->dir ? 1 : -1;
+  else if (seg->bbox.x0 <= x)
+    {
+      double x0, y0, x1, y1, dx, dy;
+      int j;
+
+      j = art_svp_seg_find_edge (seg, y);
+      x0 = seg->points[j].x;
+      y0 = seg->points[j].y;
+      x1 = seg->points[j + 1].x;
+      y1 = seg->points[j + 1].y;
+
+      dx = x1 - x0;
+      dy = y1 - y0;
+      if ((x - x0) * dy > (y - y0) * dx)
+	return seg->dir ? 1 : -1;
+    }
+  return 0;
+}
+
+/* Squared distance from (@x, @y) to edge @j of @seg. */
+static double
+art_svp_edge_dist_sq (const ArtSVPSeg *seg, int j, double x, double y)
+{
+  double x0 = seg->points[j].x;
+  double y0 = seg->points[j].y;
+  double x1 = seg->points[j + 1].x;
+  double y1 = seg->points[j + 1].y;
+
+  double dx = x1 - x0;
+  double dy = y1 - y0;
+
+  double dxx0 = x - x0;
+  double dyy0 = y - y0;
+
+  double dot = dxx0 * dx + dyy0 * dy;
+
+  if (dot < 0)
+    return dxx0 * dxx0 + dyy0 * dyy0;
+  else
+    {
+      double rr = dx * dx + dy * dy;
+
+      if (dot > rr)
+	return (x - x1) * (x - x1) + (y - y1) * (y - y1);
+      else
+	{
+	  double perp = (y - y0) * dx - (x - x0) * dy;
+
+	  return perp * perp / rr;
+	}
+    }
+}
+
 /* return winding number of point wrt svp */
 /**
  * art_svp_point_wind: Determine winding number of a point with respect to svp.
@@ -41,7 +131,7 @@
 int
 art_svp_point_wind (ArtSVP *svp, double x, double y)
 {
-  int i, j;
+  int i;
   int wind = 0;
 
   for (i = 0; i < svp->n_segs; i++)
@@ -51,30 +141,7 @@ art_svp_point_wind (ArtSVP *svp, double x, double y)
       if (seg->bbox.y0 > y)
 	break;
 
-      if (seg->bbox.y1 > y)
-	{
-	  if (seg->bbox.x1 < x)
-	    wind += seg->dir ? 1 : -1;
-	  else if (seg->bbox.x0 <= x)
-	    {
-	      double x0, y0, x1, y1, dx, dy;
-
-	      for (j = 0; j < seg->n_points - 1; j++)
-		{
-		  if (seg->points[j + 1].y > y)
-		    break;
-		}
-	      x0 = seg->points[j].x;
-	      y0 = seg->points[j].y;
-	      x1 = seg->points[j + 1].x;
-	      y1 = seg->points[j + 1].y;
-
-	      dx = x1 - x0;
-	      dy = y1 - y0;
-	      if ((x - x0) * dy > (y - y0) * dx)
-		wind += seg->dir ? 1 : -1;
-	    }
-	}
+      wind += art_svp_seg_wind (seg, x, y);
     }
 
   return wind;
@@ -103,36 +170,391 @@ art_svp_point_dist (ArtSVP *svp, double x, double y)
       ArtSVPSeg *seg = &svp->segs[i];
       for (j = 0; j < seg->n_points - 1; j++)
 	{
-	  double x0 = seg->points[j].x;
-	  double y0 = seg->points[j].y;
-	  double x1 = seg->points[j + 1].x;
-	  double y1 = seg->points[j + 1].y;
+	  dist_sq = art_svp_edge_dist_sq (seg, j, x, y);
+	  if (best_sq < 0 || dist_sq < best_sq)
+	    best_sq = dist_sq;
+	}
+    }
+
+  if (best_sq >= 0)
+    return sqrt (best_sq);
+  else
+    return 1e12;
+}
+
+/* The index is a uniform grid over the bounding box of the svp, with
+   about as many cells as there are edges. Each row lists the segments
+   whose y range overlaps it, which is all the winding number needs,
+   and each cell lists the edges whose bounding box overlaps it, which
+   are searched in rings of cells around the query point until no
+   closer edge can remain. */
+
+typedef struct _ArtSVPIndexEdge ArtSVPIndexEdge;
+
+struct _ArtSVPIndexEdge {
+  int seg;
+  int j;
+};
+
+struct _ArtSVPIndex {
+  const ArtSVP *svp;
+  double x0, y0, x1, y1; /* bounding box of the svp */
+  double cell_w, cell_h;
+  int n_cols, n_rows;
+  int *row_start; /* n_rows + 1 offsets into row_segs */
+  int *row_segs;
+  int *cell_start; /* n_cols * n_rows + 1 offsets into cell_edges */
+  ArtSVPIndexEdge *cell_edges;
+};
+
+static int
+art_svp_index_col (const ArtSVPIndex *index, double x)
+{
+  double c = floor ((x - index->x0) / index->cell_w);
+
+  if (c < 0)
+    return 0;
+  if (c >= index->n_cols)
+    return index->n_cols - 1;
+  return (int)c;
+}
+
+static int
+art_svp_index_row (const ArtSVPIndex *index, double y)
+{
+  double r = floor ((y - index->y0) / index->cell_h);
+
+  if (r < 0)
+    return 0;
+  if (r >= index->n_rows)
+    return index->n_rows - 1;
+  return (int)r;
+}
+
+/* Find the columns crossed by edge @j of @seg within @row. */
+static void
+art_svp_index_edge_cols (const ArtSVPIndex *index, const ArtSVPSeg *seg,
+			 int j, int row, int *p_c0, int *p_c1)
+{
+  double x0 = seg->points[j].x;
+  double y0 = seg->points[j].y;
+  double x1 = seg->points[j + 1].x;
+  double y1 = seg->points[j + 1].y;
+  double row_y0 = index->y0 + row * index->cell_h;
+  double row_y1 = row_y0 + index->cell_h;
+  double xa, xb;
+
+  /* clip the edge to the row */
+  if (y1 > y0)
+    {
+      xa = y0 < row_y0 ? x0 + (x1 - x0) * (row_y0 - y0) / (y1 - y0) : x0;
+      xb = y1 > row_y1 ? x0 + (x1 - x0) * (row_y1 - y0) / (y1 - y0) : x1;
+    }
+  else
+    {
+      xa = x0;
+      xb = x1;
+    }
+  *p_c0 = art_svp_index_col (index, MIN (xa, xb));
+  *p_c1 = art_svp_index_col (index, MAX (xa, xb));
+}
+
+/**
+ * art_svp_index_new: Build a point query index over an svp.
+ * @svp: The svp.
+ *
+ * Builds an index over @svp for art_svp_index_point_wind() and
+ * art_svp_index_point_dist(), which give the same results as
+ * art_svp_point_wind() and art_svp_point_dist(), but only look at the
+ * segments and edges near the query point. Building the index takes
+ * about as long as a few linear queries, so it pays off when the same
+ * svp is tested against many points, as in hit testing.
+ *
+ * The index refers to @svp, which must not be changed or freed before
+ * the index is freed.
+ *
+ * Return value: The newly allocated index.
+ **/
+ArtSVPIndex *
+art_svp_index_new (const ArtSVP *svp)
+{
+  ArtSVPIndex *index;
+  double x1, y1;
+  int n_edges;
+  int n_cells;
+  int i, j, k, row, col;
+  int r0, r1, c0, c1;
+  int *fill;
+
+  index = art_new (ArtSVPIndex, 1);
+  index->svp = svp;
+
+  n_edges = 0;
+  index->x0 = index->y0 = 0;
+  x1 = y1 = 0;
+  for (i = 0; i < svp->n_segs; i++)
+    {
+      const ArtSVPSeg *seg = &svp->segs[i];
+
+      if (i == 0 || seg->bbox.x0 < index->x0)
+	index->x0 = seg->bbox.x0;
+      if (i == 0 || seg->bbox.y0 < index->y0)
+	index->y0 = seg->bbox.y0;
+      if (i == 0 || seg->bbox.x1 > x1)
+	x1 = seg->bbox.x1;
+      if (i == 0 || seg->bbox.y1 > y1)
+	y1 = seg->bbox.y1;
+      n_edges += seg->n_points - 1;
+    }
+
+  index->x1 = x1;
+  index->y1 = y1;
+
+  /* roughly square cells, about one per edge */
+  if (x1 - index->x0 <= 0 || y1 - index->y0 <= 0)
+    {
+      index->n_cols = y1 - index->y0 > 0 ? 1 : MAX (n_edges, 1);
+      index->n_rows = x1 - index->x0 > 0 ? 1 : MAX (n_edges, 1);
+      if (x1 - index->x0 <= 0 && y1 - index->y0 <= 0)
+	index->n_cols = index->n_rows = 1;
+    }
+  else
+    {
+      double aspect = (x1 - index->x0) / (y1 - index->y0);
+
+      index->n_cols = (int)ceil (sqrt (n_edges * aspect));
+      index->n_rows = (int)ceil (sqrt (n_edges / aspect));
+      index->n_cols = MAX (1, MIN (index->n_cols, n_edges));
+      index->n_rows = MAX (1, MIN (index->n_rows, n_edges));
+    }
+  index->cell_w = (x1 - index->x0) / index->n_cols;
+  if (index->cell_w <= 0)
+    index->cell_w = 1e12;
+  index->cell_h = (y1 - index->y0) / index->n_rows;
+  if (index->cell_h <= 0)
+    index->cell_h = 1e12;
+  n_cells = index->n_cols * index->n_rows;
+
+  /* count, then fill, the row and cell lists */
+  index->row_start = art_new (int, index->n_rows + 1);
+  index->cell_start = art_new (int, n_cells + 1);
+  for (i = 0; i <= index->n_rows; i++)
+    index->row_start[i] = 0;
+  for (i = 0; i <= n_cells; i++)
+    index->cell_start[i] = 0;
+  for (i = 0; i < svp->n_segs; i++)
+    {
+      const ArtSVPSeg *seg = &svp->segs[i];
+
+      r0 = art_svp_index_row (index, seg->bbox.y0);
+      r1 = art_svp_index_row (index, seg->bbox.y1);
+      for (row = r0; row <= r1; row++)
+	index->row_start[row + 1]++;
+      for (j = 0; j < seg->n_points - 1; j++)
+	{
+	  r0 = art_svp_index_row (index, seg->points[j].y);
+	  r1 = art_svp_index_row (index, seg->points[j + 1].y);
+	  for (row = r0; row <= r1; row++)
+	    {
+	      art_svp_index_edge_cols (index, seg, j, row, &c0, &c1);
+	      for (col = c0; col <= c1; col++)
+		index->cell_start[row * index->n_cols + col + 1]++;
+	    }
+	}
+    }
+  for (i = 0; i < index->n_rows; i++)
+    index->row_start[i + 1] += index->row_start[i];
+  for (i = 0; i < n_cells; i++)
+    index->cell_start[i + 1] += index->cell_start[i];
+
+  index->row_segs = art_new (int, index->row_start[index->n_rows]);
+  index->cell_edges = art_new (ArtSVPIndexEdge, index->cell_start[n_cells]);
+  fill = art_new (int, MAX (index->n_rows, n_cells));
+  for (i = 0; i < index->n_rows; i++)
+    fill[i] = index->row_start[i];
+  for (i = 0; i < svp->n_segs; i++)
+    {
+      const ArtSVPSeg *seg = &svp->segs[i];
+
+      r0 = art_svp_index_row (index, seg->bbox.y0);
+      r1 = art_svp_index_row (index, seg->bbox.y1);
+      for (row = r0; row <= r1; row++)
+	index->row_segs[fill[row]++] = i;
+    }
+  for (i = 0; i < n_cells; i++)
+    fill[i] = index->cell_start[i];
+  for (i = 0; i < svp->n_segs; i++)
+    {
+      const ArtSVPSeg *seg = &svp->segs[i];
+
+      for (j = 0; j < seg->n_points - 1; j++)
+	{
+	  r0 = art_svp_index_row (index, seg->points[j].y);
+	  r1 = art_svp_index_row (index, seg->points[j + 1].y);
+	  for (row = r0; row <= r1; row++)
+	    {
+	      art_svp_index_edge_cols (index, seg, j, row, &c0, &c1);
+	      for (col = c0; col <= c1; col++)
+		{
+		  k = fill[row * index->n_cols + col]++;
+		  index->cell_edges[k].seg = i;
+		  index->cell_edges[k].j = j;
+		}
+	    }
+	}
+    }
+  art_free (fill);
+
+  return index;
+}
+
+/**
+ * art_svp_index_free: Free an svp index.
+ * @index: The index, as returned by art_svp_index_new().
+ *
+ * Frees @index. The svp it was built over is not affected.
+ **/
+void
+art_svp_index_free (ArtSVPIndex *index)
+{
+  art_free (index->row_start);
+  art_free (index->row_segs);
+  art_free (index->cell_start);
+  art_free (index->cell_edges);
+  art_free (index);
+}
+
+/**
+ * art_svp_index_point_wind: Determine winding number of a point using an index.
+ * @index: The index, as returned by art_svp_index_new().
+ * @x: The X coordinate of the point.
+ * @y: The Y coordinate of the point.
+ *
+ * Determines the winding number of the point @x, @y with respect to
+ * the svp of @index, like art_svp_point_wind().
+ *
+ * Return value: the winding number.
+ **/
+int
+art_svp_index_point_wind (const ArtSVPIndex *index, double x, double y)
+{
+  const ArtSVP *svp = index->svp;
+  int row;
+  int i;
+  int wind = 0;
 
-	  double dx = x1 - x0;
-	  double dy = y1 - y0;
+  if (svp->n_segs == 0)
+    return 0;
 
-	  double dxx0 = x - x0;
-	  double dyy0 = y - y0;
+  row = art_svp_index_row (index, y);
+  for (i = index->row_start[row]; i < index->row_start[row + 1]; i++)
+    wind += art_svp_seg_wind (&svp->segs[index->row_segs[i]], x, y);
 
-	  double dot = dxx0 * dx + dyy0 * dy;
+  return wind;
+}
 
-	  if (dot < 0)
-	    dist_sq = dxx0 * dxx0 + dyy0 * dyy0;
+/**
+ * art_svp_index_point_dist: Determine distance between point and svp using an index.
+ * @index: The index, as returned by art_svp_index_new().
+ * @x: The X coordinate of the point.
+ * @y: The Y coordinate of the point.
+ *
+ * Determines the distance of the point @x, @y to the closest edge in
+ * the svp of @index, like art_svp_point_dist().
+ *
+ * Return value: the distance.
+ **/
+double
+art_svp_index_point_dist (const ArtSVPIndex *index, double x, double y)
+{
+  const ArtSVP *svp = index->svp;
+  int cx, cy;
+  int r, row, col, col_step;
+  int row0, row1, col0, col1;
+  int i;
+  double gap_x, gap_y;
+  double lower, lower_sq;
+  double dist_sq;
+  double best_sq = -1;
+
+  cx = art_svp_index_col (index, x);
+  cy = art_svp_index_row (index, y);
+  /* distance from the point to the bounding box */
+  gap_x = MAX (index->x0 - x, x - index->x1);
+  gap_x = MAX (gap_x, 0);
+  gap_y = MAX (index->y0 - y, y - index->y1);
+  gap_y = MAX (gap_y, 0);
+  for (r = 0; r < index->n_cols || r < index->n_rows; r++)
+    {
+      /* every cell of ring r is at least r - 1 columns or rows away,
+	 where the grid extends that far, on top of the distance to the
+	 grid in the other direction */
+      if (best_sq >= 0 && r > 0)
+	{
+	  lower_sq = 1e24;
+	  if (cx - r >= 0 || cx + r < index->n_cols)
+	    {
+	      lower = (r - 1) * index->cell_w;
+	      lower_sq = lower * lower + gap_y * gap_y;
+	    }
+	  if (cy - r >= 0 || cy + r < index->n_rows)
+	    {
+	      lower = (r - 1) * index->cell_h;
+	      lower = lower * lower + gap_x * gap_x;
+	      if (lower < lower_sq)
+		lower_sq = lower;
+	    }
+	  if (lower_sq >= best_sq)
+	    break;
+	}
+      row0 = MAX (cy - r, 0);
+      row1 = MIN (cy + r, index->n_rows - 1);
+      col0 = MAX (cx - r, 0);
+      col1 = MIN (cx + r, index->n_cols - 1);
+      for (row = row0; row <= row1; row++)
+	{
+	  /* inner rows of the ring only have their two end cells */
+	  if (row == cy - r || row == cy + r)
+	    {
+	      col = col0;
+	      col_step = 1;
+	    }
 	  else
 	    {
-	      double rr = dx * dx + dy * dy;
+	      col = cx - r;
+	      col_step = 2 * r;
+	    }
+	  for (; col <= col1; col += col_step)
+	    {
+	      const int *cell;
+	      double cell_x0, cell_y0, cell_gap_x, cell_gap_y;
 
-	      if (dot > rr)
-		dist_sq = (x - x1) * (x - x1) + (y - y1) * (y - y1);
-	      else
+	      if (col < 0)
+		continue;
+	      /* skip cells that can't hold a closer edge */
+	      cell_x0 = index->x0 + col * index->cell_w;
+	      cell_y0 = index->y0 + row * index->cell_h;
+	      cell_gap_x = MAX (cell_x0 - x,
+				x - MIN (cell_x0 + index->cell_w, index->x1));
+	      cell_gap_y = MAX (cell_y0 - y,
+				y - MIN (cell_y0 + index->cell_h, index->y1));
+	      cell_gap_x = MAX (cell_gap_x, 0);
+	      cell_gap_y = MAX (cell_gap_y, 0);
+	      if (best_sq >= 0 &&
+		  cell_gap_x * cell_gap_x + cell_gap_y * cell_gap_y >= best_sq)
+		continue;
+
+	      cell = index->cell_start + row * index->n_cols + col;
+	      for (i = cell[0]; i < cell[1]; i++)
 		{
-		  double perp = (y - y0) * dx - (x - x0) * dy;
+		  const ArtSVPIndexEdge *edge = &index->cell_edges[i];
 
-		  dist_sq = perp * perp / rr;
+		  dist_sq = art_svp_edge_dist_sq (&svp->segs[edge->seg],
+						  edge->j, x, y);
+		  if (best_sq < 0 || dist_sq < best_sq)
+		    best_sq = dist_sq;
 		}
 	    }
-	  if (best_sq < 0 || dist_sq < best_sq)
-	    best_sq = dist_sq;
 	}
     }
 
@@ -142,3 +564,44 @@ art_svp_point_dist (ArtSVP *svp, double x, double y)
     return 1e12;
 }
 
+/**
+ * art_svp_index_point_wind_batch: Determine winding numbers of many points.
+ * @index: The index, as returned by art_svp_index_new().
+ * @points: The points.
+ * @n_points: Number of points.
+ * @winds: Where to store the @n_points winding numbers.
+ *
+ * Determines the winding number of each of @points, as
+ * art_svp_index_point_wind() does.
+ **/
+void
+art_svp_index_point_wind_batch (const ArtSVPIndex *index,
+				const ArtPoint *points, int n_points,
+				int *winds)
+{
+  int i;
+
+  for (i = 0; i < n_points; i++)
+    winds[i] = art_svp_index_point_wind (index, points[i].x, points[i].y);
+}
+
+/**
+ * art_svp_index_point_dist_batch: Determine distances of many points.
+ * @index: The index, as returned by art_svp_index_new().
+ * @points: The points.
+ * @n_points: Number of points.
+ * @dists: Where to store the @n_points distances.
+ *
+ * Determines the distance of each of @points to the svp, as
+ * art_svp_index_point_dist() does.
+ **/
+void
+art_svp_index_point_dist_batch (const ArtSVPIndex *index,
+				const ArtPoint *points, int n_points,
+				double *dists)
+{
+  int i;
+
+  for (i = 0; i < n_points; i++)
+    dists[i] = art_svp_index_point_dist (index, points[i].x, points[i].y);
+}
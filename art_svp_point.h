@@ -23,8 +23,10 @@
 /* Determine whether a point is inside, or near, an svp. */
 
 #ifdef LIBART_COMPILATION
+#include "art_point.h"
 #include "art_svp.h"
 #else
+#include <libart_lgpl/art_point.h>
 #include <libart_lgpl/art_svp.h>
 #endif
 
@@ -38,6 +40,31 @@ art_svp_point_wind (ArtSVP *svp, double x, double y);
 double
 art_svp_point_dist (ArtSVP *svp, double x, double y);
 
+/* A prebuilt index over an svp, for answering many point queries. */
+typedef struct _ArtSVPIndex ArtSVPIndex;
+
+ArtSVPIndex *
+art_svp_index_new (const ArtSVP *svp);
+
+void
+art_svp_index_free (ArtSVPIndex *index);
+
+int
+art_svp_index_point_wind (const ArtSVPIndex *index, double x, double y);
+
+double
+art_svp_index_point_dist (const ArtSVPIndex *index, double x, double y);
+
+void
+art_svp_index_point_wind_batch (const ArtSVPIndex *index,
+				const ArtPoint *points, int n_points,
+				int *winds);
+
+void
+art_svp_index_point_dist_batch (const ArtSVPIndex *index,
+				const ArtPoint *points, int n_points,
+				double *dists);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -34,7 +34,17 @@
 typedef double artfloat;
 
 struct _ArtSVPRenderAAIter {
-  const ArtSVP *svp;
+  const ArtSVPSeg *segs;
+  int n_segs;
+  /* For a single precision svp, segs are the segments of fsegs, whose
+     points are only converted while the segment is active. The
+     converted points are kept in scratch, at offset seg_off of each
+     segment. */
+  const ArtSVPF *svpf;
+  ArtSVPSeg *fsegs;
+  int *seg_off;
+  ArtPoint *scratch;
+  int n_scratch, n_scratch_max;
   int x0, x1;
   int y;
   int seg_ix;
@@ -127,28 +137,160 @@ art_svp_render_delete_active (int *active_segs, int j, int n_active_segs)
 
 */
 
-ArtSVPRenderAAIter *
-art_svp_render_aa_iter (const ArtSVP *svp,
-			int x0, int y0, int x1, int y1)
+static ArtSVPRenderAAIter *
+art_svp_render_aa_iter_new (const ArtSVPSeg *segs, int n_segs,
+			    int x0, int y0, int x1, int y1)
 {
   ArtSVPRenderAAIter *iter = art_new (ArtSVPRenderAAIter, 1);
 
-  iter->svp = svp;
+  iter->segs = segs;
+  iter->n_segs = n_segs;
+  iter->svpf = NULL;
+  iter->fsegs = NULL;
+  iter->seg_off = NULL;
+  iter->scratch = NULL;
   iter->y = y0;
   iter->x0 = x0;
   iter->x1 = x1;
   iter->seg_ix = 0;
 
-  iter->active_segs = art_new (int, svp->n_segs);
-  iter->cursor = art_new (int, svp->n_segs);
-  iter->seg_x = art_new (artfloat, svp->n_segs);
-  iter->seg_dx = art_new (artfloat, svp->n_segs);
+  iter->active_segs = art_new (int, n_segs);
+  iter->cursor = art_new (int, n_segs);
+  iter->seg_x = art_new (artfloat, n_segs);
+  iter->seg_dx = art_new (artfloat, n_segs);
   iter->steps = art_new (ArtSVPRenderAAStep, x1 - x0);
   iter->n_active_segs = 0;
 
   return iter;
 }
 
+ArtSVPRenderAAIter *
+art_svp_render_aa_iter (const ArtSVP *svp,
+			int x0, int y0, int x1, int y1)
+{
+  return art_svp_render_aa_iter_new (svp->segs, svp->n_segs,
+				     x0, y0, x1, y1);
+}
+
+/**
+ * art_svp_render_aa_iter_float: Create an iterator over a single
+ * precision svp.
+ * @svp: The #ArtSVPF to render.
+ * @x0: Left coordinate of destination rectangle.
+ * @y0: Top coordinate of destination rectangle.
+ * @x1: Right coordinate of destination rectangle.
+ * @y1: Bottom coordinate of destination rectangle.
+ *
+ * Same as art_svp_render_aa_iter(), for an #ArtSVPF. The scan
+ * conversion itself still runs in double precision, but only the
+ * points of the segments crossing the current scan line are held in
+ * double precision at any time, so @svp need not be converted as a
+ * whole. Since the points of @svp are rounded to float, the coverage
+ * can differ by one level along edges from that of the double
+ * precision svp it was made from.
+ *
+ * Return value: The iterator, to be used as any other from
+ * art_svp_render_aa_iter().
+ **/
+ArtSVPRenderAAIter *
+art_svp_render_aa_iter_float (const ArtSVPF *svp,
+			      int x0, int y0, int x1, int y1)
+{
+  ArtSVPRenderAAIter *iter;
+  ArtSVPSeg *fsegs;
+  int i;
+
+  fsegs = art_new (ArtSVPSeg, svp->n_segs);
+  for (i = 0; i < svp->n_segs; i++)
+    {
+      fsegs[i].n_points = svp->segs[i].n_points;
+      fsegs[i].dir = svp->segs[i].dir;
+      fsegs[i].bbox = svp->segs[i].bbox;
+      fsegs[i].points = NULL;
+    }
+  iter = art_svp_render_aa_iter_new (fsegs, svp->n_segs, x0, y0, x1, y1);
+  iter->svpf = svp;
+  iter->fsegs = fsegs;
+  iter->seg_off = art_new (int, svp->n_segs);
+  iter->n_scratch = 0;
+  iter->n_scratch_max = 64;
+  iter->scratch = art_new (ArtPoint, iter->n_scratch_max);
+  return iter;
+}
+
+/* Make room for @n more points at the end of the scratch buffer,
+   moving the points of the @n_active_segs active segments to its
+   start, in the order they are stored. The buffer is grown when they
+   fill more than half of it, so that it is not compacted again right
+   away. */
+static void
+art_svp_render_aa_scratch_compact (ArtSVPRenderAAIter *iter,
+				   int n_active_segs, int n)
+{
+  int *active_segs = iter->active_segs;
+  int n_scratch = 0;
+  int j, k, seg_index;
+
+  for (;;)
+    {
+      /* the active segment stored first among those not moved yet */
+      seg_index = -1;
+      for (j = 0; j < n_active_segs; j++)
+	{
+	  k = active_segs[j];
+	  if (iter->seg_off[k] >= n_scratch &&
+	      (seg_index < 0 || iter->seg_off[k] < iter->seg_off[seg_index]))
+	    seg_index = k;
+	}
+      if (seg_index < 0)
+	break;
+      memmove (iter->scratch + n_scratch,
+	       iter->scratch + iter->seg_off[seg_index],
+	       iter->fsegs[seg_index].n_points * sizeof (ArtPoint));
+      iter->seg_off[seg_index] = n_scratch;
+      n_scratch += iter->fsegs[seg_index].n_points;
+    }
+  iter->n_scratch = n_scratch;
+
+  if (2 * (n_scratch + n) > iter->n_scratch_max)
+    {
+      do
+	iter->n_scratch_max <<= 1;
+      while (2 * (n_scratch + n) > iter->n_scratch_max);
+      iter->scratch = art_renew (iter->scratch, ArtPoint,
+				 iter->n_scratch_max);
+    }
+  for (j = 0; j < n_active_segs; j++)
+    {
+      k = active_segs[j];
+      iter->fsegs[k].points = iter->scratch + iter->seg_off[k];
+    }
+}
+
+/* Convert the points of single precision segment @i into the scratch
+   buffer as it becomes active, next to the @n_active_segs segments
+   already active. */
+static void
+art_svp_render_aa_activate_float (ArtSVPRenderAAIter *iter, int i,
+				  int n_active_segs)
+{
+  const ArtSVPSegF *segf = &iter->svpf->segs[i];
+  ArtPoint *points;
+  int j;
+
+  if (iter->n_scratch + segf->n_points > iter->n_scratch_max)
+    art_svp_render_aa_scratch_compact (iter, n_active_segs, segf->n_points);
+  iter->seg_off[i] = iter->n_scratch;
+  points = iter->scratch + iter->n_scratch;
+  iter->n_scratch += segf->n_points;
+  for (j = 0; j < segf->n_points; j++)
+    {
+      points[j].x = segf->points[j].x;
+      points[j].y = segf->points[j].y;
+    }
+  iter->fsegs[i].points = points;
+}
+
 #define ADD_STEP(xpos, xdelta)                          \
   /* stereotype code fragment for adding a step */      \
   if (n_steps == 0 || steps[n_steps - 1].x < xpos)      \
@@ -187,7 +329,8 @@ void
 art_svp_render_aa_iter_step (ArtSVPRenderAAIter *iter, int *p_start,
 			     ArtSVPRenderAAStep **p_steps, int *p_n_steps)
 {
-  const ArtSVP *svp = iter->svp;
+  const ArtSVPSeg *segs = iter->segs;
+  int n_segs = iter->n_segs;
   int *active_segs = iter->active_segs;
   int n_active_segs = iter->n_active_segs;
   int *cursor = iter->cursor;
@@ -219,12 +362,14 @@ art_svp_render_aa_iter_step (ArtSVPRenderAAIter *iter, int *p_start,
   int sx;
   
   /* insert new active segments */
-  for (; i < svp->n_segs && svp->segs[i].bbox.y0 < y + 1; i++)
+  for (; i < n_segs && segs[i].bbox.y0 < y + 1; i++)
     {
-      if (svp->segs[i].bbox.y1 > y &&
-	  svp->segs[i].bbox.x0 < x1)
+      if (segs[i].bbox.y1 > y &&
+	  segs[i].bbox.x0 < x1)
 	{
-	  seg = &svp->segs[i];
+	  if (iter->fsegs != NULL)
+	    art_svp_render_aa_activate_float (iter, i, n_active_segs);
+	  seg = &segs[i];
 	  /* move cursor to topmost vector which overlaps [y,y+1) */
 	  for (curs = 0; seg->points[curs + 1].y < y; curs++);
 	  cursor[i] = curs;
@@ -249,7 +394,7 @@ art_svp_render_aa_iter_step (ArtSVPRenderAAIter *iter, int *p_start,
   for (j = 0; j < n_active_segs; j++)
     {
       seg_index = active_segs[j];
-      seg = &svp->segs[seg_index];
+      seg = &segs[seg_index];
       curs = cursor[seg_index];
       while (curs != seg->n_points - 1 &&
 	     seg->points[curs].y < y + 1)
@@ -372,6 +517,8 @@ art_svp_render_aa_iter_step (ArtSVPRenderAAIter *iter, int *p_start,
 	}
       else
 	{
+	  if (iter->fsegs != NULL)
+	    iter->fsegs[seg_index].points = NULL;
 	  art_svp_render_delete_active (active_segs, j--,
 					--n_active_segs);
 	}
@@ -389,6 +536,12 @@ art_svp_render_aa_iter_step (ArtSVPRenderAAIter *iter, int *p_start,
 void
 art_svp_render_aa_iter_done (ArtSVPRenderAAIter *iter)
 {
+  if (iter->fsegs != NULL)
+    {
+      art_free (iter->scratch);
+      art_free (iter->seg_off);
+      art_free (iter->fsegs);
+    }
   art_free (iter->steps);
 
   art_free (iter->seg_dx);
@@ -453,6 +606,45 @@ art_svp_render_aa (const ArtSVP *svp,
   iter = art_svp_render_aa_iter (svp, x0, y0, x1, y1);
 
 
+  for (y = y0; y < y1; y++)
+    {
+      art_svp_render_aa_iter_step (iter, &start, &steps, &n_steps);
+      (*callback) (callback_data, y, start, steps, n_steps);
+    }
+
+  art_svp_render_aa_iter_done (iter);
+}
+
+/**
+ * art_svp_render_aa_float: Render single precision SVP antialiased.
+ * @svp: The #ArtSVPF to render.
+ * @x0: Left coordinate of destination rectangle.
+ * @y0: Top coordinate of destination rectangle.
+ * @x1: Right coordinate of destination rectangle.
+ * @y1: Bottom coordinate of destination rectangle.
+ * @callback: The callback which actually paints the pixels.
+ * @callback_data: Private data for @callback.
+ *
+ * Same as art_svp_render_aa(), for an #ArtSVPF.
+ **/
+void
+art_svp_render_aa_float (const ArtSVPF *svp,
+			 int x0, int y0, int x1, int y1,
+			 void (*callback) (void *callback_data,
+					   int y,
+					   int start,
+					   ArtSVPRenderAAStep *steps,
+					   int n_steps),
+			 void *callback_data)
+{
+  ArtSVPRenderAAIter *iter;
+  int y;
+  int start;
+  ArtSVPRenderAAStep *steps;
+  int n_steps;
+
+  iter = art_svp_render_aa_iter_float (svp, x0, y0, x1, y1);
+
   for (y = y0; y < y1; y++)
     {
       art_svp_render_aa_iter_step (iter, &start, &steps, &n_steps);
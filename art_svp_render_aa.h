@@ -44,6 +44,10 @@ ArtSVPRenderAAIter *
 art_svp_render_aa_iter (const ArtSVP *svp,
 			int x0, int y0, int x1, int y1);
 
+ArtSVPRenderAAIter *
+art_svp_render_aa_iter_float (const ArtSVPF *svp,
+			      int x0, int y0, int x1, int y1);
+
 void
 art_svp_render_aa_iter_step (ArtSVPRenderAAIter *iter, int *p_start,
 			     ArtSVPRenderAAStep **p_steps, int *p_n_steps);
@@ -60,6 +64,16 @@ art_svp_render_aa (const ArtSVP *svp,
 				     ArtSVPRenderAAStep *steps, int n_steps),
 		   void *callback_data);
 
+void
+art_svp_render_aa_float (const ArtSVPF *svp,
+			 int x0, int y0, int x1, int y1,
+			 void (*callback) (void *callback_data,
+					   int y,
+					   int start,
+					   ArtSVPRenderAAStep *steps,
+					   int n_steps),
+			 void *callback_data);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -0,0 +1,269 @@
+/*
+ * art_svp_rle.c: Run-length coverage masks from the antialiased renderer.
+ *
+ * Libart_LGPL - library of basic graphic primitives
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#include "config.h"
+#include "art_svp_rle.h"
+
+#include "art_misc.h"
+
+#ifndef MAX
+#define MAX(a, b)  (((a) > (b)) ? (a) : (b))
+#endif /* MAX */
+
+#ifndef MIN
+#define MIN(a, b)  (((a) < (b)) ? (a) : (b))
+#endif /* MIN */
+
+/* The value of no coverage in the renderer's steps. */
+#define ART_RLE_ZERO 0x8000
+
+/**
+ * art_svp_render_to_rle: Rasterize an svp into a run-length coverage mask.
+ * @svp: The svp.
+ * @x0: Left coordinate of the mask rectangle.
+ * @y0: Top coordinate of the mask rectangle.
+ * @x1: Right coordinate of the mask rectangle.
+ * @y1: Bottom coordinate of the mask rectangle.
+ *
+ * Runs the antialiased renderer over @svp within the rectangle and
+ * keeps its output, the starting coverage and the coverage steps of
+ * every row, instead of expanding it into a full buffer. A row needs
+ * a few steps per edge it crosses, so shapes that are cached, such as
+ * icons and glyphs, take much less memory than as gray buffers, and
+ * art_svp_rle_render_aa() or art_render_svp_rle() replay them without
+ * rasterizing again.
+ *
+ * Return value: The new mask, to be freed with art_svp_rle_free().
+ **/
+ArtSVPRle *
+art_svp_render_to_rle (const ArtSVP *svp, int x0, int y0, int x1, int y1)
+{
+  ArtSVPRle *rle;
+  ArtSVPRenderAAIter *iter;
+  ArtSVPRenderAAStep *steps;
+  int n_steps, n_steps_max;
+  int start;
+  int height;
+  int y, i;
+
+  rle = art_new (ArtSVPRle, 1);
+  rle->x0 = x0;
+  rle->y0 = y0;
+  rle->x1 = x1;
+  rle->y1 = y1;
+  height = y1 > y0 ? y1 - y0 : 0;
+  rle->row_value = art_new (int, height + 1);
+  rle->row_start = art_new (int, height + 1);
+
+  n_steps_max = 16;
+  rle->steps = art_new (ArtSVPRenderAAStep, n_steps_max);
+  rle->row_start[0] = 0;
+
+  iter = art_svp_render_aa_iter (svp, x0, y0, x1, y1);
+  for (y = 0; y < height; y++)
+    {
+      art_svp_render_aa_iter_step (iter, &start, &steps, &n_steps);
+      rle->row_value[y] = start;
+      while (rle->row_start[y] + n_steps > n_steps_max)
+	art_expand (rle->steps, ArtSVPRenderAAStep, n_steps_max);
+      for (i = 0; i < n_steps; i++)
+	rle->steps[rle->row_start[y] + i] = steps[i];
+      rle->row_start[y + 1] = rle->row_start[y] + n_steps;
+    }
+  art_svp_render_aa_iter_done (iter);
+
+  /* trim to size */
+  if (rle->row_start[height] > 0)
+    rle->steps = art_renew (rle->steps, ArtSVPRenderAAStep,
+			    rle->row_start[height]);
+
+  return rle;
+}
+
+/**
+ * art_svp_rle_free: Free a run-length coverage mask.
+ * @rle: The mask.
+ *
+ * Frees a mask created by art_svp_render_to_rle().
+ **/
+void
+art_svp_rle_free (ArtSVPRle *rle)
+{
+  art_free (rle->row_value);
+  art_free (rle->row_start);
+  art_free (rle->steps);
+  art_free (rle);
+}
+
+/* Convert row @y of @rle to the start value and steps of the range
+   [@x0, @x1), storing the steps in @out, which has room for two more
+   steps than the row. Returns the number of steps. */
+static int
+art_svp_rle_row (const ArtSVPRle *rle, int y, int x0, int x1,
+		 int *p_start, ArtSVPRenderAAStep *out)
+{
+  const ArtSVPRenderAAStep *steps;
+  int n_steps;
+  int value, cur;
+  int n_out = 0;
+  int k = 0;
+  int x;
+
+  if (y < rle->y0 || y >= rle->y1 || x0 >= rle->x1)
+    {
+      *p_start = ART_RLE_ZERO;
+      return 0;
+    }
+  steps = rle->steps + rle->row_start[y - rle->y0];
+  n_steps = rle->row_start[y - rle->y0 + 1] - rle->row_start[y - rle->y0];
+  value = rle->row_value[y - rle->y0];
+
+  /* coverage at x0 */
+  if (x0 < rle->x0 || x0 >= rle->x1)
+    cur = ART_RLE_ZERO;
+  else
+    {
+      for (; k < n_steps && steps[k].x <= x0; k++)
+	value += steps[k].delta;
+      cur = value;
+    }
+  *p_start = cur;
+
+  /* the mask switches on at its left edge */
+  if (x0 < rle->x0 && rle->x0 < x1)
+    {
+      for (; k < n_steps && steps[k].x <= rle->x0; k++)
+	value += steps[k].delta;
+      if (value != cur)
+	{
+	  out[n_out].x = rle->x0;
+	  out[n_out].delta = value - cur;
+	  n_out++;
+	  cur = value;
+	}
+    }
+  else if (x0 < rle->x0)
+    return 0;
+
+  while (k < n_steps && steps[k].x < x1)
+    {
+      x = steps[k].x;
+      for (; k < n_steps && steps[k].x == x; k++)
+	value += steps[k].delta;
+      if (value != cur)
+	{
+	  out[n_out].x = x;
+	  out[n_out].delta = value - cur;
+	  n_out++;
+	  cur = value;
+	}
+    }
+
+  /* and off at its right edge */
+  if (rle->x1 > x0 && rle->x1 < x1 && cur != ART_RLE_ZERO)
+    {
+      out[n_out].x = rle->x1;
+      out[n_out].delta = ART_RLE_ZERO - cur;
+      n_out++;
+    }
+
+  return n_out;
+}
+
+/**
+ * art_svp_rle_render_aa: Replay a run-length coverage mask.
+ * @rle: The mask.
+ * @x0: Left coordinate of destination rectangle.
+ * @y0: Top coordinate of destination rectangle.
+ * @x1: Right coordinate of destination rectangle.
+ * @y1: Bottom coordinate of destination rectangle.
+ * @callback: The callback which is invoked for each scan line.
+ * @callback_data: Data for @callback.
+ *
+ * Calls @callback for each row of the rectangle exactly as
+ * art_svp_render_aa() would for the svp @rle was made from, so any
+ * of the antialiased renderer's callbacks can draw the mask. Where the
+ * rectangle extends past the mask, the coverage is zero.
+ **/
+void
+art_svp_rle_render_aa (const ArtSVPRle *rle,
+		       int x0, int y0, int x1, int y1,
+		       void (*callback) (void *callback_data,
+					 int y,
+					 int start,
+					 ArtSVPRenderAAStep *steps, int n_steps),
+		       void *callback_data)
+{
+  art_svp_rle_render_aa_offset (rle, 0, 0, x0, y0, x1, y1,
+				callback, callback_data);
+}
+
+/**
+ * art_svp_rle_render_aa_offset: Replay a translated run-length coverage mask.
+ * @rle: The mask.
+ * @dx: Horizontal offset of the mask, in pixels.
+ * @dy: Vertical offset of the mask, in pixels.
+ * @x0: Left coordinate of destination rectangle.
+ * @y0: Top coordinate of destination rectangle.
+ * @x1: Right coordinate of destination rectangle.
+ * @y1: Bottom coordinate of destination rectangle.
+ * @callback: The callback which is invoked for each scan line.
+ * @callback_data: Data for @callback.
+ *
+ * Like art_svp_rle_render_aa(), but draws the mask moved by (@dx, @dy),
+ * as if it had been made from the svp translated by that offset.
+ **/
+void
+art_svp_rle_render_aa_offset (const ArtSVPRle *rle, int dx, int dy,
+			      int x0, int y0, int x1, int y1,
+			      void (*callback) (void *callback_data,
+						int y,
+						int start,
+						ArtSVPRenderAAStep *steps,
+						int n_steps),
+			      void *callback_data)
+{
+  ArtSVPRenderAAStep *steps;
+  int n_steps_max;
+  int start;
+  int n_steps;
+  int y, i;
+
+  n_steps_max = 2;
+  for (y = MAX (y0 - dy, rle->y0); y < MIN (y1 - dy, rle->y1); y++)
+    {
+      n_steps = rle->row_start[y - rle->y0 + 1] - rle->row_start[y - rle->y0];
+      if (n_steps + 2 > n_steps_max)
+	n_steps_max = n_steps + 2;
+    }
+  steps = art_new (ArtSVPRenderAAStep, n_steps_max);
+
+  for (y = y0; y < y1; y++)
+    {
+      n_steps = art_svp_rle_row (rle, y - dy, x0 - dx, x1 - dx, &start, steps);
+      if (dx != 0)
+	for (i = 0; i < n_steps; i++)
+	  steps[i].x += dx;
+      (*callback) (callback_data, y, start, steps, n_steps);
+    }
+
+  art_free (steps);
+}
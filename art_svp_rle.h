@@ -0,0 +1,82 @@
+/*
+ * art_svp_rle.h: Run-length coverage masks from the antialiased renderer.
+ *
+ * Libart_LGPL - library of basic graphic primitives
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifndef __ART_SVP_RLE_H__
+#define __ART_SVP_RLE_H__
+
+/* A coverage mask stored as the steps of the antialiased renderer,
+   which can be replayed without rasterizing the svp again. */
+
+#ifdef LIBART_COMPILATION
+#include "art_svp.h"
+#include "art_svp_render_aa.h"
+#else
+#include <libart_lgpl/art_svp.h>
+#include <libart_lgpl/art_svp_render_aa.h>
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+typedef struct _ArtSVPRle ArtSVPRle;
+
+/* Row y of the mask starts with coverage row_value[y - y0] at x0 and
+   changes by the steps from row_start[y - y0] up to (not including)
+   row_start[y - y0 + 1]. Coverage outside (x0, y0) - (x1, y1) is
+   zero. */
+struct _ArtSVPRle {
+  int x0, y0, x1, y1;
+  int *row_value;
+  int *row_start;
+  ArtSVPRenderAAStep *steps;
+};
+
+ArtSVPRle *
+art_svp_render_to_rle (const ArtSVP *svp, int x0, int y0, int x1, int y1);
+
+void
+art_svp_rle_free (ArtSVPRle *rle);
+
+void
+art_svp_rle_render_aa (const ArtSVPRle *rle,
+		       int x0, int y0, int x1, int y1,
+		       void (*callback) (void *callback_data,
+					 int y,
+					 int start,
+					 ArtSVPRenderAAStep *steps, int n_steps),
+		       void *callback_data);
+
+void
+art_svp_rle_render_aa_offset (const ArtSVPRle *rle, int dx, int dy,
+			      int x0, int y0, int x1, int y1,
+			      void (*callback) (void *callback_data,
+						int y,
+						int start,
+						ArtSVPRenderAAStep *steps,
+						int n_steps),
+			      void *callback_data);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __ART_SVP_RLE_H__ */
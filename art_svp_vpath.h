@@ -37,6 +37,9 @@ extern "C" {
 ArtSVP *
 art_svp_from_vpath (ArtVpath *vpath);
 
+ArtSVPF *
+art_svp_from_vpath_float (const ArtVpathF *vpath);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -27,6 +27,8 @@
 #include "art_misc.h"
 
 #include "art_vpath.h"
+#include "art_vpath_bpath.h"
+#include "art_vpath_dash.h"
 #include "art_svp.h"
 #ifdef ART_USE_NEW_INTERSECTOR
 #include "art_svp_intersect.h"
@@ -391,28 +393,22 @@ render_cap (ArtVpath **p_result, int *pn_result, int *pn_result_max,
     }
 }
 
-/**
- * art_svp_from_vpath_raw: Stroke a vector path, raw version
- * @vpath: #ArtVPath to stroke.
- * @join: Join style.
- * @cap: Cap style.
- * @line_width: Width of stroke.
- * @miter_limit: Miter limit.
- * @flatness: Flatness.
- *
- * Exactly the same as art_svp_vpath_stroke(), except that the resulting
- * stroke outline may self-intersect and have regions of winding number
- * greater than 1.
- *
- * Return value: Resulting raw stroked outline in svp format.
- **/
-ArtVpath *
-art_svp_vpath_stroke_raw (ArtVpath *vpath,
-			  ArtPathStrokeJoinType join,
-			  ArtPathStrokeCapType cap,
-			  double line_width,
-			  double miter_limit,
-			  double flatness)
+/* Stroke the subpaths of @vpath that begin at an index in
+   [@begin, @end), or all the way to the end of the path if @end is
+   negative, appending the outline to *@p_result. @begin must be the
+   index of a moveto. The forw and rev buffers are scratch space,
+   passed in so that they can be reused across calls. */
+static void
+art_svp_vpath_stroke_raw_append (ArtVpath *vpath, int begin, int end,
+				 ArtVpath **p_result, int *pn_result,
+				 int *pn_result_max,
+				 ArtVpath **p_forw, int *pn_forw_max,
+				 ArtVpath **p_rev, int *pn_rev_max,
+				 ArtPathStrokeJoinType join,
+				 ArtPathStrokeCapType cap,
+				 double line_width,
+				 double miter_limit,
+				 double flatness)
 {
   int begin_idx, end_idx;
   int i;
@@ -426,17 +422,17 @@ art_svp_vpath_stroke_raw (ArtVpath *vpath,
   int last, this, next, second;
   double dx, dy;
 
-  n_forw_max = 16;
-  forw = art_new (ArtVpath, n_forw_max);
-
-  n_rev_max = 16;
-  rev = art_new (ArtVpath, n_rev_max);
-
-  n_result = 0;
-  n_result_max = 16;
-  result = art_new (ArtVpath, n_result_max);
-
-  for (begin_idx = 0; vpath[begin_idx].code != ART_END; begin_idx = end_idx)
+  forw = *p_forw;
+  n_forw_max = *pn_forw_max;
+  rev = *p_rev;
+  n_rev_max = *pn_rev_max;
+  result = *p_result;
+  n_result = *pn_result;
+  n_result_max = *pn_result_max;
+
+  for (begin_idx = begin;
+       (end < 0 || begin_idx < end) && vpath[begin_idx].code != ART_END;
+       begin_idx = end_idx)
     {
       n_forw = 0;
       n_rev = 0;
@@ -554,6 +550,43 @@ art_svp_vpath_stroke_raw (ArtVpath *vpath,
       end_idx = next;
     }
 
+  *p_forw = forw;
+  *pn_forw_max = n_forw_max;
+  *p_rev = rev;
+  *pn_rev_max = n_rev_max;
+  *p_result = result;
+  *pn_result = n_result;
+  *pn_result_max = n_result_max;
+}
+
+static ArtVpath *
+art_svp_vpath_stroke_raw_range (ArtVpath *vpath, int begin, int end,
+				ArtPathStrokeJoinType join,
+				ArtPathStrokeCapType cap,
+				double line_width,
+				double miter_limit,
+				double flatness)
+{
+  ArtVpath *forw, *rev;
+  int n_forw_max, n_rev_max;
+  ArtVpath *result;
+  int n_result, n_result_max;
+
+  n_forw_max = 16;
+  forw = art_new (ArtVpath, n_forw_max);
+
+  n_rev_max = 16;
+  rev = art_new (ArtVpath, n_rev_max);
+
+  n_result = 0;
+  n_result_max = 16;
+  result = art_new (ArtVpath, n_result_max);
+
+  art_svp_vpath_stroke_raw_append (vpath, begin, end,
+				   &result, &n_result, &n_result_max,
+				   &forw, &n_forw_max, &rev, &n_rev_max,
+				   join, cap, line_width, miter_limit, flatness);
+
   art_free (forw);
   art_free (rev);
 #ifdef VERBOSE
@@ -563,6 +596,577 @@ art_svp_vpath_stroke_raw (ArtVpath *vpath,
   return result;
 }
 
+/**
+ * art_svp_from_vpath_raw: Stroke a vector path, raw version
+ * @vpath: #ArtVPath to stroke.
+ * @join: Join style.
+ * @cap: Cap style.
+ * @line_width: Width of stroke.
+ * @miter_limit: Miter limit.
+ * @flatness: Flatness.
+ *
+ * Exactly the same as art_svp_vpath_stroke(), except that the resulting
+ * stroke outline may self-intersect and have regions of winding number
+ * greater than 1.
+ *
+ * Return value: Resulting raw stroked outline in svp format.
+ **/
+ArtVpath *
+art_svp_vpath_stroke_raw (ArtVpath *vpath,
+			  ArtPathStrokeJoinType join,
+			  ArtPathStrokeCapType cap,
+			  double line_width,
+			  double miter_limit,
+			  double flatness)
+{
+  return art_svp_vpath_stroke_raw_range (vpath, 0, -1, join, cap,
+					 line_width, miter_limit, flatness);
+}
+
+/* Bezier stroking. Curves are offset as curves and only the offset
+   outline is flattened, so a smooth curve doesn't pick up a join at
+   every flattened vertex. */
+
+#define BEZ_STROKE_MAX_DEPTH 8
+
+/* Fraction of the flatness that the offset curves may be off by. It
+   is small, since the offset curves are flattened to within the full
+   flatness afterwards, and the two errors add up. */
+#define BEZ_STROKE_TOLERANCE 0.2
+
+/* Remove consecutive duplicate points from a vpath, in place. Points
+   closer than EPSILON count as duplicates: the same offset point is
+   often computed twice along different routes, and the few ulps of
+   difference would make a degenerate segment for the intersector. Of
+   two such linetos the later one is kept, as it may be the point that
+   closes the subpath exactly. */
+static void
+art_vpath_remove_dups (ArtVpath *vpath)
+{
+  int i, j;
+
+  if (vpath[0].code == ART_END)
+    return;
+  for (i = 1, j = 1; vpath[i].code != ART_END; i++)
+    {
+      if (vpath[i].code == ART_LINETO &&
+	  fabs (vpath[i].x - vpath[j - 1].x) < EPSILON &&
+	  fabs (vpath[i].y - vpath[j - 1].y) < EPSILON)
+	{
+	  if (vpath[j - 1].code == ART_LINETO)
+	    vpath[j - 1] = vpath[i];
+	  continue;
+	}
+      vpath[j++] = vpath[i];
+    }
+  vpath[j] = vpath[i];
+}
+
+/* Evaluate the cubic (bx, by) at t, storing the point in (*px, *py)
+   and the derivative in (*pdx, *pdy). */
+static void
+art_bez_eval (const double *bx, const double *by, double t,
+	      double *px, double *py, double *pdx, double *pdy)
+{
+  double mt = 1 - t;
+  double a = mt * mt * mt;
+  double b = 3 * mt * mt * t;
+  double c = 3 * mt * t * t;
+  double d = t * t * t;
+
+  *px = a * bx[0] + b * bx[1] + c * bx[2] + d * bx[3];
+  *py = a * by[0] + b * by[1] + c * by[2] + d * by[3];
+  *pdx = 3 * (mt * mt * (bx[1] - bx[0]) + 2 * mt * t * (bx[2] - bx[1]) +
+	      t * t * (bx[3] - bx[2]));
+  *pdy = 3 * (mt * mt * (by[1] - by[0]) + 2 * mt * t * (by[2] - by[1]) +
+	      t * t * (by[3] - by[2]));
+}
+
+/* Determine the start and end tangents of a cubic, falling back to
+   the next control point when a handle is degenerate. Returns FALSE
+   if all four points coincide. */
+static art_boolean
+art_bez_tangents (const double *bx, const double *by,
+		  double *ptx0, double *pty0, double *ptx1, double *pty1)
+{
+  int i;
+
+  for (i = 1; i < 4; i++)
+    {
+      *ptx0 = bx[i] - bx[0];
+      *pty0 = by[i] - by[0];
+      if (*ptx0 * *ptx0 + *pty0 * *pty0 > EPSILON_2)
+	break;
+    }
+  if (i == 4)
+    return ART_FALSE;
+  for (i = 2; i >= 0; i--)
+    {
+      *ptx1 = bx[3] - bx[i];
+      *pty1 = by[3] - by[i];
+      if (*ptx1 * *ptx1 + *pty1 * *pty1 > EPSILON_2)
+	break;
+    }
+  return ART_TRUE;
+}
+
+/* Signed curvature of a cubic, given the first and second
+   derivative at the point of interest. */
+static double
+art_bez_curvature (double dx, double dy, double ddx, double ddy)
+{
+  double d2 = dx * dx + dy * dy;
+
+  if (d2 < EPSILON_2)
+    return 0;
+  return (dx * ddy - dy * ddx) / (d2 * sqrt (d2));
+}
+
+/* Stroke a curve piece whose curvature is too tight for an offset
+   curve on the inside: flatten the centerline and join the pieces
+   like a polyline. */
+static void
+render_bez_seg_flat (ArtVpath **p_forw, int *pn_forw, int *pn_forw_max,
+		     ArtVpath **p_rev, int *pn_rev, int *pn_rev_max,
+		     const double *bx, const double *by,
+		     double half_lw, double miter_limit, double flatness)
+{
+  ArtVpath *vec;
+  int n_vec, n_vec_max;
+  int i0, i1, i2;
+  double dx, dy;
+
+  n_vec = 0;
+  n_vec_max = 16;
+  vec = art_new (ArtVpath, n_vec_max);
+  art_vpath_add_point (&vec, &n_vec, &n_vec_max, ART_MOVETO, bx[0], by[0]);
+  art_vpath_render_bez_analytic (&vec, &n_vec, &n_vec_max,
+				 bx[0], by[0], bx[1], by[1],
+				 bx[2], by[2], bx[3], by[3], flatness);
+
+  i0 = 0;
+  for (i1 = 1; i1 < n_vec; i1++)
+    {
+      dx = vec[i1].x - vec[i0].x;
+      dy = vec[i1].y - vec[i0].y;
+      if (dx * dx + dy * dy > EPSILON_2)
+	break;
+    }
+  while (i1 < n_vec)
+    {
+      for (i2 = i1 + 1; i2 < n_vec; i2++)
+	{
+	  dx = vec[i2].x - vec[i1].x;
+	  dy = vec[i2].y - vec[i1].y;
+	  if (dx * dx + dy * dy > EPSILON_2)
+	    break;
+	}
+      if (i2 == n_vec)
+	{
+	  /* end of the piece: bring both sides to the offset end */
+	  double tx0, ty0, tx1, ty1;
+	  double scale;
+
+	  if (art_bez_tangents (bx, by, &tx0, &ty0, &tx1, &ty1))
+	    {
+	      scale = half_lw / sqrt (tx1 * tx1 + ty1 * ty1);
+	      art_vpath_add_point (p_forw, pn_forw, pn_forw_max, ART_LINETO,
+				   bx[3] - ty1 * scale, by[3] + tx1 * scale);
+	      art_vpath_add_point (p_rev, pn_rev, pn_rev_max, ART_LINETO,
+				   bx[3] + ty1 * scale, by[3] - tx1 * scale);
+	    }
+	  break;
+	}
+      render_seg (p_forw, pn_forw, pn_forw_max,
+		  p_rev, pn_rev, pn_rev_max,
+		  vec, i0, i1, i2,
+		  ART_PATH_STROKE_JOIN_ROUND, half_lw, miter_limit, flatness);
+      i0 = i1;
+      i1 = i2;
+    }
+  art_free (vec);
+}
+
+/* Stroke the body of the cubic (bx, by). On entry, forw and rev are
+   at the offset start of the curve; on exit, they are at its offset
+   end. The offset curve on each side is approximated by a cubic whose
+   handles are scaled by the curvature at the endpoints; pieces where
+   that approximation is off by more than BEZ_STROKE_TOLERANCE *
+   @flatness are split. */
+static void
+render_bez_seg (ArtVpath **p_forw, int *pn_forw, int *pn_forw_max,
+		ArtVpath **p_rev, int *pn_rev, int *pn_rev_max,
+		const double *bx, const double *by,
+		double half_lw, double miter_limit, double flatness,
+		int depth)
+{
+  double tx0, ty0, tx1, ty1;
+  double scale;
+  double nx0, ny0, nx1, ny1;
+  double k0, k1;
+  double ox[2][4], oy[2][4];
+  art_boolean ok, tight;
+  int side, i;
+
+  if (!art_bez_tangents (bx, by, &tx0, &ty0, &tx1, &ty1))
+    return;
+
+  /* normals, scaled to half_lw, pointing the same way as dl[xy] in
+     render_seg */
+  scale = half_lw / sqrt (tx0 * tx0 + ty0 * ty0);
+  nx0 = ty0 * scale;
+  ny0 = -tx0 * scale;
+  scale = half_lw / sqrt (tx1 * tx1 + ty1 * ty1);
+  nx1 = ty1 * scale;
+  ny1 = -tx1 * scale;
+
+  k0 = art_bez_curvature (3 * (bx[1] - bx[0]), 3 * (by[1] - by[0]),
+			  6 * (bx[2] - 2 * bx[1] + bx[0]),
+			  6 * (by[2] - 2 * by[1] + by[0]));
+  k1 = art_bez_curvature (3 * (bx[3] - bx[2]), 3 * (by[3] - by[2]),
+			  6 * (bx[3] - 2 * bx[2] + bx[1]),
+			  6 * (by[3] - 2 * by[2] + by[1]));
+
+  /* side 0 is forw (offset by -n), side 1 is rev (offset by +n). The
+     derivative of the offset curve is the derivative of the curve
+     scaled by (1 + s * half_lw * k). */
+  ok = ART_TRUE;
+  tight = ART_FALSE;
+  for (side = 0; side < 2; side++)
+    {
+      double s = side ? 1 : -1;
+      double f0 = 1 + s * half_lw * k0;
+      double f1 = 1 + s * half_lw * k1;
+
+      if (f0 < 0.25 || f1 < 0.25)
+	{
+	  /* the offset curve has a cusp on this side */
+	  render_bez_seg_flat (p_forw, pn_forw, pn_forw_max,
+			       p_rev, pn_rev, pn_rev_max,
+			       bx, by, half_lw, miter_limit, flatness);
+	  return;
+	}
+      ox[side][0] = bx[0] + s * nx0;
+      oy[side][0] = by[0] + s * ny0;
+      ox[side][1] = ox[side][0] + (bx[1] - bx[0]) * f0;
+      oy[side][1] = oy[side][0] + (by[1] - by[0]) * f0;
+      ox[side][3] = bx[3] + s * nx1;
+      oy[side][3] = by[3] + s * ny1;
+      ox[side][2] = ox[side][3] + (bx[2] - bx[3]) * f1;
+      oy[side][2] = oy[side][3] + (by[2] - by[3]) * f1;
+
+      /* check the approximation against the true offset, and look
+	 for tight curvature inside the piece */
+      for (i = 1; i < 4 && !tight; i++)
+	{
+	  double t = i * 0.25;
+	  double px, py, dx, dy, len;
+	  double qx, qy, dqx, dqy;
+	  double ddx, ddy;
+
+	  art_bez_eval (bx, by, t, &px, &py, &dx, &dy);
+	  len = sqrt (dx * dx + dy * dy);
+	  if (len < EPSILON)
+	    {
+	      /* cusp */
+	      tight = ART_TRUE;
+	      break;
+	    }
+	  ddx = 6 * ((1 - t) * (bx[2] - 2 * bx[1] + bx[0]) +
+		     t * (bx[3] - 2 * bx[2] + bx[1]));
+	  ddy = 6 * ((1 - t) * (by[2] - 2 * by[1] + by[0]) +
+		     t * (by[3] - 2 * by[2] + by[1]));
+	  if (1 + s * half_lw * art_bez_curvature (dx, dy, ddx, ddy) < 0.25)
+	    {
+	      tight = ART_TRUE;
+	      break;
+	    }
+	  px += s * dy * half_lw / len;
+	  py -= s * dx * half_lw / len;
+	  art_bez_eval (ox[side], oy[side], t, &qx, &qy, &dqx, &dqy);
+	  if ((qx - px) * (qx - px) + (qy - py) * (qy - py) >
+	      BEZ_STROKE_TOLERANCE * BEZ_STROKE_TOLERANCE *
+	      flatness * flatness)
+	    ok = ART_FALSE;
+	}
+    }
+
+  if (tight)
+    {
+      /* a cusp in the offset curve or in the curve itself needs
+	 polyline joins to come out right */
+      render_bez_seg_flat (p_forw, pn_forw, pn_forw_max,
+			   p_rev, pn_rev, pn_rev_max,
+			   bx, by, half_lw, miter_limit, flatness);
+      return;
+    }
+
+  if (!ok && depth < BEZ_STROKE_MAX_DEPTH)
+    {
+      /* subdivide at t = 0.5 */
+      double lx[4], ly[4], rx[4], ry[4];
+
+      lx[0] = bx[0];
+      ly[0] = by[0];
+      lx[1] = (bx[0] + bx[1]) * 0.5;
+      ly[1] = (by[0] + by[1]) * 0.5;
+      lx[2] = (bx[0] + 2 * bx[1] + bx[2]) * 0.25;
+      ly[2] = (by[0] + 2 * by[1] + by[2]) * 0.25;
+      rx[3] = bx[3];
+      ry[3] = by[3];
+      rx[2] = (bx[2] + bx[3]) * 0.5;
+      ry[2] = (by[2] + by[3]) * 0.5;
+      rx[1] = (bx[1] + 2 * bx[2] + bx[3]) * 0.25;
+      ry[1] = (by[1] + 2 * by[2] + by[3]) * 0.25;
+      lx[3] = rx[0] = (lx[2] + rx[1]) * 0.5;
+      ly[3] = ry[0] = (ly[2] + ry[1]) * 0.5;
+      render_bez_seg (p_forw, pn_forw, pn_forw_max,
+		      p_rev, pn_rev, pn_rev_max,
+		      lx, ly, half_lw, miter_limit, flatness, depth + 1);
+      render_bez_seg (p_forw, pn_forw, pn_forw_max,
+		      p_rev, pn_rev, pn_rev_max,
+		      rx, ry, half_lw, miter_limit, flatness, depth + 1);
+      return;
+    }
+  art_vpath_add_point (p_forw, pn_forw, pn_forw_max,
+		       ART_LINETO, ox[0][0], oy[0][0]);
+  art_vpath_render_bez_analytic (p_forw, pn_forw, pn_forw_max,
+				 ox[0][0], oy[0][0], ox[0][1], oy[0][1],
+				 ox[0][2], oy[0][2], ox[0][3], oy[0][3],
+				 flatness);
+  art_vpath_add_point (p_rev, pn_rev, pn_rev_max,
+		       ART_LINETO, ox[1][0], oy[1][0]);
+  art_vpath_render_bez_analytic (p_rev, pn_rev, pn_rev_max,
+				 ox[1][0], oy[1][0], ox[1][1], oy[1][1],
+				 ox[1][2], oy[1][2], ox[1][3], oy[1][3],
+				 flatness);
+}
+
+/* Set up a three point vpath for render_seg or render_cap, with the
+   vertex (x, y) in the middle, entered in direction (tx0, ty0) from a
+   segment of length len0 and left in direction (tx1, ty1) along a
+   segment of length len1. */
+static void
+art_bez_stroke_vertex (ArtVpath *tmp, double x, double y,
+		       double tx0, double ty0, double len0,
+		       double tx1, double ty1, double len1)
+{
+  double scale;
+
+  scale = len0 / sqrt (tx0 * tx0 + ty0 * ty0);
+  tmp[0].code = ART_MOVETO;
+  tmp[0].x = x - tx0 * scale;
+  tmp[0].y = y - ty0 * scale;
+  tmp[1].code = ART_LINETO;
+  tmp[1].x = x;
+  tmp[1].y = y;
+  scale = len1 / sqrt (tx1 * tx1 + ty1 * ty1);
+  tmp[2].code = ART_LINETO;
+  tmp[2].x = x + tx1 * scale;
+  tmp[2].y = y + ty1 * scale;
+}
+
+/**
+ * art_svp_bpath_stroke_raw: Stroke a bezier path, raw version
+ * @bpath: #ArtBpath to stroke.
+ * @join: Join style.
+ * @cap: Cap style.
+ * @line_width: Width of stroke.
+ * @miter_limit: Miter limit.
+ * @flatness: Flatness.
+ *
+ * Exactly the same as art_svp_bpath_stroke(), except that the resulting
+ * stroke outline may self-intersect and have regions of winding number
+ * greater than 1.
+ *
+ * Return value: Resulting raw stroked outline in vpath format.
+ **/
+ArtVpath *
+art_svp_bpath_stroke_raw (const ArtBpath *bpath,
+			  ArtPathStrokeJoinType join,
+			  ArtPathStrokeCapType cap,
+			  double line_width,
+			  double miter_limit,
+			  double flatness)
+{
+  int begin_idx, end_idx;
+  int i, j;
+  ArtVpath *forw, *rev;
+  int n_forw, n_rev;
+  int n_forw_max, n_rev_max;
+  ArtVpath *result;
+  int n_result, n_result_max;
+  double half_lw = 0.5 * line_width;
+  ArtVpath tmp[3];
+  double bx[4], by[4];
+  double x, y;
+  double tx0, ty0, tx1, ty1, len;
+  double first_tx = 0, first_ty = 0, first_len = 0;
+  double last_tx = 0, last_ty = 0, last_len = 0;
+  art_boolean started;
+  double scale;
+
+  n_forw_max = 16;
+  forw = art_new (ArtVpath, n_forw_max);
+
+  n_rev_max = 16;
+  rev = art_new (ArtVpath, n_rev_max);
+
+  n_result = 0;
+  n_result_max = 16;
+  result = art_new (ArtVpath, n_result_max);
+
+  for (begin_idx = 0; bpath[begin_idx].code != ART_END; begin_idx = end_idx)
+    {
+      n_forw = 0;
+      n_rev = 0;
+      started = ART_FALSE;
+      x = bpath[begin_idx].x3;
+      y = bpath[begin_idx].y3;
+
+      for (i = begin_idx + 1;
+	   bpath[i].code == ART_LINETO || bpath[i].code == ART_CURVETO;
+	   i++)
+	{
+	  bx[0] = x;
+	  by[0] = y;
+	  if (bpath[i].code == ART_CURVETO)
+	    {
+	      bx[1] = bpath[i].x1;
+	      by[1] = bpath[i].y1;
+	      bx[2] = bpath[i].x2;
+	      by[2] = bpath[i].y2;
+	    }
+	  else
+	    {
+	      bx[1] = bx[0];
+	      by[1] = by[0];
+	      bx[2] = bpath[i].x3;
+	      by[2] = bpath[i].y3;
+	    }
+	  bx[3] = bpath[i].x3;
+	  by[3] = bpath[i].y3;
+
+	  /* skip zero-length segments */
+	  if (!art_bez_tangents (bx, by, &tx0, &ty0, &tx1, &ty1))
+	    continue;
+	  if (bpath[i].code == ART_CURVETO)
+	    /* a curve is only known to follow its tangent for about
+	       @flatness, which keeps render_seg from cutting the inside
+	       of a join short where the curve bends away */
+	    len = flatness;
+	  else
+	    len = sqrt ((bx[3] - bx[0]) * (bx[3] - bx[0]) +
+			(by[3] - by[0]) * (by[3] - by[0]));
+
+	  if (!started)
+	    {
+	      started = ART_TRUE;
+	      first_tx = tx0;
+	      first_ty = ty0;
+	      first_len = len;
+	      scale = half_lw / sqrt (tx0 * tx0 + ty0 * ty0);
+	      art_vpath_add_point (&forw, &n_forw, &n_forw_max, ART_LINETO,
+				   x - ty0 * scale, y + tx0 * scale);
+	      art_vpath_add_point (&rev, &n_rev, &n_rev_max, ART_LINETO,
+				   x + ty0 * scale, y - tx0 * scale);
+	    }
+	  else
+	    {
+	      art_bez_stroke_vertex (tmp, x, y,
+				     last_tx, last_ty, last_len,
+				     tx0, ty0, len);
+	      render_seg (&forw, &n_forw, &n_forw_max,
+			  &rev, &n_rev, &n_rev_max,
+			  tmp, 0, 1, 2,
+			  join, half_lw, miter_limit, flatness);
+	    }
+
+	  if (bpath[i].code == ART_CURVETO)
+	    render_bez_seg (&forw, &n_forw, &n_forw_max,
+			    &rev, &n_rev, &n_rev_max,
+			    bx, by, half_lw, miter_limit, flatness, 0);
+
+	  last_tx = tx1;
+	  last_ty = ty1;
+	  last_len = len;
+	  x = bx[3];
+	  y = by[3];
+	}
+      end_idx = i;
+
+      if (!started)
+	continue;
+
+      if (bpath[begin_idx].code == ART_MOVETO &&
+	  x == bpath[begin_idx].x3 && y == bpath[begin_idx].y3)
+	{
+	  /* path is closed, render join to beginning */
+	  art_bez_stroke_vertex (tmp, x, y,
+				 last_tx, last_ty, last_len,
+				 first_tx, first_ty, first_len);
+	  render_seg (&forw, &n_forw, &n_forw_max,
+		      &rev, &n_rev, &n_rev_max,
+		      tmp, 0, 1, 2,
+		      join, half_lw, miter_limit, flatness);
+
+	  /* do forward path */
+	  art_vpath_add_point (&result, &n_result, &n_result_max,
+			       ART_MOVETO, forw[n_forw - 1].x,
+			       forw[n_forw - 1].y);
+	  for (j = 0; j < n_forw; j++)
+	    art_vpath_add_point (&result, &n_result, &n_result_max,
+				 ART_LINETO, forw[j].x,
+				 forw[j].y);
+
+	  /* do reverse path, reversed */
+	  art_vpath_add_point (&result, &n_result, &n_result_max,
+			       ART_MOVETO, rev[0].x,
+			       rev[0].y);
+	  for (j = n_rev - 1; j >= 0; j--)
+	    art_vpath_add_point (&result, &n_result, &n_result_max,
+				 ART_LINETO, rev[j].x,
+				 rev[j].y);
+	}
+      else
+	{
+	  /* path is open */
+	  art_bez_stroke_vertex (tmp, x, y,
+				 last_tx, last_ty, last_len,
+				 last_tx, last_ty, last_len);
+	  render_cap (&forw, &n_forw, &n_forw_max,
+		      tmp, 0, 1,
+		      cap, half_lw, flatness);
+	  art_vpath_add_point (&result, &n_result, &n_result_max,
+			       ART_MOVETO, forw[0].x,
+			       forw[0].y);
+	  for (j = 1; j < n_forw; j++)
+	    art_vpath_add_point (&result, &n_result, &n_result_max,
+				 ART_LINETO, forw[j].x,
+				 forw[j].y);
+	  for (j = n_rev - 1; j >= 0; j--)
+	    art_vpath_add_point (&result, &n_result, &n_result_max,
+				 ART_LINETO, rev[j].x,
+				 rev[j].y);
+	  art_bez_stroke_vertex (tmp, bpath[begin_idx].x3, bpath[begin_idx].y3,
+				 -first_tx, -first_ty, first_len,
+				 -first_tx, -first_ty, first_len);
+	  render_cap (&result, &n_result, &n_result_max,
+		      tmp, 0, 1,
+		      cap, half_lw, flatness);
+	  art_vpath_add_point (&result, &n_result, &n_result_max,
+			       ART_LINETO, forw[0].x,
+			       forw[0].y);
+	}
+    }
+
+  art_free (forw);
+  art_free (rev);
+  art_vpath_add_point (&result, &n_result, &n_result_max, ART_END, 0, 0);
+  art_vpath_remove_dups (result);
+  return result;
+}
+
 #define noVERBOSE
 
 #ifdef VERBOSE
@@ -615,6 +1219,64 @@ print_ps_svp (ArtSVP *vpath)
 }
 #endif
 
+/* Turn a raw stroke outline into a clean svp, freeing the outline. */
+static ArtSVP *
+art_svp_stroke_finish (ArtVpath *vpath_stroke)
+{
+#ifdef ART_USE_NEW_INTERSECTOR
+  ArtSVP *svp, *svp2;
+  ArtSvpWriter *swr;
+
+#ifdef VERBOSE
+  print_ps_vpath (vpath_stroke);
+#endif
+  svp = art_svp_from_vpath (vpath_stroke);
+#ifdef VERBOSE
+  print_ps_svp (svp);
+#endif
+  art_free (vpath_stroke);
+
+  swr = art_svp_writer_rewind_new (ART_WIND_RULE_NONZERO);
+  art_svp_intersector (svp, swr);
+
+  svp2 = art_svp_writer_rewind_reap (swr);
+#ifdef VERBOSE
+  print_ps_svp (svp2);
+#endif
+  art_svp_free (svp);
+  return svp2;
+#else
+  ArtVpath *vpath2;
+  ArtSVP *svp, *svp2, *svp3;
+
+#ifdef VERBOSE
+  print_ps_vpath (vpath_stroke);
+#endif
+  vpath2 = art_vpath_perturb (vpath_stroke);
+#ifdef VERBOSE
+  print_ps_vpath (vpath2);
+#endif
+  art_free (vpath_stroke);
+  svp = art_svp_from_vpath (vpath2);
+#ifdef VERBOSE
+  print_ps_svp (svp);
+#endif
+  art_free (vpath2);
+  svp2 = art_svp_uncross (svp);
+#ifdef VERBOSE
+  print_ps_svp (svp2);
+#endif
+  art_svp_free (svp);
+  svp3 = art_svp_rewind_uncrossed (svp2, ART_WIND_RULE_NONZERO);
+#ifdef VERBOSE
+  print_ps_svp (svp3);
+#endif
+  art_svp_free (svp2);
+
+  return svp3;
+#endif
+}
+
 /* Render a vector path into a stroked outline.
 
    Status of this routine:
@@ -679,61 +1341,231 @@ art_svp_vpath_stroke (ArtVpath *vpath,
 		      double miter_limit,
 		      double flatness)
 {
-#ifdef ART_USE_NEW_INTERSECTOR
   ArtVpath *vpath_stroke;
-  ArtSVP *svp, *svp2;
-  ArtSvpWriter *swr;
 
   vpath_stroke = art_svp_vpath_stroke_raw (vpath, join, cap,
 					   line_width, miter_limit, flatness);
-#ifdef VERBOSE
-  print_ps_vpath (vpath_stroke);
+  return art_svp_stroke_finish (vpath_stroke);
+}
+
+/**
+ * art_svp_vpath_stroke_range: Stroke some subpaths of a vector path, raw.
+ * @vpath: #ArtVPath to stroke.
+ * @begin_idx: Index of the moveto starting the first subpath to stroke.
+ * @end_idx: Subpaths starting at or after this index are not stroked.
+ * @join: Join style.
+ * @cap: Cap style.
+ * @line_width: Width of stroke.
+ * @miter_limit: Miter limit.
+ * @flatness: Flatness.
+ *
+ * Strokes the subpaths of @vpath that start in the index range
+ * [@begin_idx, @end_idx), the same way art_svp_vpath_stroke() would.
+ * A negative @end_idx strokes everything up to the end of @vpath. As
+ * with art_svp_vpath_stroke_raw(), the outline is not cleaned up, so
+ * the winding number may exceed 1.
+ *
+ * This function only reads @vpath and keeps no state between calls.
+ * A path with many subpaths can thus be split into ranges that are
+ * stroked independently, for example on separate threads, and then
+ * combined with art_svp_vpath_stroke_merge().
+ *
+ * Return value: Raw stroked outline of the subpaths in svp format.
+ **/
+ArtSVP *
+art_svp_vpath_stroke_range (ArtVpath *vpath, int begin_idx, int end_idx,
+			    ArtPathStrokeJoinType join,
+			    ArtPathStrokeCapType cap,
+			    double line_width,
+			    double miter_limit,
+			    double flatness)
+{
+  ArtVpath *vpath_stroke;
+  ArtSVP *svp;
+#ifndef ART_USE_NEW_INTERSECTOR
+  ArtVpath *vpath2;
 #endif
+
+  vpath_stroke = art_svp_vpath_stroke_raw_range (vpath, begin_idx, end_idx,
+						 join, cap, line_width,
+						 miter_limit, flatness);
+#ifdef ART_USE_NEW_INTERSECTOR
   svp = art_svp_from_vpath (vpath_stroke);
-#ifdef VERBOSE
-  print_ps_svp (svp);
+#else
+  vpath2 = art_vpath_perturb (vpath_stroke);
+  svp = art_svp_from_vpath (vpath2);
+  art_free (vpath2);
 #endif
   art_free (vpath_stroke);
+  return svp;
+}
+
+/**
+ * art_svp_vpath_stroke_merge: Combine raw strokes into a clean svp.
+ * @svps: Array of raw strokes, from art_svp_vpath_stroke_range().
+ * @n_svps: Number of elements in @svps.
+ *
+ * Computes the union of the strokes in @svps with a single pass of
+ * the intersector. The arguments are not freed.
+ *
+ * Return value: Resulting stroked outline in svp format.
+ **/
+ArtSVP *
+art_svp_vpath_stroke_merge (ArtSVP **svps, int n_svps)
+{
+  ArtSVP *svp, *svp_new;
+  int n_segs;
+  int i, j;
+#ifdef ART_USE_NEW_INTERSECTOR
+  ArtSvpWriter *swr;
+#else
+  ArtSVP *svp2;
+#endif
+
+  n_segs = 0;
+  for (i = 0; i < n_svps; i++)
+    n_segs += svps[i]->n_segs;
 
+  /* the merged svp shares segments with the arguments */
+  svp = (ArtSVP *)art_alloc (sizeof(ArtSVP) +
+			     (n_segs - 1) * sizeof(ArtSVPSeg));
+  n_segs = 0;
+  for (i = 0; i < n_svps; i++)
+    for (j = 0; j < svps[i]->n_segs; j++)
+      svp->segs[n_segs++] = svps[i]->segs[j];
+  svp->n_segs = n_segs;
+  qsort (svp->segs, n_segs, sizeof (ArtSVPSeg), art_svp_seg_compare);
+
+#ifdef ART_USE_NEW_INTERSECTOR
   swr = art_svp_writer_rewind_new (ART_WIND_RULE_NONZERO);
   art_svp_intersector (svp, swr);
-
-  svp2 = art_svp_writer_rewind_reap (swr);
-#ifdef VERBOSE
-  print_ps_svp (svp2);
-#endif
-  art_svp_free (svp);
-  return svp2;
+  svp_new = art_svp_writer_rewind_reap (swr);
 #else
-  ArtVpath *vpath_stroke, *vpath2;
-  ArtSVP *svp, *svp2, *svp3;
-
-  vpath_stroke = art_svp_vpath_stroke_raw (vpath, join, cap,
-					   line_width, miter_limit, flatness);
-#ifdef VERBOSE
-  print_ps_vpath (vpath_stroke);
-#endif
-  vpath2 = art_vpath_perturb (vpath_stroke);
-#ifdef VERBOSE
-  print_ps_vpath (vpath2);
-#endif
-  art_free (vpath_stroke);
-  svp = art_svp_from_vpath (vpath2);
-#ifdef VERBOSE
-  print_ps_svp (svp);
-#endif
-  art_free (vpath2);
   svp2 = art_svp_uncross (svp);
-#ifdef VERBOSE
-  print_ps_svp (svp2);
-#endif
-  art_svp_free (svp);
-  svp3 = art_svp_rewind_uncrossed (svp2, ART_WIND_RULE_NONZERO);
-#ifdef VERBOSE
-  print_ps_svp (svp3);
-#endif
+  svp_new = art_svp_rewind_uncrossed (svp2, ART_WIND_RULE_NONZERO);
   art_svp_free (svp2);
-
-  return svp3;
 #endif
+  art_free (svp); /* shallow free because svp contains shared segments */
+
+  return svp_new;
+}
+
+typedef struct _ArtSvpStrokeDashData ArtSvpStrokeDashData;
+
+struct _ArtSvpStrokeDashData {
+  ArtVpath *result;
+  int n_result, n_result_max;
+  ArtVpath *forw, *rev;
+  int n_forw_max, n_rev_max;
+  ArtPathStrokeJoinType join;
+  ArtPathStrokeCapType cap;
+  double line_width;
+  double miter_limit;
+  double flatness;
+};
+
+static void
+art_svp_stroke_dash_callback (void *callback_data, ArtVpath *piece)
+{
+  ArtSvpStrokeDashData *data = (ArtSvpStrokeDashData *)callback_data;
+
+  art_svp_vpath_stroke_raw_append (piece, 0, -1,
+				   &data->result, &data->n_result,
+				   &data->n_result_max,
+				   &data->forw, &data->n_forw_max,
+				   &data->rev, &data->n_rev_max,
+				   data->join, data->cap, data->line_width,
+				   data->miter_limit, data->flatness);
+}
+
+/**
+ * art_svp_vpath_stroke_dash: Dash and stroke a vector path.
+ * @vpath: #ArtVPath to stroke.
+ * @dash: Dash style.
+ * @lengths: Segment lengths from art_vpath_dash_lengths(), or NULL.
+ * @join: Join style.
+ * @cap: Cap style.
+ * @line_width: Width of stroke.
+ * @miter_limit: Miter limit.
+ * @flatness: Flatness.
+ *
+ * Gives the same result as stroking the output of art_vpath_dash()
+ * with art_svp_vpath_stroke(), but each dash is stroked as soon as it
+ * is generated, so the dashed path is never built.
+ *
+ * When the same path is drawn repeatedly with different dash offsets,
+ * as for animated selection outlines, passing @lengths from
+ * art_vpath_dash_lengths() avoids measuring the path each time.
+ *
+ * Return value: Resulting stroked outline in svp format.
+ **/
+ArtSVP *
+art_svp_vpath_stroke_dash (const ArtVpath *vpath, const ArtVpathDash *dash,
+			   const double *lengths,
+			   ArtPathStrokeJoinType join,
+			   ArtPathStrokeCapType cap,
+			   double line_width,
+			   double miter_limit,
+			   double flatness)
+{
+  ArtSvpStrokeDashData data;
+
+  data.n_result = 0;
+  data.n_result_max = 16;
+  data.result = art_new (ArtVpath, data.n_result_max);
+  data.n_forw_max = 16;
+  data.forw = art_new (ArtVpath, data.n_forw_max);
+  data.n_rev_max = 16;
+  data.rev = art_new (ArtVpath, data.n_rev_max);
+  data.join = join;
+  data.cap = cap;
+  data.line_width = line_width;
+  data.miter_limit = miter_limit;
+  data.flatness = flatness;
+
+  art_vpath_dash_iterate (vpath, dash, lengths,
+			  art_svp_stroke_dash_callback, &data);
+
+  art_free (data.forw);
+  art_free (data.rev);
+  art_vpath_add_point (&data.result, &data.n_result, &data.n_result_max,
+		       ART_END, 0, 0);
+  return art_svp_stroke_finish (data.result);
+}
+
+/**
+ * art_svp_bpath_stroke: Stroke a bezier path.
+ * @bpath: #ArtBpath to stroke.
+ * @join: Join style.
+ * @cap: Cap style.
+ * @line_width: Width of stroke.
+ * @miter_limit: Miter limit.
+ * @flatness: Flatness.
+ *
+ * Computes an svp representing the stroked outline of @bpath, with the
+ * same join, cap and width semantics as art_svp_vpath_stroke().
+ *
+ * Unlike flattening @bpath with art_bez_path_to_vec() and stroking the
+ * result, curves are offset directly and only the final outline is
+ * flattened to within @flatness, so there are no joins between the
+ * flattened pieces of a curve. For wide strokes this gives an svp
+ * with far fewer segments. Where a curve bends more tightly than half
+ * the line width, that piece is stroked as a polyline with round
+ * joins, so a cusp comes out round.
+ *
+ * Return value: Resulting stroked outline in svp format.
+ **/
+ArtSVP *
+art_svp_bpath_stroke (const ArtBpath *bpath,
+		      ArtPathStrokeJoinType join,
+		      ArtPathStrokeCapType cap,
+		      double line_width,
+		      double miter_limit,
+		      double flatness)
+{
+  ArtVpath *vpath_stroke;
+
+  vpath_stroke = art_svp_bpath_stroke_raw (bpath, join, cap,
+					   line_width, miter_limit, flatness);
+  return art_svp_stroke_finish (vpath_stroke);
 }
@@ -25,9 +25,13 @@
 #ifdef LIBART_COMPILATION
 #include "art_svp.h"
 #include "art_vpath.h"
+#include "art_bpath.h"
+#include "art_vpath_dash.h"
 #else
 #include <libart_lgpl/art_svp.h>
 #include <libart_lgpl/art_vpath.h>
+#include <libart_lgpl/art_bpath.h>
+#include <libart_lgpl/art_vpath_dash.h>
 #endif
 
 #ifdef __cplusplus
@@ -63,6 +67,45 @@ art_svp_vpath_stroke_raw (ArtVpath *vpath,
 			  double miter_limit,
 			  double flatness);
 
+/* Stroke subpaths independently and union them in one pass. */
+ArtSVP *
+art_svp_vpath_stroke_range (ArtVpath *vpath, int begin_idx, int end_idx,
+			    ArtPathStrokeJoinType join,
+			    ArtPathStrokeCapType cap,
+			    double line_width,
+			    double miter_limit,
+			    double flatness);
+
+ArtSVP *
+art_svp_vpath_stroke_merge (ArtSVP **svps, int n_svps);
+
+/* Dash and stroke in one go, without building the dashed path. */
+ArtSVP *
+art_svp_vpath_stroke_dash (const ArtVpath *vpath, const ArtVpathDash *dash,
+			   const double *lengths,
+			   ArtPathStrokeJoinType join,
+			   ArtPathStrokeCapType cap,
+			   double line_width,
+			   double miter_limit,
+			   double flatness);
+
+/* Stroke bezier paths without flattening the centerline first. */
+ArtSVP *
+art_svp_bpath_stroke (const ArtBpath *bpath,
+		      ArtPathStrokeJoinType join,
+		      ArtPathStrokeCapType cap,
+		      double line_width,
+		      double miter_limit,
+		      double flatness);
+
+ArtVpath *
+art_svp_bpath_stroke_raw (const ArtBpath *bpath,
+			  ArtPathStrokeJoinType join,
+			  ArtPathStrokeCapType cap,
+			  double line_width,
+			  double miter_limit,
+			  double flatness);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
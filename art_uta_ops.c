@@ -22,6 +22,7 @@
 
 #include <string.h>
 #include "art_misc.h"
+#include "art_rect.h"
 #include "art_uta.h"
 
 #ifndef MIN
@@ -32,6 +33,81 @@
 #define MAX(a,b) ((a) > (b) ? (a) : (b))
 #endif
 
+/* The four coordinates of an ArtUtaBbox are below 128, so the bytes of
+   two bboxes can be compared all at once: the high bit of each byte of
+   the difference of (bb1 | 0x80808080) and bb2 is set where the byte of
+   bb1 is not less than that of bb2. This gives the union and the
+   intersection of two bboxes without unpacking them. */
+static ArtUtaBbox
+art_uta_bbox_ge_mask (ArtUtaBbox bb1, ArtUtaBbox bb2)
+{
+  ArtUtaBbox ge;
+
+  ge = ((bb1 | 0x80808080) - bb2) & 0x80808080;
+  return (ge >> 7) * 0xff;
+}
+
+/* Union of two nonempty bboxes. */
+static ArtUtaBbox
+art_uta_bbox_union (ArtUtaBbox bb1, ArtUtaBbox bb2)
+{
+  ArtUtaBbox ge = art_uta_bbox_ge_mask (bb1, bb2);
+  ArtUtaBbox min = (bb2 & ge) | (bb1 & ~ge);
+  ArtUtaBbox max = (bb1 & ge) | (bb2 & ~ge);
+
+  return (min & 0xffff0000) | (max & 0x0000ffff);
+}
+
+/* Intersection of two bboxes, 0 if it is empty. */
+static ArtUtaBbox
+art_uta_bbox_intersect (ArtUtaBbox bb1, ArtUtaBbox bb2)
+{
+  ArtUtaBbox ge = art_uta_bbox_ge_mask (bb1, bb2);
+  ArtUtaBbox min = (bb2 & ge) | (bb1 & ~ge);
+  ArtUtaBbox max = (bb1 & ge) | (bb2 & ~ge);
+  ArtUtaBbox bb = (max & 0xffff0000) | (min & 0x0000ffff);
+
+  if (ART_UTA_BBOX_X0 (bb) >= ART_UTA_BBOX_X1 (bb) ||
+      ART_UTA_BBOX_Y0 (bb) >= ART_UTA_BBOX_Y1 (bb))
+    return 0;
+  return bb;
+}
+
+/* Return the utile of @uta at (@x, @y), 0 outside @uta. */
+static ArtUtaBbox
+art_uta_get (const ArtUta *uta, int x, int y)
+{
+  if (x < uta->x0 || y < uta->y0 ||
+      x >= uta->x0 + uta->width || y >= uta->y0 + uta->height)
+    return 0;
+  return uta->utiles[(y - uta->y0) * uta->width + x - uta->x0];
+}
+
+/* Add the pixel rectangle (@x0, @y0) - (@x1, @y1), which must lie
+   within @uta, to @uta. */
+static void
+art_uta_add_rect (ArtUta *uta, int x0, int y0, int x1, int y1)
+{
+  int xt, yt;
+  int bx0, by0, bx1, by1;
+  ArtUtaBbox bb, *p;
+
+  for (yt = y0 >> ART_UTILE_SHIFT; yt <= (y1 - 1) >> ART_UTILE_SHIFT; yt++)
+    {
+      by0 = MAX (y0 - (yt << ART_UTILE_SHIFT), 0);
+      by1 = MIN (y1 - (yt << ART_UTILE_SHIFT), ART_UTILE_SIZE);
+      for (xt = x0 >> ART_UTILE_SHIFT; xt <= (x1 - 1) >> ART_UTILE_SHIFT;
+	   xt++)
+	{
+	  bx0 = MAX (x0 - (xt << ART_UTILE_SHIFT), 0);
+	  bx1 = MIN (x1 - (xt << ART_UTILE_SHIFT), ART_UTILE_SIZE);
+	  bb = ART_UTA_BBOX_CONS (bx0, by0, bx1, by1);
+	  p = &uta->utiles[(yt - uta->y0) * uta->width + xt - uta->x0];
+	  *p = *p ? art_uta_bbox_union (*p, bb) : bb;
+	}
+    }
+}
+
 /**
  * art_uta_union: Compute union of two uta's.
  * @uta1: One uta.
@@ -94,14 +170,7 @@ art_uta_union (ArtUta *uta1, ArtUta *uta2)
 	  else if (bb2 == 0)
 	    bb = bb1;
 	  else
-	    bb = ART_UTA_BBOX_CONS(MIN(ART_UTA_BBOX_X0(bb1),
-				       ART_UTA_BBOX_X0(bb2)),
-				   MIN(ART_UTA_BBOX_Y0(bb1),
-				       ART_UTA_BBOX_Y0(bb2)),
-				   MAX(ART_UTA_BBOX_X1(bb1),
-				       ART_UTA_BBOX_X1(bb2)),
-				   MAX(ART_UTA_BBOX_Y1(bb1),
-				       ART_UTA_BBOX_Y1(bb2)));
+	    bb = art_uta_bbox_union (bb1, bb2);
 	  uta->utiles[ix] = bb;
 	  ix++;
 	  ix1++;
@@ -110,3 +179,236 @@ art_uta_union (ArtUta *uta1, ArtUta *uta2)
     }
   return uta;
 }
+
+/**
+ * art_uta_intersect: Compute intersection of two uta's.
+ * @uta1: One uta.
+ * @uta2: The other uta.
+ *
+ * Computes the intersection of @uta1 and @uta2. Each microtile of the
+ * result covers the intersection of the corresponding microtiles of
+ * the arguments, so all pixels covered by both arguments are covered.
+ *
+ * Return value: The new intersection uta.
+ **/
+ArtUta *
+art_uta_intersect (ArtUta *uta1, ArtUta *uta2)
+{
+  ArtUta *uta;
+  int x0, y0, x1, y1;
+  int x, y;
+  int ix, ix1, ix2;
+  ArtUtaBbox bb1, bb2;
+
+  x0 = MAX(uta1->x0, uta2->x0);
+  y0 = MAX(uta1->y0, uta2->y0);
+  x1 = MIN(uta1->x0 + uta1->width, uta2->x0 + uta2->width);
+  y1 = MIN(uta1->y0 + uta1->height, uta2->y0 + uta2->height);
+  if (x1 < x0)
+    x1 = x0;
+  if (y1 < y0)
+    y1 = y0;
+  uta = art_uta_new (x0, y0, x1, y1);
+
+  ix = 0;
+  for (y = y0; y < y1; y++)
+    {
+      ix1 = (y - uta1->y0) * uta1->width + x0 - uta1->x0;
+      ix2 = (y - uta2->y0) * uta2->width + x0 - uta2->x0;
+      for (x = x0; x < x1; x++)
+	{
+	  bb1 = uta1->utiles[ix1++];
+	  bb2 = uta2->utiles[ix2++];
+	  if (bb1 != 0 && bb2 != 0)
+	    uta->utiles[ix] = art_uta_bbox_intersect (bb1, bb2);
+	  ix++;
+	}
+    }
+  return uta;
+}
+
+/**
+ * art_uta_subtract: Compute difference of two uta's.
+ * @uta1: The uta to subtract from.
+ * @uta2: The uta to subtract.
+ *
+ * Computes the part of @uta1 not covered by @uta2. Microtiles of
+ * @uta1 that are covered entirely by @uta2 are dropped, and those of
+ * which @uta2 covers a whole top, bottom, left or right band are
+ * shrunk. Since a bbox can't have a hole, other microtiles are kept
+ * as they are, so the result may cover more than the exact
+ * difference, but it covers every pixel of @uta1 that isn't in @uta2.
+ *
+ * Return value: The new difference uta, with the extent of @uta1.
+ **/
+ArtUta *
+art_uta_subtract (ArtUta *uta1, ArtUta *uta2)
+{
+  ArtUta *uta;
+  int x, y;
+  int ix;
+  ArtUtaBbox bb1, bb2;
+  int x0, y0, x1, y1;
+
+  uta = art_uta_new (uta1->x0, uta1->y0,
+		     uta1->x0 + uta1->width, uta1->y0 + uta1->height);
+
+  ix = 0;
+  for (y = uta1->y0; y < uta1->y0 + uta1->height; y++)
+    for (x = uta1->x0; x < uta1->x0 + uta1->width; x++)
+      {
+	bb1 = uta1->utiles[ix];
+	if (bb1 != 0)
+	  {
+	    bb2 = art_uta_get (uta2, x, y);
+	    if (bb2 != 0)
+	      {
+		x0 = ART_UTA_BBOX_X0 (bb1);
+		y0 = ART_UTA_BBOX_Y0 (bb1);
+		x1 = ART_UTA_BBOX_X1 (bb1);
+		y1 = ART_UTA_BBOX_Y1 (bb1);
+		if (ART_UTA_BBOX_X0 (bb2) <= x0 && ART_UTA_BBOX_X1 (bb2) >= x1)
+		  {
+		    /* bb2 spans bb1 horizontally */
+		    if (ART_UTA_BBOX_Y0 (bb2) <= y0)
+		      y0 = MAX (y0, ART_UTA_BBOX_Y1 (bb2));
+		    else if (ART_UTA_BBOX_Y1 (bb2) >= y1)
+		      y1 = MIN (y1, ART_UTA_BBOX_Y0 (bb2));
+		  }
+		else if (ART_UTA_BBOX_Y0 (bb2) <= y0 &&
+			 ART_UTA_BBOX_Y1 (bb2) >= y1)
+		  {
+		    /* bb2 spans bb1 vertically */
+		    if (ART_UTA_BBOX_X0 (bb2) <= x0)
+		      x0 = MAX (x0, ART_UTA_BBOX_X1 (bb2));
+		    else if (ART_UTA_BBOX_X1 (bb2) >= x1)
+		      x1 = MIN (x1, ART_UTA_BBOX_X0 (bb2));
+		  }
+		if (x0 < x1 && y0 < y1)
+		  bb1 = ART_UTA_BBOX_CONS (x0, y0, x1, y1);
+		else
+		  bb1 = 0;
+	      }
+	    uta->utiles[ix] = bb1;
+	  }
+	ix++;
+      }
+  return uta;
+}
+
+/**
+ * art_uta_offset: Translate a uta.
+ * @uta: The uta.
+ * @dx: Horizontal offset in pixels.
+ * @dy: Vertical offset in pixels.
+ *
+ * Computes @uta moved by (@dx, @dy) pixels, for example to find the
+ * damage of an object that moved. Offsets that are multiples of the
+ * microtile size just move the array; other offsets split each
+ * microtile's bbox over up to four microtiles of the result, where the
+ * pieces of neighboring bboxes are merged, so the result may cover
+ * somewhat more than the moved pixels.
+ *
+ * Return value: The new translated uta.
+ **/
+ArtUta *
+art_uta_offset (ArtUta *uta, int dx, int dy)
+{
+  ArtUta *result;
+  int x0, y0, x1, y1;
+  int x, y;
+  int ix;
+  int px, py;
+  ArtUtaBbox bb;
+
+  if (((dx | dy) & (ART_UTILE_SIZE - 1)) == 0)
+    {
+      x = uta->x0 + (dx >> ART_UTILE_SHIFT);
+      y = uta->y0 + (dy >> ART_UTILE_SHIFT);
+      result = art_uta_new (x, y, x + uta->width, y + uta->height);
+      memcpy (result->utiles, uta->utiles,
+	      uta->width * uta->height * sizeof(ArtUtaBbox));
+      return result;
+    }
+
+  /* the microtiles touched by the moved extent */
+  x0 = ((uta->x0 << ART_UTILE_SHIFT) + dx) >> ART_UTILE_SHIFT;
+  y0 = ((uta->y0 << ART_UTILE_SHIFT) + dy) >> ART_UTILE_SHIFT;
+  x1 = (((uta->x0 + uta->width) << ART_UTILE_SHIFT) + dx +
+	ART_UTILE_SIZE - 1) >> ART_UTILE_SHIFT;
+  y1 = (((uta->y0 + uta->height) << ART_UTILE_SHIFT) + dy +
+	ART_UTILE_SIZE - 1) >> ART_UTILE_SHIFT;
+  result = art_uta_new (x0, y0, x1, y1);
+
+  ix = 0;
+  for (y = uta->y0; y < uta->y0 + uta->height; y++)
+    for (x = uta->x0; x < uta->x0 + uta->width; x++)
+      {
+	bb = uta->utiles[ix++];
+	if (bb != 0)
+	  {
+	    px = (x << ART_UTILE_SHIFT) + dx;
+	    py = (y << ART_UTILE_SHIFT) + dy;
+	    art_uta_add_rect (result,
+			      px + ART_UTA_BBOX_X0 (bb),
+			      py + ART_UTA_BBOX_Y0 (bb),
+			      px + ART_UTA_BBOX_X1 (bb),
+			      py + ART_UTA_BBOX_Y1 (bb));
+	  }
+      }
+  return result;
+}
+
+/**
+ * art_uta_clip: Clip a uta to a rectangle.
+ * @uta: The uta.
+ * @clip: The clip rectangle, in pixels.
+ *
+ * Computes the part of @uta inside @clip, limiting the extent of the
+ * result to the microtiles @clip touches. Clipping updates to the
+ * visible window keeps the utas that are accumulated with
+ * art_uta_union() small.
+ *
+ * Return value: The new clipped uta.
+ **/
+ArtUta *
+art_uta_clip (ArtUta *uta, const ArtIRect *clip)
+{
+  ArtUta *result;
+  int x0, y0, x1, y1;
+  int x, y;
+  int ix, ix1;
+  ArtUtaBbox bb, clip_bb;
+
+  x0 = MAX (uta->x0, clip->x0 >> ART_UTILE_SHIFT);
+  y0 = MAX (uta->y0, clip->y0 >> ART_UTILE_SHIFT);
+  x1 = MIN (uta->x0 + uta->width,
+	    (clip->x1 + ART_UTILE_SIZE - 1) >> ART_UTILE_SHIFT);
+  y1 = MIN (uta->y0 + uta->height,
+	    (clip->y1 + ART_UTILE_SIZE - 1) >> ART_UTILE_SHIFT);
+  if (x1 < x0)
+    x1 = x0;
+  if (y1 < y0)
+    y1 = y0;
+  result = art_uta_new (x0, y0, x1, y1);
+
+  ix = 0;
+  for (y = y0; y < y1; y++)
+    {
+      ix1 = (y - uta->y0) * uta->width + x0 - uta->x0;
+      for (x = x0; x < x1; x++)
+	{
+	  bb = uta->utiles[ix1++];
+	  if (bb != 0)
+	    {
+	      clip_bb = ART_UTA_BBOX_CONS (MAX (clip->x0 - (x << ART_UTILE_SHIFT), 0),
+					   MAX (clip->y0 - (y << ART_UTILE_SHIFT), 0),
+					   MIN (clip->x1 - (x << ART_UTILE_SHIFT), ART_UTILE_SIZE),
+					   MIN (clip->y1 - (y << ART_UTILE_SHIFT), ART_UTILE_SIZE));
+	      result->utiles[ix] = art_uta_bbox_intersect (bb, clip_bb);
+	    }
+	  ix++;
+	}
+    }
+  return result;
+}
@@ -23,8 +23,10 @@
 /* Basic operations on microtile arrays */
 
 #ifdef LIBART_COMPILATION
+#include "art_rect.h"
 #include "art_uta.h"
 #else
+#include <libart_lgpl/art_rect.h>
 #include <libart_lgpl/art_uta.h>
 #endif
 
@@ -35,6 +37,18 @@ extern "C" {
 ArtUta *
 art_uta_union (ArtUta *uta1, ArtUta *uta2);
 
+ArtUta *
+art_uta_intersect (ArtUta *uta1, ArtUta *uta2);
+
+ArtUta *
+art_uta_subtract (ArtUta *uta1, ArtUta *uta2);
+
+ArtUta *
+art_uta_offset (ArtUta *uta, int dx, int dy);
+
+ArtUta *
+art_uta_clip (ArtUta *uta, const ArtIRect *clip);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
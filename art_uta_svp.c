@@ -23,11 +23,20 @@
 #include "art_uta_svp.h"
 
 #include "art_misc.h"
-#include "art_vpath.h"
 #include "art_uta.h"
 #include "art_uta_vpath.h"
 #include "art_svp.h"
-#include "art_vpath_svp.h"
+#include "art_rect.h"
+#include "art_rect_svp.h"
+#include "art_svp_render_aa.h"
+
+#ifndef MAX
+#define MAX(a, b)  (((a) > (b)) ? (a) : (b))
+#endif /* MAX */
+
+#ifndef MIN
+#define MIN(a, b)  (((a) < (b)) ? (a) : (b))
+#endif /* MIN */
 
 /**
  * art_uta_from_svp: Generate uta covering an svp.
@@ -36,19 +45,145 @@
  * Generates a uta covering @svp. The resulting uta is of course
  * approximate, ie it may cover more pixels than covered by @svp.
  *
- * Note: I will want to replace this with a more direct
- * implementation. But this gets the api in place.
+ * The edges of @svp are added directly, without converting it back
+ * into a vpath first.
  *
  * Return value: the new uta.
  **/
 ArtUta *
 art_uta_from_svp (const ArtSVP *svp)
 {
-  ArtVpath *vpath;
+  ArtDRect drect;
+  ArtIRect bbox;
   ArtUta *uta;
+  int *rbuf;
+  int i, j;
+
+  art_drect_svp (&drect, svp);
+  art_drect_to_irect (&bbox, &drect);
+
+  uta = art_uta_new_coords (bbox.x0, bbox.y0, bbox.x1, bbox.y1);
+
+  rbuf = art_new (int, uta->width * uta->height);
+  for (i = 0; i < uta->width * uta->height; i++)
+    rbuf[i] = 0;
+
+  for (i = 0; i < svp->n_segs; i++)
+    {
+      const ArtSVPSeg *seg = &svp->segs[i];
+
+      /* keep the direction of the original path, so the winding
+	 numbers in rbuf come out right */
+      for (j = 0; j < seg->n_points - 1; j++)
+	if (seg->dir)
+	  art_uta_add_line (uta,
+			    seg->points[j + 1].x, seg->points[j + 1].y,
+			    seg->points[j].x, seg->points[j].y,
+			    rbuf, uta->width);
+	else
+	  art_uta_add_line (uta,
+			    seg->points[j].x, seg->points[j].y,
+			    seg->points[j + 1].x, seg->points[j + 1].y,
+			    rbuf, uta->width);
+    }
+
+  art_uta_add_interior (uta, rbuf);
+
+  art_free (rbuf);
 
-  vpath = art_vpath_from_svp (svp);
-  uta = art_uta_from_vpath (vpath);
-  art_free (vpath);
   return uta;
 }
+
+typedef struct _ArtUtaSVPAAData ArtUtaSVPAAData;
+
+struct _ArtUtaSVPAAData {
+  ArtUta *uta;
+  int x0, x1;
+};
+
+/* Add the pixels [@x0, @x1) of row @y to @uta. */
+static void
+art_uta_add_run (ArtUta *uta, int y, int x0, int x1)
+{
+  int xt, yt, xt0, xt1;
+  int bx0, bx1, by;
+  ArtUtaBbox bb;
+  int ix;
+
+  yt = (y >> ART_UTILE_SHIFT) - uta->y0;
+  by = y & (ART_UTILE_SIZE - 1);
+  xt0 = x0 >> ART_UTILE_SHIFT;
+  xt1 = (x1 - 1) >> ART_UTILE_SHIFT;
+  for (xt = xt0; xt <= xt1; xt++)
+    {
+      bx0 = xt == xt0 ? x0 & (ART_UTILE_SIZE - 1) : 0;
+      bx1 = xt == xt1 ? ((x1 - 1) & (ART_UTILE_SIZE - 1)) + 1 : ART_UTILE_SIZE;
+      ix = yt * uta->width + xt - uta->x0;
+      bb = uta->utiles[ix];
+      if (bb == 0)
+	bb = ART_UTA_BBOX_CONS (bx0, by, bx1, by + 1);
+      else
+	bb = ART_UTA_BBOX_CONS (MIN (ART_UTA_BBOX_X0 (bb), bx0),
+				MIN (ART_UTA_BBOX_Y0 (bb), by),
+				MAX (ART_UTA_BBOX_X1 (bb), bx1),
+				MAX (ART_UTA_BBOX_Y1 (bb), by + 1));
+      uta->utiles[ix] = bb;
+    }
+}
+
+static void
+art_uta_svp_aa_callback (void *callback_data, int y,
+			 int start, ArtSVPRenderAAStep *steps, int n_steps)
+{
+  ArtUtaSVPAAData *data = (ArtUtaSVPAAData *)callback_data;
+  art_u32 running_sum = start;
+  int run_x0, run_x1;
+  int k;
+
+  /* a pixel is covered when the renderers would give it a nonzero
+     alpha */
+  run_x0 = data->x0;
+  for (k = 0; k <= n_steps; k++)
+    {
+      run_x1 = k < n_steps ? steps[k].x : data->x1;
+      if (run_x1 > run_x0 && ((running_sum >> 16) & 0xff))
+	art_uta_add_run (data->uta, y, run_x0, run_x1);
+      if (k < n_steps)
+	{
+	  running_sum += steps[k].delta;
+	  run_x0 = run_x1;
+	}
+    }
+}
+
+/**
+ * art_uta_from_svp_aa: Generate exact uta of the pixels an svp renders to.
+ * @svp: The source svp.
+ *
+ * Generates a uta covering exactly the pixels to which the antialiased
+ * renderers, such as art_rgb_svp_alpha(), give a nonzero alpha when
+ * rendering @svp. This costs a pass of the antialiased rasterizer, but
+ * the result is tighter than art_uta_from_svp(), which covers whole
+ * microtiles in the interior and everything the edges touch.
+ *
+ * Return value: the new uta.
+ **/
+ArtUta *
+art_uta_from_svp_aa (const ArtSVP *svp)
+{
+  ArtDRect drect;
+  ArtIRect bbox;
+  ArtUtaSVPAAData data;
+
+  art_drect_svp (&drect, svp);
+  art_drect_to_irect (&bbox, &drect);
+
+  data.uta = art_uta_new_coords (bbox.x0, bbox.y0, bbox.x1, bbox.y1);
+  data.x0 = bbox.x0;
+  data.x1 = bbox.x1;
+  if (bbox.x1 > bbox.x0 && bbox.y1 > bbox.y0)
+    art_svp_render_aa (svp, bbox.x0, bbox.y0, bbox.x1, bbox.y1,
+		       art_uta_svp_aa_callback, &data);
+
+  return data.uta;
+}
@@ -37,6 +37,9 @@ extern "C" {
 ArtUta *
 art_uta_from_svp (const ArtSVP *svp);
 
+ArtUta *
+art_uta_from_svp_aa (const ArtSVP *svp);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
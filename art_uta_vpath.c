@@ -277,6 +277,69 @@ art_uta_add_line (ArtUta *uta, double x0, double y0, double x1, double y1,
     }
 }
 
+/**
+ * art_uta_add_interior: Cover the interior of the lines added to the uta.
+ * @uta: The uta to modify.
+ * @rbuf: Buffer of winding number differences filled by art_uta_add_line().
+ *
+ * Covers every utile of @uta in which the winding number accumulated
+ * in @rbuf is nonzero, along with the edges it shares with its right
+ * and lower neighbors. @rbuf has the same dimensions as @uta.
+ **/
+void
+art_uta_add_interior (ArtUta *uta, const int *rbuf)
+{
+  int sum;
+  int xt, yt;
+  ArtUtaBbox *utiles;
+  ArtUtaBbox bb;
+  int width;
+  int height;
+  int ix;
+
+  width = uta->width;
+  height = uta->height;
+  utiles = uta->utiles;
+
+  ix = 0;
+  for (yt = 0; yt < height; yt++)
+    {
+      sum = 0;
+      for (xt = 0; xt < width; xt++)
+	{
+	  sum += rbuf[ix];
+	  /* Nonzero winding rule - others are possible, but hardly
+	     worth it. */
+	  if (sum != 0)
+	    {
+	      bb = utiles[ix];
+	      bb &= 0xffff0000;
+	      bb |= (ART_UTILE_SIZE << 8) | ART_UTILE_SIZE;
+	      utiles[ix] = bb;
+	      if (xt != width - 1)
+		{
+		  bb = utiles[ix + 1];
+		  bb &= 0xffff00;
+		  bb |= ART_UTILE_SIZE;
+		  utiles[ix + 1] = bb;
+		}
+	      if (yt != height - 1)
+		{
+		  bb = utiles[ix + width];
+		  bb &= 0xff0000ff;
+		  bb |= ART_UTILE_SIZE << 8;
+		  utiles[ix + width] = bb;
+		  if (xt != width - 1)
+		    {
+		      utiles[ix + width + 1] &= 0xffff;
+		    }
+		}
+	    }
+	  ix++;
+	}
+    }
+}
+
 /**
  * art_uta_from_vpath: Generate uta covering a vpath.
  * @vec: The source vpath.
@@ -294,13 +357,8 @@ art_uta_from_vpath (const ArtVpath *vec)
   int *rbuf;
   int i;
   double x, y;
-  int sum;
-  int xt, yt;
-  ArtUtaBbox *utiles;
-  ArtUtaBbox bb;
   int width;
   int height;
-  int ix;
 
   art_vpath_bbox_irect (vec, &bbox);
 
@@ -308,7 +366,6 @@ art_uta_from_vpath (const ArtVpath *vec)
 
   width = uta->width;
   height = uta->height;
-  utiles = uta->utiles;
 
   rbuf = art_new (int, width * height);
   for (i = 0; i < width * height; i++)
@@ -337,44 +394,7 @@ art_uta_from_vpath (const ArtVpath *vec)
 	}
     }
 
-  /* now add in the filling from rbuf */
-  ix = 0;
-  for (yt = 0; yt < height; yt++)
-    {
-      sum = 0;
-      for (xt = 0; xt < width; xt++)
-	{
-	  sum += rbuf[ix];
-	  /* Nonzero winding rule - others are possible, but hardly
-	     worth it. */
-	  if (sum != 0)
-	    {
-	      bb = utiles[ix];
-	      bb &= 0xffff0000;
-	      bb |= (ART_UTILE_SIZE << 8) | ART_UTILE_SIZE;
-	      utiles[ix] = bb;
-	      if (xt != width - 1)
-		{
-		  bb = utiles[ix + 1];
-		  bb &= 0xffff00;
-		  bb |= ART_UTILE_SIZE;
-		  utiles[ix + 1] = bb;
-		}
-	      if (yt != height - 1)
-		{
-		  bb = utiles[ix + width];
-		  bb &= 0xff0000ff;
-		  bb |= ART_UTILE_SIZE << 8;
-		  utiles[ix + width] = bb;
-		  if (xt != width - 1)
-		    {
-		      utiles[ix + width + 1] &= 0xffff;
-		    }
-		}
-	    }
-	  ix++;
-	}
-    }
+  art_uta_add_interior (uta, rbuf);
 
   art_free (rbuf);
 
@@ -37,11 +37,14 @@ extern "C" {
 ArtUta *
 art_uta_from_vpath (const ArtVpath *vec);
 
-/* This is a private function: */
+/* These are private functions: */
 void
 art_uta_add_line (ArtUta *uta, double x0, double y0, double x1, double y1,
 		  int *rbuf, int rbuf_rowstride);
 
+void
+art_uta_add_interior (ArtUta *uta, const int *rbuf);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
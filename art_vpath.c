@@ -110,27 +110,48 @@ art_vpath_new_circle (double x, double y, double r)
 ArtVpath *
 art_vpath_affine_transform (const ArtVpath *src, const double matrix[6])
 {
-  int i;
   int size;
   ArtVpath *new;
-  double x, y;
 
-  for (i = 0; src[i].code != ART_END; i++);
-  size = i;
+  for (size = 0; src[size].code != ART_END; size++);
 
   new = art_new (ArtVpath, size + 1);
+  art_vpath_affine_transform_buf (new, src, matrix);
 
-  for (i = 0; i < size; i++)
+  return new;
+}
+
+/**
+ * art_vpath_affine_transform_buf: Affine transform a vpath into a buffer.
+ * @dst: Where to store the result.
+ * @src: Source vpath to transform.
+ * @matrix: Affine transform.
+ *
+ * Like art_vpath_affine_transform(), but stores the result in @dst,
+ * which must have room for as many elements as @src, including the
+ * final %ART_END. @dst may be @src, to transform a vpath in place.
+ * Paths that are transformed every frame can then reuse their buffers
+ * instead of allocating a new path each time.
+ **/
+void
+art_vpath_affine_transform_buf (ArtVpath *dst, const ArtVpath *src,
+				const double matrix[6])
+{
+  /* locals, so the compiler knows stores to @dst don't change them */
+  double a = matrix[0], b = matrix[1], c = matrix[2];
+  double d = matrix[3], e = matrix[4], f = matrix[5];
+  double x, y;
+  int i;
+
+  for (i = 0; src[i].code != ART_END; i++)
     {
-      new[i].code = src[i].code;
       x = src[i].x;
       y = src[i].y;
-      new[i].x = matrix[0] * x + matrix[2] * y + matrix[4];
-      new[i].y = matrix[1] * x + matrix[3] * y + matrix[5];
+      dst[i].code = src[i].code;
+      dst[i].x = a * x + c * y + e;
+      dst[i].y = b * x + d * y + f;
     }
-  new[i].code = ART_END;
-
-  return new;
+  dst[i].code = ART_END;
 }
 
 /**
@@ -239,3 +260,67 @@ art_vpath_perturb (ArtVpath *src)
 
   return new;
 }
+
+/**
+ * art_vpath_to_float: Convert a vpath to single precision.
+ * @src: Source vpath.
+ *
+ * Rounds the coordinates of @src to floats. This halves the memory
+ * of the path, and at device coordinates up to about 100000 the
+ * rounding error stays below 1/100 of a pixel.
+ *
+ * Return value: Newly allocated #ArtVpathF.
+ **/
+ArtVpathF *
+art_vpath_to_float (const ArtVpath *src)
+{
+  int i;
+  int size;
+  ArtVpathF *new;
+
+  for (size = 0; src[size].code != ART_END; size++);
+
+  new = art_new (ArtVpathF, size + 1);
+  for (i = 0; i < size; i++)
+    {
+      new[i].code = src[i].code;
+      new[i].x = src[i].x;
+      new[i].y = src[i].y;
+    }
+  new[i].code = ART_END;
+  new[i].x = 0;
+  new[i].y = 0;
+
+  return new;
+}
+
+/**
+ * art_vpath_from_float: Convert a single precision vpath to a vpath.
+ * @src: Source #ArtVpathF.
+ *
+ * Converts @src back to double precision, exactly.
+ *
+ * Return value: Newly allocated vpath.
+ **/
+ArtVpath *
+art_vpath_from_float (const ArtVpathF *src)
+{
+  int i;
+  int size;
+  ArtVpath *new;
+
+  for (size = 0; src[size].code != ART_END; size++);
+
+  new = art_new (ArtVpath, size + 1);
+  for (i = 0; i < size; i++)
+    {
+      new[i].code = src[i].code;
+      new[i].x = src[i].x;
+      new[i].y = src[i].y;
+    }
+  new[i].code = ART_END;
+  new[i].x = 0;
+  new[i].y = 0;
+
+  return new;
+}
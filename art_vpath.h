@@ -43,6 +43,16 @@ struct _ArtVpath {
   double y;
 };
 
+/* The same in single precision, which is plenty for device
+   coordinates and halves the memory of large paths. */
+typedef struct _ArtVpathF ArtVpathF;
+
+struct _ArtVpathF {
+  ArtPathcode code;
+  float x;
+  float y;
+};
+
 /* Some of the functions need to go into their own modules */
 
 void
@@ -55,6 +65,10 @@ art_vpath_new_circle (double x, double y, double r);
 ArtVpath *
 art_vpath_affine_transform (const ArtVpath *src, const double matrix[6]);
 
+void
+art_vpath_affine_transform_buf (ArtVpath *dst, const ArtVpath *src,
+				const double matrix[6]);
+
 void
 art_vpath_bbox_drect (const ArtVpath *vec, ArtDRect *drect);
 
@@ -64,6 +78,12 @@ art_vpath_bbox_irect (const ArtVpath *vec, ArtIRect *irect);
 ArtVpath *
 art_vpath_perturb (ArtVpath *src);
 
+ArtVpathF *
+art_vpath_to_float (const ArtVpath *src);
+
+ArtVpath *
+art_vpath_from_float (const ArtVpathF *src);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -22,6 +22,7 @@
 #include "config.h"
 #include "art_vpath_bpath.h"
 
+#include <limits.h>
 #include <math.h>
 
 #include "art_misc.h"
@@ -84,8 +85,445 @@ art_bezier_to_vec (double x0, double y0,
   return p;
 }
 
-#define RENDER_LEVEL 4
-#define RENDER_SIZE (1 << (RENDER_LEVEL))
+/* Whether the cubic is within @flatness of its chord. The curve lies
+   in the convex hull of its control points. When the inner control
+   points project onto the chord, so does the curve, and its distance
+   to the chord is at most 3/4 of theirs. */
+static art_boolean
+art_bez_is_flat (double x0, double y0, double x1, double y1,
+		 double x2, double y2, double x3, double y3,
+		 double flatness)
+{
+  double x3_0, y3_0;
+  double z3_0_dot;
+  double z1_dot, z2_dot;
+  double z1_perp, z2_perp;
+  double max_perp_sq;
+
+  x3_0 = x3 - x0;
+  y3_0 = y3 - y0;
+
+  /* z3_0_dot is dist z0-z3 squared */
+  z3_0_dot = x3_0 * x3_0 + y3_0 * y3_0;
+
+  if (z3_0_dot < 0.001)
+    /* if start and end point are almost identical, the chord has no
+       direction, so test the distance to the start point instead */
+    return (hypot (x1 - x0, y1 - y0) <= flatness &&
+	    hypot (x2 - x0, y2 - y0) <= flatness);
+
+  /* perp is distance from line, multiplied by dist z0-z3 */
+  max_perp_sq = (16.0 / 9) * flatness * flatness * z3_0_dot;
+
+  z1_perp = (y1 - y0) * x3_0 - (x1 - x0) * y3_0;
+  if (z1_perp * z1_perp > max_perp_sq)
+    return ART_FALSE;
+
+  z2_perp = (y3 - y2) * x3_0 - (x3 - x2) * y3_0;
+  if (z2_perp * z2_perp > max_perp_sq)
+    return ART_FALSE;
+
+  z1_dot = (x1 - x0) * x3_0 + (y1 - y0) * y3_0;
+  if (z1_dot < 0 || z1_dot > z3_0_dot)
+    return ART_FALSE;
+
+  z2_dot = (x3 - x2) * x3_0 + (y3 - y2) * y3_0;
+  if (z2_dot < 0 || z2_dot > z3_0_dot)
+    return ART_FALSE;
+
+  return ART_TRUE;
+}
+
+/* Flatten the cubic by halving it until art_bez_is_flat() passes.
+   Writes at most @n_out of the points to @out, not including the
+   start point, and returns their number. @level bounds the recursion
+   for degenerate input. */
+static int
+art_bez_subdivide (double x0, double y0, double x1, double y1,
+		   double x2, double y2, double x3, double y3,
+		   double flatness, ArtVpath *out, int n_out, int level)
+{
+  double xa1, ya1;
+  double xa2, ya2;
+  double xb1, yb1;
+  double xb2, yb2;
+  double x_m, y_m;
+  int n;
+
+  if (level == 0 ||
+      art_bez_is_flat (x0, y0, x1, y1, x2, y2, x3, y3, flatness))
+    {
+      if (n_out > 0)
+	{
+	  out[0].code = ART_LINETO;
+	  out[0].x = x3;
+	  out[0].y = y3;
+	}
+      return 1;
+    }
+
+  xa1 = (x0 + x1) * 0.5;
+  ya1 = (y0 + y1) * 0.5;
+  xa2 = (x0 + 2 * x1 + x2) * 0.25;
+  ya2 = (y0 + 2 * y1 + y2) * 0.25;
+  xb1 = (x1 + 2 * x2 + x3) * 0.25;
+  yb1 = (y1 + 2 * y2 + y3) * 0.25;
+  xb2 = (x2 + x3) * 0.5;
+  yb2 = (y2 + y3) * 0.5;
+  x_m = (xa2 + xb1) * 0.5;
+  y_m = (ya2 + yb1) * 0.5;
+  n = art_bez_subdivide (x0, y0, xa1, ya1, xa2, ya2, x_m, y_m,
+			 flatness, out, n_out, level - 1);
+  n += art_bez_subdivide (x_m, y_m, xb1, yb1, xb2, yb2, x3, y3,
+			  flatness, n < n_out ? out + n : NULL, n_out - n,
+			  level - 1);
+  return n;
+}
+
+#define BEZ_SUBDIVIDE_LEVELS 16
+
+/* Estimate the number of points art_bez_subdivide() produces for the
+   cubic, from Wang's formula for the number of uniform segments that
+   keep it within @flatness. Halving only where needed mostly gives
+   fewer, so this is a good size to allocate for. */
+static int
+art_bez_subdivide_estimate (double x0, double y0, double x1, double y1,
+			    double x2, double y2, double x3, double y3,
+			    double flatness)
+{
+  double ax = x0 - 2 * x1 + x2;
+  double ay = y0 - 2 * y1 + y2;
+  double bx = x1 - 2 * x2 + x3;
+  double by = y1 - 2 * y2 + y3;
+  double m2;
+
+  m2 = ax * ax + ay * ay;
+  if (bx * bx + by * by > m2)
+    m2 = bx * bx + by * by;
+  /* n = sqrt (3 * 2 / 8 * m / flatness) */
+  return 1 + (int)sqrt (0.75 * sqrt (m2) / flatness);
+}
+
+/* Flattening works in two steps, neither of them recursive. The cubic
+   is first split into quadratic beziers, as many as needed to stay
+   within a fraction of the flatness (the error of that approximation
+   goes down with the sixth power of their number). Each quadratic is
+   a piece of a parabola, for which the number of line segments
+   needed is given, to a close approximation, by a closed form
+   integral. The segments are then distributed along the curve by
+   inverting that integral, so they come out evenly spaced rather than
+   clustered where halving happens to stop.
+
+   The approximation breaks down for small loops and cusps, where it
+   can give far too few segments. So each resulting chord is checked
+   against the piece of the cubic it spans, and the pieces that fail
+   are halved until they pass, as art_vpath_render_bez() does.
+
+   See Raph Levien, "Flattening quadratic Beziers", 2019. */
+
+/* The quadratics only guide where the points go, which are then
+   placed on the cubic itself, so they needn't be very close to it. */
+#define BEZ_QUAD_TOL 0.3
+
+/* The segment count from the integral is an estimate, which comes out
+   a little low for some curves. Asking for half the flatness keeps
+   most chords within the test of art_bez_is_flat(), which is
+   conservative, so that few of them need halving. */
+#define BEZ_SEG_TOL 0.5
+
+typedef struct _ArtBezQuad ArtBezQuad;
+
+struct _ArtBezQuad {
+  double x0, y0, x1, y1, x2, y2;
+  double a0, a2;	/* parabola integral at the ends */
+  double u0, uscale;	/* inverse integral at a0, and 1 / its range */
+  double val;		/* segment count, in units of 2 * sqrt (tolerance) */
+  double t_extremum;	/* vertex to emit as an extra point, or -1 */
+};
+
+static double
+art_parabola_integral (double x)
+{
+  const double d = 0.67;
+
+  return x / (1 - d + sqrt (sqrt (d * d * d * d + 0.25 * x * x)));
+}
+
+static double
+art_parabola_inv_integral (double x)
+{
+  const double b = 0.39;
+
+  return x * (1 - b + sqrt (b * b + 0.25 * x * x));
+}
+
+/* Number of quadratics needed to approximate the cubic to within
+   @tol. */
+static int
+art_bez_n_quads (const double *bx, const double *by, double tol)
+{
+  double dx = bx[3] - 3 * bx[2] + 3 * bx[1] - bx[0];
+  double dy = by[3] - 3 * by[2] + 3 * by[1] - by[0];
+  double n;
+
+  n = ceil (pow ((dx * dx + dy * dy) / (432 * tol * tol), 1.0 / 6));
+  if (n < 1)
+    return 1;
+  if (n > 1024)
+    return 1024;
+  return (int)n;
+}
+
+/* Set up quadratic @i of @n approximating the cubic, along with its
+   flattening parameters. */
+static void
+art_bez_quad (ArtBezQuad *q, const double *bx, const double *by,
+	      int i, int n, double sqrt_tol)
+{
+  double t0 = (double)i / n;
+  double t1 = (double)(i + 1) / n;
+  double dt = (t1 - t0) * (1.0 / 3);
+  double mt, px[4], py[4];
+  double dx0, dy0, dx1, dy1;
+  double d01x, d01y, d12x, d12y, ddx, ddy;
+  double cross, dd2, x0, x2, scale;
+
+  /* the subsegment of the cubic on [t0, t1] */
+  mt = 1 - t0;
+  px[0] = mt * mt * mt * bx[0] + 3 * mt * t0 * (mt * bx[1] + t0 * bx[2]) +
+    t0 * t0 * t0 * bx[3];
+  py[0] = mt * mt * mt * by[0] + 3 * mt * t0 * (mt * by[1] + t0 * by[2]) +
+    t0 * t0 * t0 * by[3];
+  dx0 = 3 * (mt * mt * (bx[1] - bx[0]) + 2 * mt * t0 * (bx[2] - bx[1]) +
+	     t0 * t0 * (bx[3] - bx[2]));
+  dy0 = 3 * (mt * mt * (by[1] - by[0]) + 2 * mt * t0 * (by[2] - by[1]) +
+	     t0 * t0 * (by[3] - by[2]));
+  mt = 1 - t1;
+  px[3] = mt * mt * mt * bx[0] + 3 * mt * t1 * (mt * bx[1] + t1 * bx[2]) +
+    t1 * t1 * t1 * bx[3];
+  py[3] = mt * mt * mt * by[0] + 3 * mt * t1 * (mt * by[1] + t1 * by[2]) +
+    t1 * t1 * t1 * by[3];
+  dx1 = 3 * (mt * mt * (bx[1] - bx[0]) + 2 * mt * t1 * (bx[2] - bx[1]) +
+	     t1 * t1 * (bx[3] - bx[2]));
+  dy1 = 3 * (mt * mt * (by[1] - by[0]) + 2 * mt * t1 * (by[2] - by[1]) +
+	     t1 * t1 * (by[3] - by[2]));
+  if (i == 0)
+    {
+      px[0] = bx[0];
+      py[0] = by[0];
+    }
+  if (i == n - 1)
+    {
+      px[3] = bx[3];
+      py[3] = by[3];
+    }
+  px[1] = px[0] + dx0 * dt;
+  py[1] = py[0] + dy0 * dt;
+  px[2] = px[3] - dx1 * dt;
+  py[2] = py[3] - dy1 * dt;
+
+  q->x0 = px[0];
+  q->y0 = py[0];
+  q->x1 = (3 * (px[1] + px[2]) - px[0] - px[3]) * 0.25;
+  q->y1 = (3 * (py[1] + py[2]) - py[0] - py[3]) * 0.25;
+  q->x2 = px[3];
+  q->y2 = py[3];
+
+  d01x = q->x1 - q->x0;
+  d01y = q->y1 - q->y0;
+  d12x = q->x2 - q->x1;
+  d12y = q->y2 - q->y1;
+  ddx = d01x - d12x;
+  ddy = d01y - d12y;
+  cross = (q->x2 - q->x0) * ddy - (q->y2 - q->y0) * ddx;
+  dd2 = ddx * ddx + ddy * ddy;
+  q->t_extremum = -1;
+
+  if (cross == 0)
+    {
+      /* a straight line; it may still double back on itself */
+      q->val = 0;
+      q->a0 = q->a2 = q->u0 = 0;
+      q->uscale = 1;
+      if (dd2 > 0)
+	{
+	  double t = (d01x * ddx + d01y * ddy) / dd2;
+
+	  if (t > 0 && t < 1)
+	    q->t_extremum = t;
+	}
+      return;
+    }
+
+  x0 = (d01x * ddx + d01y * ddy) / cross;
+  x2 = (d12x * ddx + d12y * ddy) / cross;
+  scale = cross * cross / (dd2 * sqrt (dd2));
+  q->a0 = art_parabola_integral (x0);
+  q->a2 = art_parabola_integral (x2);
+  if ((x0 < 0) == (x2 < 0))
+    q->val = fabs (q->a2 - q->a0) * sqrt (scale);
+  else
+    {
+      /* the vertex of the parabola is inside the segment. If the
+	 curve turns by more than a right angle there, the point of
+	 highest curvature is emitted as well, so that sharp turns
+	 aren't cut off. */
+      double xmin = sqrt_tol / sqrt (scale);
+
+      q->val = sqrt_tol * fabs (q->a2 - q->a0) / art_parabola_integral (xmin);
+      if (x2 - x0 > 1 || x0 - x2 > 1)
+	q->t_extremum = x0 / (x0 - x2);
+    }
+  q->u0 = art_parabola_inv_integral (q->a0);
+  q->uscale = 1 / (art_parabola_inv_integral (q->a2) - q->u0);
+}
+
+typedef struct _ArtBezPoint ArtBezPoint;
+
+/* A point of the cubic, with its parameter and derivative. */
+struct _ArtBezPoint {
+  double t;
+  double x, y;
+  double dx, dy;
+};
+
+static void
+art_bez_eval (ArtBezPoint *p, const double *bx, const double *by, double t)
+{
+  double mt = 1 - t;
+
+  p->t = t;
+  p->x = mt * mt * mt * bx[0] + 3 * mt * t * (mt * bx[1] + t * bx[2]) +
+    t * t * t * bx[3];
+  p->y = mt * mt * mt * by[0] + 3 * mt * t * (mt * by[1] + t * by[2]) +
+    t * t * t * by[3];
+  p->dx = 3 * (mt * mt * (bx[1] - bx[0]) + 2 * mt * t * (bx[2] - bx[1]) +
+	       t * t * (bx[3] - bx[2]));
+  p->dy = 3 * (mt * mt * (by[1] - by[0]) + 2 * mt * t * (by[2] - by[1]) +
+	       t * t * (by[3] - by[2]));
+}
+
+/* Add the chord of the cubic from @a to parameter @t, and move @a
+   there. The chord is checked with art_bez_is_flat() on the piece of
+   the cubic it spans. The analytic count is an estimate, which comes
+   out too low for small loops and cusps; there the piece is halved
+   until it passes. Returns the number of points, of which at most
+   @n_out are written to @out. */
+static int
+art_bez_flatten_chord (ArtBezPoint *a, const double *bx, const double *by,
+		       double t, double flatness, ArtVpath *out, int n_out)
+{
+  ArtBezPoint b;
+  double h;
+  double x0, y0, x1, y1, x2, y2;
+
+  art_bez_eval (&b, bx, by, t);
+  h = (b.t - a->t) * (1.0 / 3);
+  x0 = a->x;
+  y0 = a->y;
+  x1 = x0 + a->dx * h;
+  y1 = y0 + a->dy * h;
+  x2 = b.x - b.dx * h;
+  y2 = b.y - b.dy * h;
+  *a = b;
+  return art_bez_subdivide (x0, y0, x1, y1, x2, y2, b.x, b.y,
+			    flatness, out, n_out, BEZ_SUBDIVIDE_LEVELS);
+}
+
+/* Work out the quadratics and segment count for the cubic, and return
+   the number of points art_bez_flatten_emit() produces for it when no
+   chord needs halving, which is a lower bound. */
+static int
+art_bez_flatten_count (const double *bx, const double *by, double flatness,
+		       int *pn_quads, double *p_sum, int *pn_segs)
+{
+  double sqrt_tol = sqrt (BEZ_SEG_TOL * flatness);
+  int n_quads;
+  double sum;
+  int n_segs, n_extra;
+  ArtBezQuad q;
+  int i;
+
+  n_quads = art_bez_n_quads (bx, by, BEZ_QUAD_TOL * flatness);
+  sum = 0;
+  n_extra = 0;
+  for (i = 0; i < n_quads; i++)
+    {
+      art_bez_quad (&q, bx, by, i, n_quads, sqrt_tol);
+      sum += q.val;
+      if (q.t_extremum >= 0)
+	n_extra++;
+    }
+  n_segs = (int)ceil (0.5 * sum / sqrt_tol);
+  if (n_segs < 1)
+    n_segs = 1;
+
+  *pn_quads = n_quads;
+  *p_sum = sum;
+  *pn_segs = n_segs;
+  return n_segs + n_extra;
+}
+
+/* Flatten the cubic, given the quadratics and segment count from
+   art_bez_flatten_count(). Writes at most @n_out of the points to
+   @out, not including the start point, and returns their number; if
+   that is more than @n_out, the caller needs to make room and call
+   again. */
+static int
+art_bez_flatten_emit (const double *bx, const double *by, double flatness,
+		      int n_quads, double sum, int n_segs,
+		      ArtVpath *out, int n_out)
+{
+  double sqrt_tol = sqrt (BEZ_SEG_TOL * flatness);
+  double step = sum / n_segs;
+  double val_sum = 0;
+  double target, u, t;
+  double t_extremum;
+  ArtBezQuad q;
+  ArtBezPoint a;
+  int i, j, n;
+
+  art_bez_eval (&a, bx, by, 0);
+  n = 0;
+  j = 1;
+  for (i = 0; i < n_quads; i++)
+    {
+      art_bez_quad (&q, bx, by, i, n_quads, sqrt_tol);
+      t_extremum = q.t_extremum;
+      target = j * step;
+      for (;;)
+	{
+	  if (j < n_segs && target < val_sum + q.val)
+	    {
+	      u = (target - val_sum) / q.val;
+	      u = art_parabola_inv_integral (q.a0 + (q.a2 - q.a0) * u);
+	      t = (u - q.u0) * q.uscale;
+	    }
+	  else
+	    t = 2;
+	  if (t_extremum >= 0 && t_extremum <= t)
+	    {
+	      t = t_extremum;
+	      t_extremum = -1;
+	    }
+	  else if (t > 1)
+	    break;
+	  else
+	    {
+	      j++;
+	      target = j * step;
+	    }
+	  /* the quadratic follows the cubic's parameter closely, so the
+	     point is placed on the cubic itself */
+	  n += art_bez_flatten_chord (&a, bx, by, (i + t) / n_quads, flatness,
+				      n < n_out ? out + n : NULL, n_out - n);
+	}
+      val_sum += q.val;
+    }
+  n += art_bez_flatten_chord (&a, bx, by, 1, flatness,
+			      n < n_out ? out + n : NULL, n_out - n);
+  return n;
+}
 
 /**
  * art_vpath_render_bez: Render a bezier segment into the vpath. 
@@ -106,7 +544,7 @@ art_bezier_to_vec (double x0, double y0,
  * updating *@p_vpath and *@pn_vpath_max as necessary. *@pn_vpath is
  * incremented by the number of vector points added.
  *
- * This step includes (@x0, @y0) but not (@x3, @y3).
+ * This step includes (@x3, @y3) but not (@x0, @y0).
  *
  * The @flatness argument guides the amount of subdivision. The Adobe
  * PostScript reference manual defines flatness as the maximum
@@ -115,7 +553,7 @@ art_bezier_to_vec (double x0, double y0,
  * definition here. A value of 0.25 should ensure high quality for aa
  * rendering.
 **/
-static void
+void
 art_vpath_render_bez (ArtVpath **p_vpath, int *pn, int *pn_max,
 		      double x0, double y0,
 		      double x1, double y1,
@@ -123,123 +561,344 @@ art_vpath_render_bez (ArtVpath **p_vpath, int *pn, int *pn_max,
 		      double x3, double y3,
 		      double flatness)
 {
-  double x3_0, y3_0;
-  double z3_0_dot;
-  double z1_dot, z2_dot;
-  double z1_perp, z2_perp;
-  double max_perp_sq;
-
-  double x_m, y_m;
-  double xa1, ya1;
-  double xa2, ya2;
-  double xb1, yb1;
-  double xb2, yb2;
-
-  /* It's possible to optimize this routine a fair amount.
-
-     First, once the _dot conditions are met, they will also be met in
-     all further subdivisions. So we might recurse to a different
-     routine that only checks the _perp conditions.
-
-     Second, the distance _should_ decrease according to fairly
-     predictable rules (a factor of 4 with each subdivision). So it might
-     be possible to note that the distance is within a factor of 4 of
-     acceptable, and subdivide once. But proving this might be hard.
+  int n_points;
 
-     Third, at the last subdivision, x_m and y_m can be computed more
-     expeditiously (as in the routine above).
+  n_points = art_bez_subdivide_estimate (x0, y0, x1, y1, x2, y2, x3, y3,
+					 flatness);
+  for (;;)
+    {
+      while (*pn + n_points > *pn_max)
+	art_expand (*p_vpath, ArtVpath, *pn_max);
+      n_points = art_bez_subdivide (x0, y0, x1, y1, x2, y2, x3, y3,
+				    flatness, *p_vpath + *pn, *pn_max - *pn,
+				    BEZ_SUBDIVIDE_LEVELS);
+      if (*pn + n_points <= *pn_max)
+	break;
+    }
+  *pn += n_points;
+}
 
-     Finally, if we were able to subdivide by, say 2 or 3, this would
-     allow considerably finer-grain control, i.e. fewer points for the
-     same flatness tolerance. This would speed things up downstream.
+/**
+ * art_vpath_render_bez_analytic: Render a bezier segment into the vpath, with evenly spaced points.
+ * @p_vpath: Where the pointer to the #ArtVpath structure is stored.
+ * @pn_points: Pointer to the number of points in *@p_vpath.
+ * @pn_points_max: Pointer to the number of points allocated.
+ * @x0: X coordinate of starting bezier point.
+ * @y0: Y coordinate of starting bezier point.
+ * @x1: X coordinate of first bezier control point.
+ * @y1: Y coordinate of first bezier control point.
+ * @x2: X coordinate of second bezier control point.
+ * @y2: Y coordinate of second bezier control point.
+ * @x3: X coordinate of ending bezier point.
+ * @y3: Y coordinate of ending bezier point.
+ * @flatness: Flatness control.
+ *
+ * Same as art_vpath_render_bez(), but the number of segments is worked
+ * out from the curvature of the segment instead of by halving it, and
+ * they are spread along it evenly. The vpath stays further inside
+ * @flatness and its segments vary less in length, which suits offset
+ * curves such as the stroker's, but it takes three to four times as
+ * long and gives a few percent more points.
+**/
+void
+art_vpath_render_bez_analytic (ArtVpath **p_vpath, int *pn, int *pn_max,
+			       double x0, double y0,
+			       double x1, double y1,
+			       double x2, double y2,
+			       double x3, double y3,
+			       double flatness)
+{
+  double bx[4], by[4];
+  int n_quads, n_segs, n_points;
+  double sum;
 
-     In any case, this routine is unlikely to be the bottleneck. It's
-     just that I have this undying quest for more speed...
+  bx[0] = x0; bx[1] = x1; bx[2] = x2; bx[3] = x3;
+  by[0] = y0; by[1] = y1; by[2] = y2; by[3] = y3;
 
-  */
+  n_points = art_bez_flatten_count (bx, by, flatness,
+				    &n_quads, &sum, &n_segs);
+  for (;;)
+    {
+      while (*pn + n_points > *pn_max)
+	art_expand (*p_vpath, ArtVpath, *pn_max);
+      n_points = art_bez_flatten_emit (bx, by, flatness, n_quads, sum, n_segs,
+				       *p_vpath + *pn, *pn_max - *pn);
+      if (*pn + n_points <= *pn_max)
+	break;
+    }
+  *pn += n_points;
+}
 
-  x3_0 = x3 - x0;
-  y3_0 = y3 - y0;
+/**
+ * art_vpath_render_bez_batch: Render many bezier segments into the vpath.
+ * @p_vpath: Where the pointer to the #ArtVpath structure is stored.
+ * @pn_points: Pointer to the number of points in *@p_vpath.
+ * @pn_points_max: Pointer to the number of points allocated.
+ * @coords: Control points of the segments, 8 per segment, in the
+ * order x0, y0, x1, y1, x2, y2, x3, y3.
+ * @n_bez: Number of bezier segments in @coords.
+ * @flatness: Flatness control.
+ *
+ * Same as calling art_vpath_render_bez_analytic() on each of the
+ * @n_bez segments in turn, but the vpath is grown only once, to the
+ * total size needed, before any point is written.
+ **/
+void
+art_vpath_render_bez_batch (ArtVpath **p_vpath, int *pn, int *pn_max,
+			    const double *coords, int n_bez,
+			    double flatness)
+{
+  int *info;
+  double *sums;
+  double bx[4], by[4];
+  int n_points;
+  int i, j;
 
-  /* z3_0_dot is dist z0-z3 squared */
-  z3_0_dot = x3_0 * x3_0 + y3_0 * y3_0;
+  if (n_bez <= 0)
+    return;
 
-  if (z3_0_dot < 0.001)
+  /* n_quads and n_segs for each segment */
+  info = art_new (int, n_bez * 2);
+  sums = art_new (double, n_bez);
+  n_points = 0;
+  for (i = 0; i < n_bez; i++)
     {
-      /* if start and end point are almost identical, the flatness tests
-       * don't work properly, so fall back on testing whether both of
-       * the other two control points are the same as the start point,
-       * too.
-       */
-      if (hypot(x1 - x0, y1 - y0) < 0.001
-	  && hypot(x2 - x0, y2 - y0) < 0.001)
-	  goto nosubdivide;
-      else
-	  goto subdivide;
+      for (j = 0; j < 4; j++)
+	{
+	  bx[j] = coords[i * 8 + j * 2];
+	  by[j] = coords[i * 8 + j * 2 + 1];
+	}
+      n_points += art_bez_flatten_count (bx, by, flatness, &info[i * 2],
+					 &sums[i], &info[i * 2 + 1]);
     }
 
-  /* we can avoid subdivision if:
-
-     z1 has distance no more than flatness from the z0-z3 line
+  while (*pn + n_points > *pn_max)
+    art_expand (*p_vpath, ArtVpath, *pn_max);
 
-     z1 is no more z0'ward than flatness past z0-z3
+  for (i = 0; i < n_bez; i++)
+    {
+      for (j = 0; j < 4; j++)
+	{
+	  bx[j] = coords[i * 8 + j * 2];
+	  by[j] = coords[i * 8 + j * 2 + 1];
+	}
+      for (;;)
+	{
+	  n_points = art_bez_flatten_emit (bx, by, flatness,
+					   info[i * 2], sums[i],
+					   info[i * 2 + 1],
+					   *p_vpath + *pn, *pn_max - *pn);
+	  if (*pn + n_points <= *pn_max)
+	    break;
+	  /* a chord was halved; make room and do it again */
+	  while (*pn + n_points > *pn_max)
+	    art_expand (*p_vpath, ArtVpath, *pn_max);
+	}
+      *pn += n_points;
+    }
 
-     z1 is more z0'ward than z3'ward on the line traversing z0-z3
+  art_free (info);
+  art_free (sums);
+}
 
-     and correspondingly for z2 */
+typedef struct _ArtBezFlattenInfo ArtBezFlattenInfo;
 
-  /* perp is distance from line, multiplied by dist z0-z3 */
-  max_perp_sq = flatness * flatness * z3_0_dot;
+/* Flattening parameters of one curve, from art_bez_flatten_count(). */
+struct _ArtBezFlattenInfo {
+  int n_quads;
+  int n_segs;
+  double sum;
+};
 
-  z1_perp = (y1 - y0) * x3_0 - (x1 - x0) * y3_0;
-  if (z1_perp * z1_perp > max_perp_sq)
-    goto subdivide;
+/* Work out the flattening parameters of each curve of @bez, so that
+   art_bez_path_flatten() needn't do it again. Stores a lower bound for
+   the number of elements of the flattened path, including the ART_END,
+   in *@pn_min. Returns a newly allocated array, one entry per
+   ART_CURVETO. */
+static ArtBezFlattenInfo *
+art_bez_path_flatten_info (const ArtBpath *bez, double flatness, int *pn_min)
+{
+  ArtBezFlattenInfo *info;
+  double bx[4], by[4];
+  int n_curves;
+  int i, n;
 
-  z2_perp = (y3 - y2) * x3_0 - (x3 - x2) * y3_0;
-  if (z2_perp * z2_perp > max_perp_sq)
-    goto subdivide;
+  n_curves = 0;
+  for (i = 0; bez[i].code != ART_END; i++)
+    if (bez[i].code == ART_CURVETO)
+      n_curves++;
+  info = art_new (ArtBezFlattenInfo, n_curves > 0 ? n_curves : 1);
 
-  z1_dot = (x1 - x0) * x3_0 + (y1 - y0) * y3_0;
-  if (z1_dot < 0 && z1_dot * z1_dot > max_perp_sq)
-    goto subdivide;
+  /* Initialization is unnecessary because of the precondition that the
+     bezier path does not begin with LINETO or CURVETO, but is here
+     to make the code warning-free. */
+  bx[3] = 0;
+  by[3] = 0;
 
-  z2_dot = (x3 - x2) * x3_0 + (y3 - y2) * y3_0;
-  if (z2_dot < 0 && z2_dot * z2_dot > max_perp_sq)
-    goto subdivide;
+  n = 1;
+  n_curves = 0;
+  for (i = 0; bez[i].code != ART_END; i++)
+    {
+      if (bez[i].code == ART_CURVETO)
+	{
+	  bx[0] = bx[3];
+	  by[0] = by[3];
+	  bx[1] = bez[i].x1;
+	  by[1] = bez[i].y1;
+	  bx[2] = bez[i].x2;
+	  by[2] = bez[i].y2;
+	  bx[3] = bez[i].x3;
+	  by[3] = bez[i].y3;
+	  n += art_bez_flatten_count (bx, by, flatness,
+				      &info[n_curves].n_quads,
+				      &info[n_curves].sum,
+				      &info[n_curves].n_segs);
+	  n_curves++;
+	}
+      else
+	{
+	  bx[3] = bez[i].x3;
+	  by[3] = bez[i].y3;
+	  n++;
+	}
+    }
+  *pn_min = n;
+  return info;
+}
 
-  if (z1_dot + z1_dot > z3_0_dot)
-    goto subdivide;
+/* Estimate the number of elements of @bez flattened with
+   art_bez_subdivide(), including the ART_END. */
+static int
+art_bez_path_estimate (const ArtBpath *bez, double flatness)
+{
+  double x, y;
+  int i, n;
 
-  if (z2_dot + z2_dot > z3_0_dot)
-    goto subdivide;
+  x = 0;
+  y = 0;
+  n = 1;
+  for (i = 0; bez[i].code != ART_END; i++)
+    {
+      if (bez[i].code == ART_CURVETO)
+	n += art_bez_subdivide_estimate (x, y, bez[i].x1, bez[i].y1,
+					 bez[i].x2, bez[i].y2,
+					 bez[i].x3, bez[i].y3, flatness);
+      else
+	n++;
+      x = bez[i].x3;
+      y = bez[i].y3;
+    }
+  return n;
+}
 
-      
- nosubdivide:
-  /* don't subdivide */
-  art_vpath_add_point (p_vpath, pn, pn_max,
-		       ART_LINETO, x3, y3);
-  return;
+/* Flatten @bez into *@p_out, which has room for *@pn_out elements, or
+   just count the elements if @p_out is NULL. The curves are halved
+   with art_bez_subdivide(), or, if @info is not NULL, flattened
+   analytically with the parameters from art_bez_path_flatten_info(). If @grow is true, *@p_out is
+   reallocated as needed, and *@pn_out updated; otherwise, what doesn't
+   fit is not written. Returns the number of elements of the flattened
+   path, including the ART_END. */
+static int
+art_bez_path_flatten (const ArtBpath *bez, double flatness,
+		      const ArtBezFlattenInfo *info,
+		      ArtVpath **p_out, int *pn_out, art_boolean grow)
+{
+  ArtVpath *out = p_out ? *p_out : NULL;
+  int n_out = p_out ? *pn_out : 0;
+  double bx[4], by[4];
+  int bez_index;
+  int n, n_pts;
 
- subdivide:
+  bx[3] = 0;
+  by[3] = 0;
 
-  xa1 = (x0 + x1) * 0.5;
-  ya1 = (y0 + y1) * 0.5;
-  xa2 = (x0 + 2 * x1 + x2) * 0.25;
-  ya2 = (y0 + 2 * y1 + y2) * 0.25;
-  xb1 = (x1 + 2 * x2 + x3) * 0.25;
-  yb1 = (y1 + 2 * y2 + y3) * 0.25;
-  xb2 = (x2 + x3) * 0.5;
-  yb2 = (y2 + y3) * 0.5;
-  x_m = (xa2 + xb1) * 0.5;
-  y_m = (ya2 + yb1) * 0.5;
+  n = 0;
+  bez_index = 0;
+  do
+    {
 #ifdef VERBOSE
-  printf ("%g,%g %g,%g %g,%g %g,%g\n", xa1, ya1, xa2, ya2,
-	  xb1, yb1, xb2, yb2);
+      printf ("%s %g %g\n",
+	      bez[bez_index].code == ART_CURVETO ? "curveto" :
+	      bez[bez_index].code == ART_LINETO ? "lineto" :
+	      bez[bez_index].code == ART_MOVETO ? "moveto" :
+	      bez[bez_index].code == ART_MOVETO_OPEN ? "moveto-open" :
+	      "end", bez[bez_index].x3, bez[bez_index].y3);
 #endif
-  art_vpath_render_bez (p_vpath, pn, pn_max,
-			x0, y0, xa1, ya1, xa2, ya2, x_m, y_m, flatness);
-  art_vpath_render_bez (p_vpath, pn, pn_max,
-			x_m, y_m, xb1, yb1, xb2, yb2, x3, y3, flatness);
+      switch (bez[bez_index].code)
+	{
+	case ART_MOVETO_OPEN:
+	case ART_MOVETO:
+	case ART_LINETO:
+	  bx[3] = bez[bez_index].x3;
+	  by[3] = bez[bez_index].y3;
+	  if (grow && n == n_out)
+	    art_expand (out, ArtVpath, n_out);
+	  if (n < n_out)
+	    {
+	      out[n].code = bez[bez_index].code;
+	      out[n].x = bx[3];
+	      out[n].y = by[3];
+	    }
+	  n++;
+	  break;
+	case ART_END:
+	  if (grow && n == n_out)
+	    art_expand (out, ArtVpath, n_out);
+	  if (n < n_out)
+	    {
+	      out[n].code = ART_END;
+	      out[n].x = 0;
+	      out[n].y = 0;
+	    }
+	  n++;
+	  break;
+	case ART_CURVETO:
+	  bx[0] = bx[3];
+	  by[0] = by[3];
+	  bx[1] = bez[bez_index].x1;
+	  by[1] = bez[bez_index].y1;
+	  bx[2] = bez[bez_index].x2;
+	  by[2] = bez[bez_index].y2;
+	  bx[3] = bez[bez_index].x3;
+	  by[3] = bez[bez_index].y3;
+#ifdef VERBOSE
+	  printf ("%g,%g %g,%g %g,%g %g,%g\n", bx[0], by[0],
+		  bx[1], by[1], bx[2], by[2], bx[3], by[3]);
+#endif
+	  for (;;)
+	    {
+	      if (info)
+		n_pts = art_bez_flatten_emit (bx, by, flatness,
+					      info->n_quads, info->sum,
+					      info->n_segs,
+					      n < n_out ? out + n : NULL,
+					      n_out - n);
+	      else
+		n_pts = art_bez_subdivide (bx[0], by[0], bx[1], by[1],
+					   bx[2], by[2], bx[3], by[3],
+					   flatness,
+					   n < n_out ? out + n : NULL,
+					   n_out - n, BEZ_SUBDIVIDE_LEVELS);
+	      if (!grow || n + n_pts <= n_out)
+		break;
+	      /* the size was too low; make room and do the curve again */
+	      while (n + n_pts > n_out)
+		art_expand (out, ArtVpath, n_out);
+	    }
+	  n += n_pts;
+	  if (info)
+	    info++;
+	  break;
+	}
+    }
+  while (bez[bez_index++].code != ART_END);
+
+  if (p_out)
+    {
+      *p_out = out;
+      *pn_out = n_out;
+    }
+  return n;
 }
 
 /**
@@ -258,71 +917,173 @@ ArtVpath *
 art_bez_path_to_vec (const ArtBpath *bez, double flatness)
 {
   ArtVpath *vec;
-  int vec_n, vec_n_max;
-  int bez_index;
-  double x, y;
+  int vec_n_max;
 
-  vec_n = 0;
-  vec_n_max = RENDER_SIZE;
+  /* allocate for an estimate of the size, so that the vpath seldom
+     needs to grow */
+  vec_n_max = art_bez_path_estimate (bez, flatness);
   vec = art_new (ArtVpath, vec_n_max);
+  art_bez_path_flatten (bez, flatness, NULL, &vec, &vec_n_max, ART_TRUE);
+  return vec;
+}
 
-  /* Initialization is unnecessary because of the precondition that the
-     bezier path does not begin with LINETO or CURVETO, but is here
-     to make the code warning-free. */
-  x = 0;
-  y = 0;
+/**
+ * art_bez_path_to_vec_analytic: Create vpath from bezier path, with evenly spaced points.
+ * @bez: Bezier path.
+ * @flatness: Flatness control.
+ *
+ * Same as art_bez_path_to_vec(), but flattens the curves with
+ * art_vpath_render_bez_analytic(). See there for the trade-off.
+ *
+ * Return value: Newly allocated vpath.
+ **/
+ArtVpath *
+art_bez_path_to_vec_analytic (const ArtBpath *bez, double flatness)
+{
+  ArtBezFlattenInfo *info;
+  ArtVpath *vec;
+  int vec_n_max;
+
+  /* size first, so that the vpath is allocated at its final size,
+     unless some chord needed halving */
+  info = art_bez_path_flatten_info (bez, flatness, &vec_n_max);
+  vec = art_new (ArtVpath, vec_n_max);
+  art_bez_path_flatten (bez, flatness, info, &vec, &vec_n_max, ART_TRUE);
+  art_free (info);
+  return vec;
+}
+
+/**
+ * art_bez_path_to_vec_size: Size of the vpath for a bezier path.
+ * @bez: Bezier path.
+ * @flatness: Flatness control.
+ *
+ * Computes the number of #ArtVpath elements, including the final
+ * ART_END, that art_bez_path_to_vec() produces for @bez at
+ * @flatness, without storing the flattened path.
+ *
+ * Return value: Number of elements in the flattened path.
+ **/
+int
+art_bez_path_to_vec_size (const ArtBpath *bez, double flatness)
+{
+  return art_bez_path_flatten (bez, flatness, NULL, NULL, NULL, ART_FALSE);
+}
+
+/**
+ * art_bez_path_to_vec_buf: Flatten a bezier path into a given buffer.
+ * @bez: Bezier path.
+ * @flatness: Flatness control.
+ * @buf: Buffer for the resulting vpath.
+ * @n_buf: Number of elements @buf has room for.
+ *
+ * Same as art_bez_path_to_vec(), but stores the result in @buf, so
+ * that no memory is allocated for it. If @buf is too small, the
+ * return value tells how large it needs to be, and the contents of
+ * @buf are undefined. A buffer of art_bez_path_to_vec_size() elements
+ * is always large enough.
+ *
+ * Return value: Number of elements in the flattened path.
+ **/
+int
+art_bez_path_to_vec_buf (const ArtBpath *bez, double flatness,
+			 ArtVpath *buf, int n_buf)
+{
+  return art_bez_path_flatten (bez, flatness, NULL, &buf, &n_buf,
+			       ART_FALSE);
+}
 
+/**
+ * art_bez_path_to_vec_float: Create single precision vpath from bezier path.
+ * @bez: Bezier path.
+ * @flatness: Flatness control.
+ *
+ * Same as art_bez_path_to_vec(), but creates an #ArtVpathF. The curves
+ * are still flattened in double precision, and only the resulting
+ * points are rounded, so the result is the one of art_bez_path_to_vec()
+ * passed through art_vpath_to_float(), without the intermediate path.
+ *
+ * Return value: Newly allocated #ArtVpathF.
+ **/
+ArtVpathF *
+art_bez_path_to_vec_float (const ArtBpath *bez, double flatness)
+{
+  ArtVpathF *vec;
+  ArtVpath *tmp;
+  int n_vec_max, n_tmp_max;
+  double bx[4], by[4];
+  int n_pts;
+  int bez_index;
+  int n, i;
+
+  n_vec_max = art_bez_path_estimate (bez, flatness);
+  vec = art_new (ArtVpathF, n_vec_max);
+  n_tmp_max = 16;
+  tmp = art_new (ArtVpath, n_tmp_max);
+
+  bx[3] = 0;
+  by[3] = 0;
+
+  n = 0;
   bez_index = 0;
   do
     {
-#ifdef VERBOSE
-      printf ("%s %g %g\n",
-	      bez[bez_index].code == ART_CURVETO ? "curveto" :
-	      bez[bez_index].code == ART_LINETO ? "lineto" :
-	      bez[bez_index].code == ART_MOVETO ? "moveto" :
-	      bez[bez_index].code == ART_MOVETO_OPEN ? "moveto-open" :
-	      "end", bez[bez_index].x3, bez[bez_index].y3);
-#endif
       /* make sure space for at least one more code */
-      if (vec_n >= vec_n_max)
-	art_expand (vec, ArtVpath, vec_n_max);
+      if (n == n_vec_max)
+	art_expand (vec, ArtVpathF, n_vec_max);
       switch (bez[bez_index].code)
 	{
 	case ART_MOVETO_OPEN:
 	case ART_MOVETO:
 	case ART_LINETO:
-	  x = bez[bez_index].x3;
-	  y = bez[bez_index].y3;
-	  vec[vec_n].code = bez[bez_index].code;
-	  vec[vec_n].x = x;
-	  vec[vec_n].y = y;
-	  vec_n++;
+	  bx[3] = bez[bez_index].x3;
+	  by[3] = bez[bez_index].y3;
+	  vec[n].code = bez[bez_index].code;
+	  vec[n].x = bx[3];
+	  vec[n].y = by[3];
+	  n++;
 	  break;
 	case ART_END:
-	  vec[vec_n].code = bez[bez_index].code;
-	  vec[vec_n].x = 0;
-	  vec[vec_n].y = 0;
-	  vec_n++;
+	  vec[n].code = ART_END;
+	  vec[n].x = 0;
+	  vec[n].y = 0;
+	  n++;
 	  break;
 	case ART_CURVETO:
-#ifdef VERBOSE
-	  printf ("%g,%g %g,%g %g,%g %g,%g\n", x, y,
-			 bez[bez_index].x1, bez[bez_index].y1,
-			 bez[bez_index].x2, bez[bez_index].y2,
-			 bez[bez_index].x3, bez[bez_index].y3);
-#endif
-	  art_vpath_render_bez (&vec, &vec_n, &vec_n_max,
-				x, y,
-				bez[bez_index].x1, bez[bez_index].y1,
-				bez[bez_index].x2, bez[bez_index].y2,
-				bez[bez_index].x3, bez[bez_index].y3,
-				flatness);
-	  x = bez[bez_index].x3;
-	  y = bez[bez_index].y3;
+	  bx[0] = bx[3];
+	  by[0] = by[3];
+	  bx[1] = bez[bez_index].x1;
+	  by[1] = bez[bez_index].y1;
+	  bx[2] = bez[bez_index].x2;
+	  by[2] = bez[bez_index].y2;
+	  bx[3] = bez[bez_index].x3;
+	  by[3] = bez[bez_index].y3;
+	  /* flatten each curve in double precision, then round */
+	  for (;;)
+	    {
+	      n_pts = art_bez_subdivide (bx[0], by[0], bx[1], by[1],
+					 bx[2], by[2], bx[3], by[3],
+					 flatness, tmp, n_tmp_max,
+					 BEZ_SUBDIVIDE_LEVELS);
+	      if (n_pts <= n_tmp_max)
+		break;
+	      n_tmp_max = n_pts;
+	      tmp = art_renew (tmp, ArtVpath, n_tmp_max);
+	    }
+	  while (n + n_pts > n_vec_max)
+	    art_expand (vec, ArtVpathF, n_vec_max);
+	  for (i = 0; i < n_pts; i++)
+	    {
+	      vec[n].code = ART_LINETO;
+	      vec[n].x = tmp[i].x;
+	      vec[n].y = tmp[i].y;
+	      n++;
+	    }
 	  break;
 	}
     }
   while (bez[bez_index++].code != ART_END);
+
+  art_free (tmp);
   return vec;
 }
-
@@ -41,6 +41,34 @@ ArtPoint *art_bezier_to_vec (double x0, double y0,
 
 ArtVpath *art_bez_path_to_vec (const ArtBpath *bez, double flatness);
 
+ArtVpath *art_bez_path_to_vec_analytic (const ArtBpath *bez,
+					double flatness);
+
+int art_bez_path_to_vec_size (const ArtBpath *bez, double flatness);
+
+int art_bez_path_to_vec_buf (const ArtBpath *bez, double flatness,
+			     ArtVpath *buf, int n_buf);
+
+ArtVpathF *art_bez_path_to_vec_float (const ArtBpath *bez, double flatness);
+
+void art_vpath_render_bez (ArtVpath **p_vpath, int *pn, int *pn_max,
+			   double x0, double y0,
+			   double x1, double y1,
+			   double x2, double y2,
+			   double x3, double y3,
+			   double flatness);
+
+void art_vpath_render_bez_analytic (ArtVpath **p_vpath, int *pn, int *pn_max,
+				    double x0, double y0,
+				    double x1, double y1,
+				    double x2, double y2,
+				    double x3, double y3,
+				    double flatness);
+
+void art_vpath_render_bez_batch (ArtVpath **p_vpath, int *pn, int *pn_max,
+				 const double *coords, int n_bez,
+				 double flatness);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -30,59 +30,81 @@
 #include "art_vpath.h"
 
 
-/* Return the length of the largest subpath within vpath */
-static int
-art_vpath_dash_max_subpath (const ArtVpath *vpath)
+/**
+ * art_vpath_dash_lengths: Compute the segment lengths of a vpath.
+ * @vpath: Vector path.
+ *
+ * Computes, for every point of @vpath, the distance to the next point
+ * if that point is a lineto, and 0 otherwise. The result can be passed
+ * to art_vpath_dash_iterate() or art_svp_vpath_stroke_dash() to save
+ * measuring @vpath again each time it is dashed, for example when
+ * only the offset of the dash changes from frame to frame.
+ *
+ * Return value: Newly allocated array of segment lengths.
+ **/
+double *
+art_vpath_dash_lengths (const ArtVpath *vpath)
 {
-  int max_subpath;
+  double *lengths;
+  int n;
   int i;
-  int start;
 
-  max_subpath = 0;
-  start = 0;
-  for (i = 0; vpath[i].code != ART_END; i++)
+  for (n = 0; vpath[n].code != ART_END; n++);
+  lengths = art_new (double, n + 1);
+  for (i = 0; i < n; i++)
     {
-      if (vpath[i].code == ART_MOVETO || vpath[i].code == ART_MOVETO_OPEN)
+      if (vpath[i + 1].code == ART_LINETO)
 	{
-	  if (i - start > max_subpath)
-	    max_subpath = i - start;
-	  start = i;
+	  double dx, dy;
+
+	  dx = vpath[i + 1].x - vpath[i].x;
+	  dy = vpath[i + 1].y - vpath[i].y;
+	  lengths[i] = sqrt (dx * dx + dy * dy);
 	}
+      else
+	lengths[i] = 0;
     }
-  if (i - start > max_subpath)
-    max_subpath = i - start;
+  lengths[n] = 0;
+  return lengths;
+}
 
-  return max_subpath;
+/* Hand the piece collected so far to the callback, and start over. */
+static void
+art_vpath_dash_flush (ArtVpath **p_piece, int *pn_piece, int *pn_piece_max,
+		      ArtVpathDashFunc callback, void *callback_data)
+{
+  if (*pn_piece == 0)
+    return;
+  art_vpath_add_point (p_piece, pn_piece, pn_piece_max, ART_END, 0, 0);
+  callback (callback_data, *p_piece);
+  *pn_piece = 0;
 }
 
 /**
- * art_vpath_dash: Add dash style to vpath.
+ * art_vpath_dash_iterate: Apply a dash style, one dash at a time.
  * @vpath: Original vpath.
  * @dash: Dash style.
+ * @lengths: Segment lengths from art_vpath_dash_lengths(), or NULL.
+ * @callback: Function called for each dash.
+ * @callback_data: Data passed to @callback.
  *
- * Creates a new vpath that is the result of applying dash style @dash
- * to @vpath.
- *
- * This implementation has two known flaws:
- *
- * First, it adds a spurious break at the beginning of the vpath. The
- * only way I see to resolve this flaw is to run the state forward one
- * dash break at the beginning, and fix up by looping back to the
- * first dash break at the end. This is doable but of course adds some
- * complexity.
- *
- * Second, it does not suppress output points that are within epsilon
- * of each other.
+ * Walks @vpath with dash style @dash, calling @callback with each
+ * resulting dash as a separate vpath, instead of collecting them into
+ * one path as art_vpath_dash() does. The vpath passed to @callback is
+ * only valid during the call, and its storage is reused for the next
+ * dash.
  *
- * Return value: Newly created vpath.
+ * If @lengths is NULL, the segment lengths are computed here.
  **/
-ArtVpath *
-art_vpath_dash (const ArtVpath *vpath, const ArtVpathDash *dash)
+void
+art_vpath_dash_iterate (const ArtVpath *vpath, const ArtVpathDash *dash,
+			const double *lengths,
+			ArtVpathDashFunc callback, void *callback_data)
 {
-  int max_subpath;
-  double *dists;
-  ArtVpath *result;
-  int n_result, n_result_max;
+  double *own_lengths;
+  const double *dists;
+  ArtVpath *piece;
+  int n_piece, n_piece_max;
   int start, end;
   int i;
   double total_dist;
@@ -97,12 +119,13 @@ art_vpath_dash (const ArtVpath *vpath, const ArtVpathDash *dash)
   int offset_init, toggle_init;
   double phase_init;
 
-  max_subpath = art_vpath_dash_max_subpath (vpath);
-  dists = art_new (double, max_subpath);
+  own_lengths = NULL;
+  if (lengths == NULL)
+    lengths = own_lengths = art_vpath_dash_lengths (vpath);
 
-  n_result = 0;
-  n_result_max = 16;
-  result = art_new (ArtVpath, n_result_max);
+  n_piece = 0;
+  n_piece_max = 16;
+  piece = art_new (ArtVpath, n_piece_max);
 
   /* determine initial values of dash state */
   toggle_init = 1;
@@ -121,24 +144,20 @@ art_vpath_dash (const ArtVpath *vpath, const ArtVpathDash *dash)
     {
       for (end = start + 1; vpath[end].code == ART_LINETO; end++);
       /* subpath is [start..end) */
+      dists = lengths + start;
       total_dist = 0;
       for (i = start; i < end - 1; i++)
-	{
-	  double dx, dy;
-
-	  dx = vpath[i + 1].x - vpath[i].x;
-	  dy = vpath[i + 1].y - vpath[i].y;
-	  dists[i - start] = sqrt (dx * dx + dy * dy);
-	  total_dist += dists[i - start];
-	}
+	total_dist += dists[i - start];
       if (total_dist <= dash->dash[offset_init] - phase_init)
 	{
 	  /* subpath fits entirely within first dash */
 	  if (toggle_init)
 	    {
 	      for (i = start; i < end; i++)
-		art_vpath_add_point (&result, &n_result, &n_result_max,
+		art_vpath_add_point (&piece, &n_piece, &n_piece_max,
 				     vpath[i].code, vpath[i].x, vpath[i].y);
+	      art_vpath_dash_flush (&piece, &n_piece, &n_piece_max,
+				    callback, callback_data);
 	    }
 	}
       else
@@ -153,7 +172,7 @@ art_vpath_dash (const ArtVpath *vpath, const ArtVpathDash *dash)
 	  dist = 0;
 	  i = start;
 	  if (toggle)
-	    art_vpath_add_point (&result, &n_result, &n_result_max,
+	    art_vpath_add_point (&piece, &n_piece, &n_piece_max,
 				 ART_MOVETO_OPEN, vpath[i].x, vpath[i].y);
 	  while (i != end - 1)
 	    {
@@ -167,9 +186,12 @@ art_vpath_dash (const ArtVpath *vpath, const ArtVpathDash *dash)
 		  a = dist / dists[i - start];
 		  x = vpath[i].x + a * (vpath[i + 1].x - vpath[i].x);
 		  y = vpath[i].y + a * (vpath[i + 1].y - vpath[i].y);
-		  art_vpath_add_point (&result, &n_result, &n_result_max,
+		  art_vpath_add_point (&piece, &n_piece, &n_piece_max,
 				       toggle ? ART_LINETO : ART_MOVETO_OPEN,
 				       x, y);
+		  if (toggle)
+		    art_vpath_dash_flush (&piece, &n_piece, &n_piece_max,
+					  callback, callback_data);
 		  /* advance to next dash */
 		  toggle = !toggle;
 		  phase = 0;
@@ -184,17 +206,72 @@ art_vpath_dash (const ArtVpath *vpath, const ArtVpathDash *dash)
 		  i++;
 		  dist = 0;
 		  if (toggle)
-		    art_vpath_add_point (&result, &n_result, &n_result_max,
+		    art_vpath_add_point (&piece, &n_piece, &n_piece_max,
 					 ART_LINETO, vpath[i].x, vpath[i].y);
 		}
 	    }
+	  art_vpath_dash_flush (&piece, &n_piece, &n_piece_max,
+				callback, callback_data);
 	}
     }
 
-  art_vpath_add_point (&result, &n_result, &n_result_max,
-		       ART_END, 0, 0);
+  art_free (piece);
+  if (own_lengths != NULL)
+    art_free (own_lengths);
+}
+
+typedef struct _ArtVpathDashData ArtVpathDashData;
+
+struct _ArtVpathDashData {
+  ArtVpath *result;
+  int n_result, n_result_max;
+};
+
+static void
+art_vpath_dash_collect (void *callback_data, ArtVpath *piece)
+{
+  ArtVpathDashData *data = (ArtVpathDashData *)callback_data;
+  int i;
+
+  for (i = 0; piece[i].code != ART_END; i++)
+    art_vpath_add_point (&data->result, &data->n_result, &data->n_result_max,
+			 piece[i].code, piece[i].x, piece[i].y);
+}
+
+/**
+ * art_vpath_dash: Add dash style to vpath.
+ * @vpath: Original vpath.
+ * @dash: Dash style.
+ *
+ * Creates a new vpath that is the result of applying dash style @dash
+ * to @vpath.
+ *
+ * This implementation has two known flaws:
+ *
+ * First, it adds a spurious break at the beginning of the vpath. The
+ * only way I see to resolve this flaw is to run the state forward one
+ * dash break at the beginning, and fix up by looping back to the
+ * first dash break at the end. This is doable but of course adds some
+ * complexity.
+ *
+ * Second, it does not suppress output points that are within epsilon
+ * of each other.
+ *
+ * Return value: Newly created vpath.
+ **/
+ArtVpath *
+art_vpath_dash (const ArtVpath *vpath, const ArtVpathDash *dash)
+{
+  ArtVpathDashData data;
+
+  data.n_result = 0;
+  data.n_result_max = 16;
+  data.result = art_new (ArtVpath, data.n_result_max);
 
-  art_free (dists);
+  art_vpath_dash_iterate (vpath, dash, NULL, art_vpath_dash_collect, &data);
+
+  art_vpath_add_point (&data.result, &data.n_result, &data.n_result_max,
+		       ART_END, 0, 0);
 
-  return result;
+  return data.result;
 }
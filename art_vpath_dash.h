@@ -43,6 +43,17 @@ struct _ArtVpathDash {
 ArtVpath *
 art_vpath_dash (const ArtVpath *vpath, const ArtVpathDash *dash);
 
+/* Streaming interface, one dash at a time. */
+typedef void (*ArtVpathDashFunc) (void *callback_data, ArtVpath *piece);
+
+double *
+art_vpath_dash_lengths (const ArtVpath *vpath);
+
+void
+art_vpath_dash_iterate (const ArtVpath *vpath, const ArtVpathDash *dash,
+			const double *lengths,
+			ArtVpathDashFunc callback, void *callback_data);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
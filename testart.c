@@ -20,6 +20,7 @@
 #include <stdio.h>
 #include <string.h>
 #include <math.h>
+#include <time.h>
 #include "art_misc.h"
 #include "art_vpath.h"
 #include "art_svp.h"
@@ -35,10 +36,14 @@
 #include "art_alphagamma.h"
 #include "art_svp_point.h"
 #include "art_vpath_dash.h"
+#include "art_vpath_bpath.h"
 #include "art_render.h"
 #include "art_render_gradient.h"
 #include "art_render_svp.h"
+#include "art_render_list.h"
 #include "art_svp_intersect.h"
+#include "art_rgb.h"
+#include "art_rgba.h"
 
 #ifdef DEAD_CODE
 static void
@@ -601,6 +606,800 @@ test_intersect (void)
 #endif
 }
 
+/* The straightforward version of art_rgb_run_alpha, for checking the
+   optimized one against. */
+static void
+ref_rgb_run_alpha (art_u8 *buf, art_u8 r, art_u8 g, art_u8 b, int alpha, int n)
+{
+  int i;
+  int v;
+
+  for (i = 0; i < n; i++)
+    {
+      v = *buf;
+      *buf++ = v + (((r - v) * alpha + 0x80) >> 8);
+      v = *buf;
+      *buf++ = v + (((g - v) * alpha + 0x80) >> 8);
+      v = *buf;
+      *buf++ = v + (((b - v) * alpha + 0x80) >> 8);
+    }
+}
+
+#define RUN_ALPHA_SIZE 4096
+#define RUN_ALPHA_ITER 2000
+
+static void
+test_run_alpha (void)
+{
+  art_u8 *buf1, *buf2;
+  int alpha, off, n;
+  int i, j;
+  int n_bad;
+  clock_t t;
+  void (* volatile ref) (art_u8 *, art_u8, art_u8, art_u8, int, int);
+
+  buf1 = art_new (art_u8, RUN_ALPHA_SIZE * 4 + 4);
+  buf2 = art_new (art_u8, RUN_ALPHA_SIZE * 4 + 4);
+
+  /* every alpha, alignment and short length, on random backgrounds */
+  n_bad = 0;
+  for (alpha = 0; alpha <= 256; alpha++)
+    for (off = 0; off < 4; off++)
+      for (n = 0; n < 40; n++)
+	{
+	  for (i = 0; i < n * 3 + 4; i++)
+	    buf1[i] = buf2[i] = rand ();
+	  art_rgb_run_alpha (buf1 + off, 0x12, 0xed, 0x80, alpha, n);
+	  ref_rgb_run_alpha (buf2 + off, 0x12, 0xed, 0x80, alpha, n);
+	  if (memcmp (buf1, buf2, n * 3 + 4))
+	    n_bad++;
+	}
+  printf ("art_rgb_run_alpha: %d mismatches\n", n_bad);
+
+  for (i = 0; i < RUN_ALPHA_SIZE * 4; i++)
+    buf1[i] = rand ();
+
+  /* called through a pointer, so that it isn't inlined and
+     specialized for the constant arguments */
+  ref = ref_rgb_run_alpha;
+  t = clock ();
+  for (j = 0; j < RUN_ALPHA_ITER; j++)
+    ref (buf1, 0x12, 0xed, 0x80, 0x60, RUN_ALPHA_SIZE);
+  printf ("bytewise rgb run_alpha: %.2f ns/pixel\n",
+	  (clock () - t) * 1e9 / CLOCKS_PER_SEC /
+	  ((double)RUN_ALPHA_ITER * RUN_ALPHA_SIZE));
+
+  t = clock ();
+  for (j = 0; j < RUN_ALPHA_ITER; j++)
+    art_rgb_run_alpha (buf1, 0x12, 0xed, 0x80, 0x60, RUN_ALPHA_SIZE);
+  printf ("art_rgb_run_alpha: %.2f ns/pixel\n",
+	  (clock () - t) * 1e9 / CLOCKS_PER_SEC /
+	  ((double)RUN_ALPHA_ITER * RUN_ALPHA_SIZE));
+
+  /* mostly opaque destination, as for antialiased edges over a
+     filled background */
+  for (i = 0; i < RUN_ALPHA_SIZE * 4; i++)
+    buf1[i] = (i & 3) == 3 ? 0xff : rand ();
+  t = clock ();
+  for (j = 0; j < RUN_ALPHA_ITER; j++)
+    art_rgba_run_alpha (buf1, 0x12, 0xed, 0x80, 0x60, RUN_ALPHA_SIZE);
+  printf ("art_rgba_run_alpha: %.2f ns/pixel\n",
+	  (clock () - t) * 1e9 / CLOCKS_PER_SEC /
+	  ((double)RUN_ALPHA_ITER * RUN_ALPHA_SIZE));
+
+  art_free (buf1);
+  art_free (buf2);
+}
+
+/* The one pixel at a time version of art_rgba_rgba_composite, for
+   checking the optimized one against. */
+static void
+ref_rgba_rgba_composite (art_u8 *dst, const art_u8 *src, int n)
+{
+  int i;
+#ifdef WORDS_BIGENDIAN
+  art_u32 src_rgba, dst_rgba;
+#else
+  art_u32 src_abgr, dst_abgr;
+#endif
+  art_u8 src_alpha, dst_alpha;
+
+  for (i = 0; i < n; i++)
+    {
+#ifdef WORDS_BIGENDIAN
+      src_rgba = ((art_u32 *)src)[i];
+      src_alpha = src_rgba & 0xff;
+#else
+      src_abgr = ((art_u32 *)src)[i];
+      src_alpha = (src_abgr >> 24) & 0xff;
+#endif
+      if (src_alpha)
+	{
+	  if (src_alpha == 0xff ||
+	      (
+#ifdef WORDS_BIGENDIAN
+	       dst_rgba = ((art_u32 *)dst)[i],
+	       dst_alpha = dst_rgba & 0xff,
+#else
+	       dst_abgr = ((art_u32 *)dst)[i],
+	       dst_alpha = (dst_abgr >> 24),
+#endif
+	       dst_alpha == 0))
+#ifdef WORDS_BIGENDIAN
+	    ((art_u32 *)dst)[i] = src_rgba;
+#else
+	    ((art_u32 *)dst)[i] = src_abgr;
+#endif
+	  else
+	    {
+	      int r, g, b, a;
+	      int src_r, src_g, src_b;
+	      int dst_r, dst_g, dst_b;
+	      int tmp;
+	      int c;
+
+	      tmp = (255 - src_alpha) * (255 - dst_alpha) + 0x80;
+	      a = 255 - ((tmp + (tmp >> 8)) >> 8);
+	      c = ((src_alpha << 16) + (a >> 1)) / a;
+#ifdef WORDS_BIGENDIAN
+	      src_r = (src_rgba >> 24) & 0xff;
+	      src_g = (src_rgba >> 16) & 0xff;
+	      src_b = (src_rgba >> 8) & 0xff;
+	      dst_r = (dst_rgba >> 24) & 0xff;
+	      dst_g = (dst_rgba >> 16) & 0xff;
+	      dst_b = (dst_rgba >> 8) & 0xff;
+#else
+	      src_r = src_abgr & 0xff;
+	      src_g = (src_abgr >> 8) & 0xff;
+	      src_b = (src_abgr >> 16) & 0xff;
+	      dst_r = dst_abgr & 0xff;
+	      dst_g = (dst_abgr >> 8) & 0xff;
+	      dst_b = (dst_abgr >> 16) & 0xff;
+#endif
+	      r = dst_r + (((src_r - dst_r) * c + 0x8000) >> 16);
+	      g = dst_g + (((src_g - dst_g) * c + 0x8000) >> 16);
+	      b = dst_b + (((src_b - dst_b) * c + 0x8000) >> 16);
+#ifdef WORDS_BIGENDIAN
+	    ((art_u32 *)dst)[i] = (r << 24) | (g << 16) | (b << 8) | a;
+#else
+	    ((art_u32 *)dst)[i] = (a << 24) | (b << 16) | (g << 8) | r;
+#endif
+	    }
+	}
+    }
+}
+
+#define COMPOSITE_SIZE 4096
+#define COMPOSITE_ITER 500
+
+static void
+test_composite_time (const char *name, const art_u8 *src, art_u8 *dst,
+		     void (*composite) (art_u8 *, const art_u8 *, int))
+{
+  void (* volatile func) (art_u8 *, const art_u8 *, int) = composite;
+  clock_t t;
+  int j;
+
+  t = clock ();
+  for (j = 0; j < COMPOSITE_ITER; j++)
+    {
+      /* fresh half transparent destination, as for flattening layers */
+      memset (dst, 0x80, COMPOSITE_SIZE * 4);
+      func (dst, src, COMPOSITE_SIZE);
+    }
+  printf ("%s: %.2f ns/pixel\n", name,
+	  (clock () - t) * 1e9 / CLOCKS_PER_SEC /
+	  ((double)COMPOSITE_ITER * COMPOSITE_SIZE));
+}
+
+static void
+test_composite (void)
+{
+  art_u32 *src, *dst1, *dst2;
+  art_u8 *p;
+  int src_alpha, dst_alpha;
+  int i, j;
+  int n_bad;
+
+  src = art_new (art_u32, COMPOSITE_SIZE);
+  dst1 = art_new (art_u32, COMPOSITE_SIZE);
+  dst2 = art_new (art_u32, COMPOSITE_SIZE);
+
+  /* every pair of alphas, with random colors */
+  n_bad = 0;
+  for (src_alpha = 0; src_alpha < 256; src_alpha++)
+    {
+      for (dst_alpha = 0; dst_alpha < 256; dst_alpha++)
+	{
+	  p = (art_u8 *)(src + dst_alpha);
+	  p[0] = rand (); p[1] = rand (); p[2] = rand ();
+	  p[3] = src_alpha;
+	  p = (art_u8 *)(dst1 + dst_alpha);
+	  p[0] = rand (); p[1] = rand (); p[2] = rand ();
+	  p[3] = dst_alpha;
+	  dst2[dst_alpha] = dst1[dst_alpha];
+	}
+      art_rgba_rgba_composite ((art_u8 *)dst1, (art_u8 *)src, 256);
+      ref_rgba_rgba_composite ((art_u8 *)dst2, (art_u8 *)src, 256);
+      n_bad += memcmp (dst1, dst2, 256 * 4) != 0;
+    }
+
+  /* mixed runs of transparent, opaque and translucent source pixels,
+     at every length modulo the group size */
+  for (i = 0; i < 1000; i++)
+    {
+      int n = rand () % 64;
+
+      for (j = 0; j < n; j++)
+	{
+	  p = (art_u8 *)(src + j);
+	  p[0] = rand (); p[1] = rand (); p[2] = rand ();
+	  p[3] = (rand () & 1) ? 0 : (rand () & 1) ? 0xff : rand ();
+	  dst1[j] = dst2[j] = rand ();
+	}
+      art_rgba_rgba_composite ((art_u8 *)dst1, (art_u8 *)src, n);
+      ref_rgba_rgba_composite ((art_u8 *)dst2, (art_u8 *)src, n);
+      n_bad += memcmp (dst1, dst2, n * 4) != 0;
+    }
+  printf ("art_rgba_rgba_composite: %d mismatches\n", n_bad);
+
+  /* a typical layer: opaque and transparent areas with antialiased
+     edges between them */
+  for (i = 0; i < COMPOSITE_SIZE; i++)
+    {
+      p = (art_u8 *)(src + i);
+      p[0] = rand (); p[1] = rand (); p[2] = rand ();
+      j = i % 256;
+      p[3] = j < 96 ? 0xff : j < 104 ? (j - 96) * 32 : 0;
+    }
+  test_composite_time ("pixelwise rgba composite", (art_u8 *)src,
+		       (art_u8 *)dst2, ref_rgba_rgba_composite);
+  test_composite_time ("art_rgba_rgba_composite", (art_u8 *)src,
+		       (art_u8 *)dst1, art_rgba_rgba_composite);
+
+  art_free (src);
+  art_free (dst1);
+  art_free (dst2);
+}
+
+/* Distance from (@x, @y) to the segment from (@x0, @y0) to (@x1, @y1). */
+static double
+seg_dist (double x, double y, double x0, double y0, double x1, double y1)
+{
+  double dx = x1 - x0;
+  double dy = y1 - y0;
+  double len2 = dx * dx + dy * dy;
+  double t = 0;
+
+  if (len2 > 0)
+    t = ((x - x0) * dx + (y - y0) * dy) / len2;
+  if (t < 0)
+    t = 0;
+  else if (t > 1)
+    t = 1;
+  return hypot (x - x0 - t * dx, y - y0 - t * dy);
+}
+
+#define FLATTEN_N_CURVES 3000
+#define FLATTEN_N_SAMPLES 1000
+
+/* Largest distance from a point of the cubic @c to the polyline @vec. */
+static double
+flatten_deviation (const double *c, const ArtVpath *vec)
+{
+  double x, y, t, mt, d, dmin, dmax;
+  int i, k;
+
+  dmax = 0;
+  for (k = 0; k <= FLATTEN_N_SAMPLES; k++)
+    {
+      t = (double)k / FLATTEN_N_SAMPLES;
+      mt = 1 - t;
+      x = mt * mt * mt * c[0] + 3 * mt * t * (mt * c[2] + t * c[4]) +
+	t * t * t * c[6];
+      y = mt * mt * mt * c[1] + 3 * mt * t * (mt * c[3] + t * c[5]) +
+	t * t * t * c[7];
+      dmin = hypot (x - vec[0].x, y - vec[0].y);
+      for (i = 1; vec[i].code == ART_LINETO; i++)
+	{
+	  d = seg_dist (x, y, vec[i - 1].x, vec[i - 1].y, vec[i].x, vec[i].y);
+	  if (d < dmin)
+	    dmin = d;
+	}
+      if (dmin > dmax)
+	dmax = dmin;
+    }
+  return dmax;
+}
+
+static void
+test_flatten (void)
+{
+  static const double flatness[] = { 1, 0.25 };
+  ArtBpath bez[3];
+  ArtVpath *vec;
+  double c[8];
+  double scale, dev, worst;
+  int n_bad, n_points;
+  int f, i, j;
+
+  for (f = 0; f < 2; f++)
+    {
+      srand (1);
+      n_bad = 0;
+      n_points = 0;
+      worst = 0;
+      for (i = 0; i < FLATTEN_N_CURVES; i++)
+	{
+	  /* small curves, where loops and cusps are hardest to get
+	     right, up to large ones */
+	  scale = i % 3 == 0 ? 10 : i % 3 == 1 ? 100 : 1000;
+	  for (j = 0; j < 8; j++)
+	    c[j] = rand () * scale / RAND_MAX;
+	  bez[0].code = ART_MOVETO_OPEN;
+	  bez[0].x3 = c[0];
+	  bez[0].y3 = c[1];
+	  bez[1].code = ART_CURVETO;
+	  bez[1].x1 = c[2];
+	  bez[1].y1 = c[3];
+	  bez[1].x2 = c[4];
+	  bez[1].y2 = c[5];
+	  bez[1].x3 = c[6];
+	  bez[1].y3 = c[7];
+	  bez[2].code = ART_END;
+
+	  vec = art_bez_path_to_vec (bez, flatness[f]);
+	  for (j = 1; vec[j].code == ART_LINETO; j++);
+	  n_points += j;
+	  dev = flatten_deviation (c, vec);
+	  if (dev > flatness[f])
+	    n_bad++;
+	  if (dev > worst)
+	    worst = dev;
+	  art_free (vec);
+	}
+      printf ("flatness %g: %d of %d curves exceed it, worst %g, %d points\n",
+	      flatness[f], n_bad, FLATTEN_N_CURVES, worst, n_points);
+    }
+}
+
+#define INDEX_N_SHAPES 20
+#define INDEX_N_POINTS 2000
+
+/* Check the winding numbers and distances that ArtSVPIndex reports
+   against art_svp_point_wind() and art_svp_point_dist(). */
+static void
+test_svp_index (void)
+{
+  ArtVpath *vpath;
+  ArtSVP *svp;
+  ArtSVPIndex *index;
+  ArtPoint points[INDEX_N_POINTS];
+  int winds[INDEX_N_POINTS];
+  double dists[INDEX_N_POINTS];
+  int n_wind_bad, n_dist_bad, n_batch_bad;
+  int i, j;
+  double d;
+
+  srand (1);
+  n_wind_bad = 0;
+  n_dist_bad = 0;
+  n_batch_bad = 0;
+  for (i = 0; i < INDEX_N_SHAPES; i++)
+    {
+      vpath = randstar (10 + 5 * i);
+      if (i & 1)
+	svp = art_svp_vpath_stroke (vpath,
+				    ART_PATH_STROKE_JOIN_MITER,
+				    ART_PATH_STROKE_CAP_BUTT,
+				    15, 4, 0.5);
+      else
+	svp = art_svp_from_vpath (vpath);
+      index = art_svp_index_new (svp);
+
+      for (j = 0; j < INDEX_N_POINTS; j++)
+	{
+	  /* half the points on the pixel grid, where they can fall
+	     exactly on a vertex of the star */
+	  if (j & 1)
+	    {
+	      points[j].x = rand () * (520.0 / RAND_MAX) - 10;
+	      points[j].y = rand () * (520.0 / RAND_MAX) - 10;
+	    }
+	  else
+	    {
+	      points[j].x = rand () % 520 - 10;
+	      points[j].y = rand () % 520 - 10;
+	    }
+	  if (art_svp_index_point_wind (index, points[j].x, points[j].y) !=
+	      art_svp_point_wind (svp, points[j].x, points[j].y))
+	    n_wind_bad++;
+	  d = art_svp_point_dist (svp, points[j].x, points[j].y);
+	  if (fabs (art_svp_index_point_dist (index, points[j].x, points[j].y)
+		    - d) > 1e-9 * (1 + d))
+	    n_dist_bad++;
+	}
+
+      art_svp_index_point_wind_batch (index, points, INDEX_N_POINTS, winds);
+      art_svp_index_point_dist_batch (index, points, INDEX_N_POINTS, dists);
+      for (j = 0; j < INDEX_N_POINTS; j++)
+	if (winds[j] !=
+	    art_svp_index_point_wind (index, points[j].x, points[j].y) ||
+	    dists[j] !=
+	    art_svp_index_point_dist (index, points[j].x, points[j].y))
+	  n_batch_bad++;
+
+      art_svp_index_free (index);
+      art_svp_free (svp);
+      art_free (vpath);
+    }
+  printf ("svp index: %d wind mismatches, %d dist mismatches, "
+	  "%d batch mismatches in %d points\n",
+	  n_wind_bad, n_dist_bad, n_batch_bad,
+	  INDEX_N_SHAPES * INDEX_N_POINTS);
+}
+
+#define CACHE_N_SHAPES 8
+#define CACHE_N_DRAWS 400
+
+/* Render the shapes at @offsets through the cache and with
+   art_render_svp(), returning the number of bytes in which the results
+   differ. The cache rasterizes a shape moved by the fractional part of
+   its offset and places the mask at the integer part, so the direct
+   render does the same, moving the render rectangle instead of the
+   shape by the integer part. The rasterizer does not give the same
+   coverage for a shape and its translate to the bit. */
+static int
+svp_cache_compare (ArtVpath **shapes, const double *offsets,
+		   int max_bytes, ArtSVPCacheStats *stats)
+{
+  static art_u8 buf1[512 * 512 * 3], buf2[512 * 512 * 3];
+  ArtPixMaxDepth color[3] = { 0x8000, 0x0000, 0x4000 };
+  ArtSVPCache *cache;
+  ArtRender *render;
+  ArtVpath *shape, *moved;
+  ArtSVP *svp;
+  double fx, fy;
+  int ix, iy;
+  int n_bad;
+  int i, j;
+
+  cache = art_svp_cache_new (max_bytes);
+  memset (buf1, 0xff, sizeof (buf1));
+  memset (buf2, 0xff, sizeof (buf2));
+  for (i = 0; i < CACHE_N_DRAWS; i++)
+    {
+      shape = shapes[i % CACHE_N_SHAPES];
+      svp = art_svp_from_vpath (shape);
+      render = art_render_new (0, 0, 512, 512, buf1, 512 * 3, 3, 8,
+			       ART_ALPHA_NONE, NULL);
+      art_render_svp_cached (render, cache, svp,
+			     offsets[2 * i], offsets[2 * i + 1]);
+      art_render_image_solid (render, color);
+      art_render_invoke (render);
+      art_svp_free (svp);
+
+      ix = (int)floor (offsets[2 * i]);
+      iy = (int)floor (offsets[2 * i + 1]);
+      fx = offsets[2 * i] - ix;
+      fy = offsets[2 * i + 1] - iy;
+      for (j = 0; shape[j].code != ART_END; j++);
+      moved = art_new (ArtVpath, j + 1);
+      for (j = 0; shape[j].code != ART_END; j++)
+	{
+	  moved[j].code = shape[j].code;
+	  moved[j].x = shape[j].x + fx;
+	  moved[j].y = shape[j].y + fy;
+	}
+      moved[j].code = ART_END;
+      svp = art_svp_from_vpath (moved);
+      render = art_render_new (-ix, -iy, 512 - ix, 512 - iy, buf2, 512 * 3,
+			       3, 8, ART_ALPHA_NONE, NULL);
+      art_render_svp (render, svp);
+      art_render_image_solid (render, color);
+      art_render_invoke (render);
+      art_svp_free (svp);
+      art_free (moved);
+    }
+  art_svp_cache_get_stats (cache, stats);
+  art_svp_cache_free (cache);
+
+  n_bad = 0;
+  for (i = 0; i < 512 * 512 * 3; i++)
+    if (buf1[i] != buf2[i])
+      n_bad++;
+  return n_bad;
+}
+
+/* Check art_render_svp_cached() against art_render_svp(). The shapes
+   move by whole quarter pixels, which the cache does not round, so
+   both renders must agree to the byte. */
+static void
+test_svp_cache (void)
+{
+  static const int budgets[] = { 1 << 20, 65536 };
+  ArtVpath *shapes[CACHE_N_SHAPES];
+  double offsets[2 * CACHE_N_DRAWS];
+  ArtSVPCacheStats stats;
+  int n_bad;
+  int i, j;
+
+  srand (1);
+  for (i = 0; i < CACHE_N_SHAPES; i++)
+    {
+      /* stars with the same number of points, so that many shapes
+	 have the same number of segments and points */
+      shapes[i] = randstar (12 + 4 * (i & 1));
+      for (j = 0; shapes[i][j].code != ART_END; j++)
+	{
+	  shapes[i][j].x = (shapes[i][j].x - 250) * 0.12;
+	  shapes[i][j].y = (shapes[i][j].y - 250) * 0.12;
+	}
+    }
+  for (i = 0; i < 2 * CACHE_N_DRAWS; i++)
+    offsets[i] = 32 + (rand () % (448 * 4)) * 0.25;
+
+  for (i = 0; i < 2; i++)
+    {
+      n_bad = svp_cache_compare (shapes, offsets, budgets[i], &stats);
+      printf ("svp cache, budget %d: %d mismatches, "
+	      "%lu hits, %lu misses, %lu evictions\n",
+	      budgets[i], n_bad, stats.n_hits, stats.n_misses,
+	      stats.n_evictions);
+    }
+  for (i = 0; i < CACHE_N_SHAPES; i++)
+    art_free (shapes[i]);
+}
+
+#define LIST_N_SHAPES 60
+
+/* Check an ArtRenderList against drawing its shapes one by one with
+   art_render_svp(), for destinations with and without alpha. */
+static void
+test_render_list (void)
+{
+  static art_u8 buf1[512 * 512 * 4], buf2[512 * 512 * 4];
+  static const ArtAlphaType alpha_types[] = {
+    ART_ALPHA_NONE, ART_ALPHA_SEPARATE
+  };
+  ArtSVP *svps[LIST_N_SHAPES];
+  ArtPixMaxDepth colors[LIST_N_SHAPES][3];
+  int opacities[LIST_N_SHAPES];
+  double dx, dy;
+  ArtVpath *vpath;
+  ArtRenderList *list;
+  ArtRender *render;
+  int n_ch, n_bad;
+  int a, i, j;
+
+  srand (1);
+  for (i = 0; i < LIST_N_SHAPES; i++)
+    {
+      vpath = randstar (10 + (i % 5) * 10);
+      dx = rand () * (400.0 / RAND_MAX) - 100;
+      dy = rand () * (400.0 / RAND_MAX) - 100;
+      for (j = 0; vpath[j].code != ART_END; j++)
+	{
+	  vpath[j].x = vpath[j].x * 0.6 + dx;
+	  vpath[j].y = vpath[j].y * 0.6 + dy;
+	}
+      svps[i] = art_svp_from_vpath (vpath);
+      art_free (vpath);
+      for (j = 0; j < 3; j++)
+	colors[i][j] = rand () & 0xffff;
+      opacities[i] = i % 3 ? 0x10000 : rand () & 0xffff;
+    }
+
+  for (a = 0; a < 2; a++)
+    {
+      n_ch = alpha_types[a] == ART_ALPHA_NONE ? 3 : 4;
+      for (i = 0; i < 512 * 512 * n_ch; i++)
+	buf1[i] = buf2[i] = i * 7;
+
+      list = art_render_list_new (0, 0, 512, 512, buf1, 512 * n_ch, 3, 8,
+				  alpha_types[a], NULL);
+      art_render_list_set_band_height (list, 7);
+      for (i = 0; i < LIST_N_SHAPES; i++)
+	art_render_list_add_svp (list, svps[i], colors[i], opacities[i],
+				 ART_COMPOSITE_NORMAL);
+      art_render_list_invoke (list);
+      art_render_list_free (list);
+
+      for (i = 0; i < LIST_N_SHAPES; i++)
+	{
+	  render = art_render_new (0, 0, 512, 512, buf2, 512 * n_ch, 3, 8,
+				   alpha_types[a], NULL);
+	  art_render_svp (render, svps[i]);
+	  if (opacities[i] < 0x10000)
+	    art_render_mask_solid (render, opacities[i]);
+	  art_render_image_solid (render, colors[i]);
+	  art_render_invoke (render);
+	}
+
+      n_bad = 0;
+      for (i = 0; i < 512 * 512 * n_ch; i++)
+	if (buf1[i] != buf2[i])
+	  n_bad++;
+      printf ("render list, %d channels: %d mismatches\n", n_ch, n_bad);
+    }
+  for (i = 0; i < LIST_N_SHAPES; i++)
+    art_svp_free (svps[i]);
+}
+
+#define GAMMA_N_SHAPES 20
+
+/* Render raw stroke outlines of stars, whose overlapping segments take
+   the coverage above full, with alphagamma. A render list must give the
+   same result as single renders. */
+static void
+test_gamma_stroke (void)
+{
+  static art_u8 buf1[512 * 512 * 4], buf2[512 * 512 * 4];
+  static const ArtAlphaType alpha_types[] = {
+    ART_ALPHA_NONE, ART_ALPHA_SEPARATE
+  };
+  static const double gammas[] = { 1.0, 2.2, 3.5 };
+  ArtSVP *svps[GAMMA_N_SHAPES];
+  ArtPixMaxDepth colors[GAMMA_N_SHAPES][3];
+  ArtVpath *vpath, *outline;
+  ArtAlphaGamma *alphagamma;
+  ArtRenderList *list;
+  ArtRender *render;
+  int n_ch, n_list_bad;
+  int a, g, i, j;
+
+  srand (1);
+  for (i = 0; i < GAMMA_N_SHAPES; i++)
+    {
+      vpath = randstar (10 + i);
+      outline = art_svp_vpath_stroke_raw (vpath,
+					  i & 1 ? ART_PATH_STROKE_JOIN_MITER :
+					  ART_PATH_STROKE_JOIN_ROUND,
+					  ART_PATH_STROKE_CAP_BUTT,
+					  2 + i, 4, 0.5);
+      svps[i] = art_svp_from_vpath (outline);
+      art_free (outline);
+      art_free (vpath);
+      for (j = 0; j < 3; j++)
+	colors[i][j] = rand () & 0xffff;
+    }
+
+  for (a = 0; a < 2; a++)
+    {
+      n_ch = alpha_types[a] == ART_ALPHA_NONE ? 3 : 4;
+      for (g = 0; g < 3; g++)
+	{
+	  alphagamma = art_alphagamma_new (gammas[g]);
+	  for (i = 0; i < 512 * 512 * n_ch; i++)
+	    buf1[i] = buf2[i] = i * 7;
+	  for (i = 0; i < GAMMA_N_SHAPES; i++)
+	    {
+	      render = art_render_new (0, 0, 512, 512, buf1, 512 * n_ch,
+				       3, 8, alpha_types[a], alphagamma);
+	      art_render_svp (render, svps[i]);
+	      art_render_image_solid (render, colors[i]);
+	      art_render_invoke (render);
+	    }
+
+	  list = art_render_list_new (0, 0, 512, 512, buf2, 512 * n_ch,
+				      3, 8, alpha_types[a], alphagamma);
+	  for (i = 0; i < 512 * 512 * n_ch; i++)
+	    buf2[i] = i * 7;
+	  for (i = 0; i < GAMMA_N_SHAPES; i++)
+	    art_render_list_add_svp (list, svps[i], colors[i], 0x10000,
+				     ART_COMPOSITE_NORMAL);
+	  art_render_list_invoke (list);
+	  art_render_list_free (list);
+	  n_list_bad = 0;
+	  for (i = 0; i < 512 * 512 * n_ch; i++)
+	    if (buf1[i] != buf2[i])
+	      n_list_bad++;
+
+	  printf ("gamma %g, %d channels: %d render list mismatches\n",
+		  gammas[g], n_ch, n_list_bad);
+	  art_alphagamma_free (alphagamma);
+	}
+    }
+  for (i = 0; i < GAMMA_N_SHAPES; i++)
+    art_svp_free (svps[i]);
+}
+
+#define BSTROKE_SIZE 512
+#define BSTROKE_N_PATHS 200
+
+/* Count the segments of an svp. */
+static int
+svp_n_points (const ArtSVP *svp)
+{
+  int i, n = 0;
+
+  for (i = 0; i < svp->n_segs; i++)
+    n += svp->segs[i].n_points - 1;
+  return n;
+}
+
+/* Stroke random curves, open and closed, with art_svp_bpath_stroke()
+   and compare the coverage with that of a path flattened to a much
+   finer flatness and stroked, and the number of segments with that of
+   a path flattened to the same flatness and stroked. */
+static void
+test_bpath_stroke (void)
+{
+  static art_u8 buf1[BSTROKE_SIZE * BSTROKE_SIZE];
+  static art_u8 buf2[BSTROKE_SIZE * BSTROKE_SIZE];
+  static const double widths[] = { 1.5, 5.7, 16, 38.5 };
+  ArtBpath bez[5];
+  ArtVpath *vec;
+  ArtSVP *svp, *ref;
+  int n_bad, n_bad_paths, n_points, n_points_flat;
+  int w, i, j, d;
+
+  for (w = 0; w < 4; w++)
+    {
+      srand (1);
+      n_bad = 0;
+      n_bad_paths = 0;
+      n_points = 0;
+      n_points_flat = 0;
+      for (i = 0; i < BSTROKE_N_PATHS; i++)
+	{
+	  bez[0].code = i & 1 ? ART_MOVETO : ART_MOVETO_OPEN;
+	  bez[0].x3 = 50 + rand () * 412.0 / RAND_MAX;
+	  bez[0].y3 = 50 + rand () * 412.0 / RAND_MAX;
+	  for (j = 1; j < 4; j++)
+	    {
+	      bez[j].code = ART_CURVETO;
+	      bez[j].x1 = 50 + rand () * 412.0 / RAND_MAX;
+	      bez[j].y1 = 50 + rand () * 412.0 / RAND_MAX;
+	      bez[j].x2 = 50 + rand () * 412.0 / RAND_MAX;
+	      bez[j].y2 = 50 + rand () * 412.0 / RAND_MAX;
+	      bez[j].x3 = 50 + rand () * 412.0 / RAND_MAX;
+	      bez[j].y3 = 50 + rand () * 412.0 / RAND_MAX;
+	    }
+	  if (i & 1)
+	    {
+	      bez[3].x3 = bez[0].x3;
+	      bez[3].y3 = bez[0].y3;
+	    }
+	  bez[4].code = ART_END;
+
+	  svp = art_svp_bpath_stroke (bez, i % 3, (i / 3) % 3,
+				      widths[w], 4, 0.25);
+	  n_points += svp_n_points (svp);
+	  art_gray_svp_aa (svp, 0, 0, BSTROKE_SIZE, BSTROKE_SIZE,
+			   buf1, BSTROKE_SIZE);
+	  art_svp_free (svp);
+
+	  vec = art_bez_path_to_vec (bez, 0.25);
+	  ref = art_svp_vpath_stroke (vec, i % 3, (i / 3) % 3,
+				      widths[w], 4, 0.25);
+	  n_points_flat += svp_n_points (ref);
+	  art_svp_free (ref);
+	  art_free (vec);
+
+	  vec = art_bez_path_to_vec (bez, 0.01);
+	  ref = art_svp_vpath_stroke (vec, i % 3, (i / 3) % 3,
+				      widths[w], 4, 0.01);
+	  art_gray_svp_aa (ref, 0, 0, BSTROKE_SIZE, BSTROKE_SIZE,
+			   buf2, BSTROKE_SIZE);
+	  art_svp_free (ref);
+	  art_free (vec);
+
+	  d = 0;
+	  for (j = 0; j < BSTROKE_SIZE * BSTROKE_SIZE; j++)
+	    if (buf1[j] - buf2[j] > 64 || buf2[j] - buf1[j] > 64)
+	      d++;
+	  n_bad += d;
+	  if (d > 100)
+	    n_bad_paths++;
+	}
+      printf ("width %g: %d pixels off by more than 64, %d of %d paths "
+	      "with more than 100; %d segments vs %d flattened\n",
+	      widths[w], n_bad, n_bad_paths, BSTROKE_N_PATHS,
+	      n_points, n_points_flat);
+    }
+}
+
 static void
 usage (void)
 {
@@ -610,7 +1409,15 @@ usage (void)
 "  gradient   -- test pattern for rendered gradients\n"
 "  dash       -- dash test (output is valid PostScript)\n"
 "  dist       -- distance test\n"
-"  intersect  -- softball test for intersector\n");
+"  intersect  -- softball test for intersector\n"
+"  runalpha   -- check and time art_rgb_run_alpha\n"
+"  composite  -- check and time art_rgba_rgba_composite\n"
+"  flatten    -- check the deviation of flattened beziers\n"
+"  svpindex   -- check ArtSVPIndex point queries\n"
+"  svpcache   -- check art_render_svp_cached\n"
+"  renderlist -- check ArtRenderList against single renders\n"
+"  gamma      -- render strokes with alphagamma\n"
+"  bpathstroke -- compare art_svp_bpath_stroke with flatten and stroke\n");
   exit (1);
 }
 
@@ -630,6 +1437,22 @@ main (int argc, char **argv)
     test_dash ();
   else if (!strcmp (argv[1], "intersect"))
     test_intersect ();
+  else if (!strcmp (argv[1], "runalpha"))
+    test_run_alpha ();
+  else if (!strcmp (argv[1], "composite"))
+    test_composite ();
+  else if (!strcmp (argv[1], "flatten"))
+    test_flatten ();
+  else if (!strcmp (argv[1], "svpindex"))
+    test_svp_index ();
+  else if (!strcmp (argv[1], "svpcache"))
+    test_svp_cache ();
+  else if (!strcmp (argv[1], "renderlist"))
+    test_render_list ();
+  else if (!strcmp (argv[1], "gamma"))
+    test_gamma_stroke ();
+  else if (!strcmp (argv[1], "bpathstroke"))
+    test_bpath_stroke ();
   else
     usage ();
   return 0;